@@ -0,0 +1,290 @@
+#include "AABBTree.h"
+#include <algorithm>
+#include <cmath>
+
+int AABBTree::allocateNode() {
+    if (freeList == NULL_NODE) {
+        nodes.emplace_back();
+        return static_cast<int>(nodes.size()) - 1;
+    }
+
+    const int node = freeList;
+    freeList = nodes[node].parent;
+    nodes[node] = Node();
+    return node;
+}
+
+void AABBTree::freeNode(int node) {
+    nodes[node].parent = freeList;
+    nodes[node].height = -1;
+    freeList = node;
+}
+
+void AABBTree::clear() {
+    nodes.clear();
+    root = NULL_NODE;
+    freeList = NULL_NODE;
+    proxyCount = 0;
+}
+
+int AABBTree::createProxy(const AABB& box, int userData) {
+    const int proxy = allocateNode();
+    nodes[proxy].box = AABB(box.min - glm::vec3(margin), box.max + glm::vec3(margin));
+    nodes[proxy].userData = userData;
+    nodes[proxy].height = 0;
+
+    insertLeaf(proxy);
+    proxyCount++;
+    return proxy;
+}
+
+void AABBTree::destroyProxy(int proxy) {
+    removeLeaf(proxy);
+    freeNode(proxy);
+    proxyCount--;
+}
+
+bool AABBTree::moveProxy(int proxy, const AABB& box) {
+    if (nodes[proxy].box.contains(box)) {
+        return false;
+    }
+
+    removeLeaf(proxy);
+    nodes[proxy].box = AABB(box.min - glm::vec3(margin), box.max + glm::vec3(margin));
+    insertLeaf(proxy);
+    return true;
+}
+
+void AABBTree::insertLeaf(int leaf) {
+    if (root == NULL_NODE) {
+        root = leaf;
+        nodes[root].parent = NULL_NODE;
+        return;
+    }
+
+    // Walk down towards the cheapest sibling: creating a parent costs the area of the merged box,
+    // and every ancestor grows by the difference
+    const AABB leafBox = nodes[leaf].box;
+    int index = root;
+    while (!nodes[index].isLeaf()) {
+        const Node& node = nodes[index];
+        const float area = node.box.area();
+        const float combinedArea = AABB::merge(node.box, leafBox).area();
+
+        const float cost = 2.0f * combinedArea;
+        const float inheritanceCost = 2.0f * (combinedArea - area);
+
+        auto descendCost = [&](int child) {
+            const AABB merged = AABB::merge(leafBox, nodes[child].box);
+            if (nodes[child].isLeaf()) {
+                return merged.area() + inheritanceCost;
+            }
+            return merged.area() - nodes[child].box.area() + inheritanceCost;
+        };
+        const float cost1 = descendCost(node.child1);
+        const float cost2 = descendCost(node.child2);
+
+        if (cost < cost1 && cost < cost2) break;
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+
+    const int sibling = index;
+    const int oldParent = nodes[sibling].parent;
+    const int newParent = allocateNode();
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].box = AABB::merge(leafBox, nodes[sibling].box);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].child1 = sibling;
+    nodes[newParent].child2 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent == NULL_NODE) {
+        root = newParent;
+    }
+    else if (nodes[oldParent].child1 == sibling) {
+        nodes[oldParent].child1 = newParent;
+    }
+    else {
+        nodes[oldParent].child2 = newParent;
+    }
+
+    refitUpwards(nodes[leaf].parent);
+}
+
+void AABBTree::removeLeaf(int leaf) {
+    if (leaf == root) {
+        root = NULL_NODE;
+        return;
+    }
+
+    const int parent = nodes[leaf].parent;
+    const int grandParent = nodes[parent].parent;
+    const int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+    // The sibling takes the place of the parent
+    if (grandParent == NULL_NODE) {
+        root = sibling;
+        nodes[sibling].parent = NULL_NODE;
+    }
+    else {
+        if (nodes[grandParent].child1 == parent) {
+            nodes[grandParent].child1 = sibling;
+        }
+        else {
+            nodes[grandParent].child2 = sibling;
+        }
+        nodes[sibling].parent = grandParent;
+    }
+    freeNode(parent);
+
+    if (grandParent != NULL_NODE) {
+        refitUpwards(grandParent);
+    }
+}
+
+// Rebalances every ancestor and recomputes their boxes and heights
+void AABBTree::refitUpwards(int node) {
+    while (node != NULL_NODE) {
+        node = balance(node);
+
+        const int child1 = nodes[node].child1;
+        const int child2 = nodes[node].child2;
+        nodes[node].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+        nodes[node].box = AABB::merge(nodes[child1].box, nodes[child2].box);
+
+        node = nodes[node].parent;
+    }
+}
+
+// Promotes the deeper grandchild when the two subtrees differ by more than one level.
+// Returns the node now sitting where 'a' was.
+int AABBTree::balance(int a) {
+    Node& nodeA = nodes[a];
+    if (nodeA.isLeaf() || nodeA.height < 2) {
+        return a;
+    }
+
+    const int b = nodeA.child1;
+    const int c = nodeA.child2;
+    const int difference = nodes[c].height - nodes[b].height;
+
+    // Rotate the heavier child up, 'heavy' replaces 'a' and 'a' takes one of its children
+    auto rotate = [&](int heavy, int light, bool heavyIsChild2) {
+        Node& nodeHeavy = nodes[heavy];
+        const int f = nodeHeavy.child1;
+        const int g = nodeHeavy.child2;
+
+        nodeHeavy.child1 = a;
+        nodeHeavy.parent = nodes[a].parent;
+        nodes[a].parent = heavy;
+
+        if (nodeHeavy.parent == NULL_NODE) {
+            root = heavy;
+        }
+        else if (nodes[nodeHeavy.parent].child1 == a) {
+            nodes[nodeHeavy.parent].child1 = heavy;
+        }
+        else {
+            nodes[nodeHeavy.parent].child2 = heavy;
+        }
+
+        // The taller grandchild stays with 'heavy', the other one moves under 'a'
+        const bool keepF = nodes[f].height > nodes[g].height;
+        const int keep = keepF ? f : g;
+        const int give = keepF ? g : f;
+
+        nodeHeavy.child2 = keep;
+        if (heavyIsChild2) {
+            nodes[a].child2 = give;
+        }
+        else {
+            nodes[a].child1 = give;
+        }
+        nodes[give].parent = a;
+
+        nodes[a].box = AABB::merge(nodes[light].box, nodes[give].box);
+        nodes[a].height = 1 + std::max(nodes[light].height, nodes[give].height);
+        nodeHeavy.box = AABB::merge(nodes[a].box, nodes[keep].box);
+        nodeHeavy.height = 1 + std::max(nodes[a].height, nodes[keep].height);
+        return heavy;
+    };
+
+    if (difference > 1) {
+        return rotate(c, b, true);
+    }
+    if (difference < -1) {
+        return rotate(b, c, false);
+    }
+    return a;
+}
+
+void AABBTree::rebuild() {
+    std::vector<int> leaves;
+    leaves.reserve(proxyCount);
+
+    // Leaves keep their index (it is the proxy id), internal nodes are all released
+    for (int i = 0; i < static_cast<int>(nodes.size()); ++i) {
+        if (nodes[i].height < 0) continue;
+
+        if (nodes[i].isLeaf()) {
+            nodes[i].parent = NULL_NODE;
+            leaves.push_back(i);
+        }
+        else {
+            freeNode(i);
+        }
+    }
+
+    root = leaves.empty() ? NULL_NODE : buildRange(leaves, 0, leaves.size());
+    if (root != NULL_NODE) {
+        nodes[root].parent = NULL_NODE;
+    }
+}
+
+int AABBTree::buildRange(std::vector<int>& leaves, size_t begin, size_t end) {
+    if (end - begin == 1) {
+        return leaves[begin];
+    }
+
+    AABB centers(nodes[leaves[begin]].box.center(), nodes[leaves[begin]].box.center());
+    for (size_t i = begin + 1; i < end; ++i) {
+        const glm::vec3 center = nodes[leaves[i]].box.center();
+        centers = AABB::merge(centers, AABB(center, center));
+    }
+
+    const glm::vec3 spread = centers.max - centers.min;
+    const int axis = spread.x > spread.y ? (spread.x > spread.z ? 0 : 2) : (spread.y > spread.z ? 1 : 2);
+
+    const size_t middle = begin + (end - begin) / 2;
+    std::nth_element(leaves.begin() + begin, leaves.begin() + middle, leaves.begin() + end, [&](int a, int b) {
+        return nodes[a].box.min[axis] + nodes[a].box.max[axis] < nodes[b].box.min[axis] + nodes[b].box.max[axis];
+    });
+
+    const int child1 = buildRange(leaves, begin, middle);
+    const int child2 = buildRange(leaves, middle, end);
+
+    const int parent = allocateNode();
+    nodes[parent].child1 = child1;
+    nodes[parent].child2 = child2;
+    nodes[parent].box = AABB::merge(nodes[child1].box, nodes[child2].box);
+    nodes[parent].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+    nodes[child1].parent = parent;
+    nodes[child2].parent = parent;
+    return parent;
+}
+
+float AABBTree::getAreaRatio() const {
+    if (root == NULL_NODE) return 0.0f;
+
+    const float rootArea = nodes[root].box.area();
+    if (rootArea <= 0.0f) return 0.0f;
+
+    float totalArea = 0.0f;
+    for (const Node& node : nodes) {
+        if (node.height > 0) {
+            totalArea += node.box.area();
+        }
+    }
+    return totalArea / rootArea;
+}
@@ -0,0 +1,201 @@
+#ifndef AABBTREE_H
+#define AABBTREE_H
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "Bounds.h"
+
+// Dynamic bounding volume hierarchy over world boxes.
+// Leaves store a box fattened by 'margin', so small movements inside the fat box need no tree update;
+// a leaf is only reinserted when its object leaves the fat box. Inserts pick the sibling with the lowest
+// surface area cost and AVL rotations keep the tree balanced, rebuild() recreates it from scratch
+// when many reinsertions have made it worse than a fresh build.
+class AABBTree {
+public:
+    static const int NULL_NODE = -1;
+
+    explicit AABBTree(float margin = 0.1f) : margin(margin) {}
+
+    int createProxy(const AABB& box, int userData);
+    void destroyProxy(int proxy);
+    // Returns true when the proxy had to be reinserted
+    bool moveProxy(int proxy, const AABB& box);
+    void clear();
+
+    // Top-down rebuild of every leaf, splitting at the median of the longest axis
+    void rebuild();
+
+    int getUserData(int proxy) const { return nodes[proxy].userData; }
+    const AABB& getFatBox(int proxy) const { return nodes[proxy].box; }
+    size_t getProxyCount() const { return proxyCount; }
+    int getHeight() const { return root == NULL_NODE ? 0 : nodes[root].height; }
+    // Sum of the node areas over the root area, lower means tighter
+    float getAreaRatio() const;
+
+    // visit(proxy, fullyInside): leaves whose fat box intersects the frustum. Subtrees fully inside
+    // are reported without testing them, fullyInside tells the caller an exact test is not needed.
+    template <typename Function>
+    void queryFrustum(const Frustum& frustum, Function&& visit) const;
+
+    // visit(proxy) for every leaf whose fat box overlaps the box
+    template <typename Function>
+    void queryBox(const AABB& box, Function&& visit) const;
+
+    // visit(proxy, entry) for every leaf the ray crosses, closer subtrees first. The callback returns
+    // the distance to keep searching within, so returning the closest hit so far prunes the rest.
+    template <typename Function>
+    void raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Function&& visit) const;
+
+private:
+    struct Node {
+        AABB box;
+        int parent = NULL_NODE;     // Next free node while in the free list
+        int child1 = NULL_NODE;
+        int child2 = NULL_NODE;
+        int height = 0;             // 0 for leaves, -1 for free nodes
+        int userData = -1;
+
+        bool isLeaf() const { return child1 == NULL_NODE; }
+    };
+
+    std::vector<Node> nodes;
+    int root = NULL_NODE;
+    int freeList = NULL_NODE;
+    size_t proxyCount = 0;
+    float margin;
+
+    // Scratch stack shared by the queries, the tree is only queried from one thread at a time
+    mutable std::vector<int> stack;
+
+    int allocateNode();
+    void freeNode(int node);
+    void insertLeaf(int leaf);
+    void removeLeaf(int leaf);
+    int balance(int node);
+    void refitUpwards(int node);
+    int buildRange(std::vector<int>& leaves, size_t begin, size_t end);
+};
+
+template <typename Function>
+void AABBTree::queryFrustum(const Frustum& frustum, Function&& visit) const {
+    if (root == NULL_NODE) return;
+
+    // Each entry carries the planes still worth testing for that subtree
+    struct Entry { int node; uint32_t planeMask; };
+    std::vector<Entry> entries;
+    entries.reserve(64);
+    entries.push_back({ root, Frustum::ALL_PLANES });
+
+    while (!entries.empty()) {
+        const Entry entry = entries.back();
+        entries.pop_back();
+        const Node& node = nodes[entry.node];
+
+        uint32_t planeMask = entry.planeMask;
+        const Frustum::Result result = frustum.classify(node.box, planeMask);
+        if (result == Frustum::Result::Outside) continue;
+
+        if (result == Frustum::Result::Inside) {
+            // Everything below is visible, collect the leaves without more plane tests
+            stack.clear();
+            stack.push_back(entry.node);
+            while (!stack.empty()) {
+                const int current = stack.back();
+                stack.pop_back();
+                if (nodes[current].isLeaf()) {
+                    visit(current, true);
+                }
+                else {
+                    stack.push_back(nodes[current].child1);
+                    stack.push_back(nodes[current].child2);
+                }
+            }
+        }
+        else if (node.isLeaf()) {
+            visit(entry.node, false);
+        }
+        else {
+            entries.push_back({ node.child1, planeMask });
+            entries.push_back({ node.child2, planeMask });
+        }
+    }
+}
+
+template <typename Function>
+void AABBTree::queryBox(const AABB& box, Function&& visit) const {
+    if (root == NULL_NODE) return;
+
+    stack.clear();
+    stack.push_back(root);
+    while (!stack.empty()) {
+        const int current = stack.back();
+        stack.pop_back();
+
+        const Node& node = nodes[current];
+        if (!node.box.overlaps(box)) continue;
+
+        if (node.isLeaf()) {
+            visit(current);
+        }
+        else {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+template <typename Function>
+void AABBTree::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Function&& visit) const {
+    if (root == NULL_NODE) return;
+
+    const float infinity = std::numeric_limits<float>::infinity();
+    const glm::vec3 invDirection(direction.x != 0.0f ? 1.0f / direction.x : infinity,
+        direction.y != 0.0f ? 1.0f / direction.y : infinity,
+        direction.z != 0.0f ? 1.0f / direction.z : infinity);
+
+    struct Entry { int node; float entry; };
+    std::vector<Entry> entries;
+    entries.reserve(64);
+
+    float entry = 0.0f;
+    if (!nodes[root].box.intersectsRay(origin, invDirection, maxDistance, entry)) return;
+    entries.push_back({ root, entry });
+
+    while (!entries.empty()) {
+        const Entry current = entries.back();
+        entries.pop_back();
+        // A hit found since this node was pushed may already be closer
+        if (current.entry > maxDistance) continue;
+
+        const Node& node = nodes[current.node];
+        if (node.isLeaf()) {
+            maxDistance = visit(current.node, current.entry);
+            continue;
+        }
+
+        float entry1 = 0.0f, entry2 = 0.0f;
+        const bool hit1 = nodes[node.child1].box.intersectsRay(origin, invDirection, maxDistance, entry1);
+        const bool hit2 = nodes[node.child2].box.intersectsRay(origin, invDirection, maxDistance, entry2);
+
+        // The closer child goes on top of the stack
+        if (hit1 && hit2) {
+            if (entry1 <= entry2) {
+                entries.push_back({ node.child2, entry2 });
+                entries.push_back({ node.child1, entry1 });
+            }
+            else {
+                entries.push_back({ node.child1, entry1 });
+                entries.push_back({ node.child2, entry2 });
+            }
+        }
+        else if (hit1) {
+            entries.push_back({ node.child1, entry1 });
+        }
+        else if (hit2) {
+            entries.push_back({ node.child2, entry2 });
+        }
+    }
+}
+
+#endif // AABBTREE_H
@@ -0,0 +1,736 @@
+#include "Benchmark.h"
+#include "TransformStore.h"
+#include "TransformKernels.h"
+#include "ObjectID.h"
+#include "GameObject.h"
+#include "ConsoleWindow.h"
+#include "JobSystem.h"
+#include "CullingSystem.h"
+#include "AABBTree.h"
+#include "LooseOctree.h"
+#include "MeshBVH.h"
+#include "RayKernels.h"
+#include "Ray.h"
+#include <imgui.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cmath>
+#include <limits>
+#include <glm/gtc/matrix_transform.hpp>
+#include <sstream>
+#include <unordered_map>
+
+Benchmark Benchmark::benchmark;
+
+namespace {
+    using benchClock = std::chrono::high_resolution_clock;
+
+    // Runs the function until enough time has passed to get a stable average, returns ms per call
+    template <typename Function>
+    double timeAverage(Function&& function, double minimumMs = 200.0) {
+        function();
+
+        int iterations = 0;
+        double elapsedMs = 0.0;
+        auto start = benchClock::now();
+        while (elapsedMs < minimumMs || iterations < 5) {
+            function();
+            iterations++;
+            elapsedMs = std::chrono::duration<double, std::milli>(benchClock::now() - start).count();
+        }
+        return elapsedMs / iterations;
+    }
+
+    // Random forest where every node picks a parent among the few nodes created before it
+    void buildRandomHierarchy(TransformStore& store, int nodeCount, std::mt19937& rng) {
+        std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+        std::uniform_real_distribution<float> angle(-180.0f, 180.0f);
+        std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+        std::uniform_int_distribution<int> parentOffset(1, 8);
+        std::uniform_int_distribution<int> rootChance(0, 9);
+
+        store.clear();
+        for (int i = 0; i < nodeCount; ++i) {
+            int index = store.add();
+            store.setLocal(index,
+                glm::vec3(position(rng), position(rng), position(rng)),
+                TransformStore::eulerToQuat(glm::vec3(angle(rng), angle(rng), angle(rng))),
+                glm::vec3(scale(rng)));
+
+            if (i > 0 && rootChance(rng) != 0) {
+                store.setParent(index, std::max(0, i - parentOffset(rng)));
+            }
+        }
+    }
+
+    // Per-object random_device + mt19937 + stringstream, how object IDs used to be generated
+    std::string legacyUUID() {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<> dis(0, 15);
+
+        std::stringstream ss;
+        ss << std::hex;
+        for (int i = 0; i < 32; i++) {
+            if (i == 8 || i == 12 || i == 16 || i == 20) ss << "-";
+            ss << dis(gen);
+        }
+        return ss.str();
+    }
+}
+
+void Benchmark::addResult(const std::string& result) {
+    results.push_back(result);
+    console.addLog(result);
+}
+
+void Benchmark::renderPanel() {
+    if (ImGui::Button("Transform update")) {
+        runTransformUpdate();
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button("TRS compose")) {
+        runTransformCompose();
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button("Object IDs")) {
+        runObjectIDGeneration();
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button("Object churn")) {
+        runObjectChurn();
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button("Job scaling")) {
+        runJobScaling();
+    }
+
+    if (ImGui::Button("Frustum culling")) {
+        runFrustumCulling();
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button("Spatial queries")) {
+        runSpatialQueries();
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button("Mesh picking")) {
+        runMeshPicking();
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button("Ray kernels")) {
+        runRayKernels();
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button("Clear results")) {
+        results.clear();
+    }
+
+    for (const std::string& result : results) {
+        ImGui::TextUnformatted(result.c_str());
+    }
+}
+
+// World-matrix update throughput of the transform store at several scene sizes
+void Benchmark::runTransformUpdate() {
+    std::mt19937 rng(1234);
+    const int nodeCounts[] = { 1000, 10000, 100000 };
+
+    for (int nodeCount : nodeCounts) {
+        TransformStore store;
+        buildRandomHierarchy(store, nodeCount, rng);
+
+        auto sortStart = benchClock::now();
+        store.sortHierarchy();
+        double sortMs = std::chrono::duration<double, std::milli>(benchClock::now() - sortStart).count();
+
+        double updateMs = timeAverage([&store]() { store.updateWorldMatrices(); });
+        double nodesPerSecond = nodeCount / (updateMs / 1000.0);
+
+        char buffer[160];
+        snprintf(buffer, sizeof(buffer), "Transform update %6d nodes: %.3f ms (%.1f M nodes/s), sort %.3f ms",
+            nodeCount, updateMs, nodesPerSecond / 1.0e6, sortMs);
+        addResult(buffer);
+    }
+}
+
+// Local matrix composition for 100k nodes: the old Euler glm path against every kernel backend
+void Benchmark::runTransformCompose() {
+    const size_t count = 100000;
+    std::mt19937 rng(4321);
+    std::uniform_real_distribution<float> value(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> angle(-180.0f, 180.0f);
+
+    std::vector<glm::vec3> positions(count), eulers(count), scales(count);
+    std::vector<glm::quat> rotations(count);
+    std::vector<glm::mat4> glmMatrices(count), matrices(count);
+    for (size_t i = 0; i < count; ++i) {
+        positions[i] = glm::vec3(value(rng), value(rng), value(rng));
+        eulers[i] = glm::vec3(angle(rng), angle(rng), angle(rng));
+        scales[i] = glm::vec3(value(rng), value(rng), value(rng));
+        rotations[i] = TransformStore::eulerToQuat(eulers[i]);
+    }
+
+    double glmMs = timeAverage([&]() {
+        for (size_t i = 0; i < count; ++i) {
+            glm::mat4 transform = glm::translate(glm::mat4(1.0f), positions[i]);
+            transform = glm::rotate(transform, glm::radians(eulers[i].x), glm::vec3(1, 0, 0));
+            transform = glm::rotate(transform, glm::radians(eulers[i].y), glm::vec3(0, 1, 0));
+            transform = glm::rotate(transform, glm::radians(eulers[i].z), glm::vec3(0, 0, 1));
+            glmMatrices[i] = glm::scale(transform, scales[i]);
+        }
+    });
+
+    char buffer[192];
+    snprintf(buffer, sizeof(buffer), "TRS compose %zu: glm euler %.3f ms", count, glmMs);
+    addResult(buffer);
+
+    const TransformKernels::Backend previous = TransformKernels::getBackend();
+    const TransformKernels::Backend backends[] = { TransformKernels::Backend::Scalar, TransformKernels::Backend::SSE, TransformKernels::Backend::AVX2 };
+
+    for (TransformKernels::Backend backend : backends) {
+        if (!CpuFeatures::isSupported(backend)) continue;
+        TransformKernels::setBackend(backend);
+
+        double kernelMs = timeAverage([&]() {
+            TransformKernels::composeTRS(positions.data(), rotations.data(), scales.data(), matrices.data(), count);
+        });
+
+        // Largest difference against the glm result, to catch a broken kernel
+        float maxError = 0.0f;
+        for (size_t i = 0; i < count; ++i) {
+            for (int column = 0; column < 4; ++column) {
+                for (int row = 0; row < 4; ++row) {
+                    maxError = std::max(maxError, std::fabs(matrices[i][column][row] - glmMatrices[i][column][row]));
+                }
+            }
+        }
+
+        // A known rotation against glm's own quaternion to matrix, full SIMD batches so every path runs.
+        // Catches the kernels reading the quaternion's components in the wrong memory order.
+        const glm::quat known = glm::angleAxis(glm::radians(60.0f), glm::normalize(glm::vec3(1.0f, 2.0f, 3.0f)));
+        const glm::mat4 expected = glm::mat4_cast(known);
+        glm::vec3 knownPositions[8], knownScales[8];
+        glm::quat knownRotations[8];
+        glm::mat4 knownMatrices[8];
+        for (int i = 0; i < 8; ++i) {
+            knownPositions[i] = glm::vec3(0.0f);
+            knownScales[i] = glm::vec3(1.0f);
+            knownRotations[i] = known;
+        }
+        TransformKernels::composeTRS(knownPositions, knownRotations, knownScales, knownMatrices, 8);
+        float rotationError = 0.0f;
+        for (int i = 0; i < 8; ++i) {
+            for (int column = 0; column < 4; ++column) {
+                for (int row = 0; row < 4; ++row) {
+                    rotationError = std::max(rotationError, std::fabs(knownMatrices[i][column][row] - expected[column][row]));
+                }
+            }
+        }
+
+        snprintf(buffer, sizeof(buffer), "TRS compose %zu: %s %.3f ms (%.1fx glm), max error %.2e, known rotation %s",
+            count, CpuFeatures::getBackendName(backend), kernelMs, glmMs / kernelMs, maxError, rotationError < 1.0e-5f ? "ok" : "WRONG");
+        addResult(buffer);
+    }
+    TransformKernels::setBackend(previous);
+}
+
+// Cost of creating and indexing 100k object IDs, compared with the old string UUIDs
+void Benchmark::runObjectIDGeneration() {
+    const int count = 100000;
+
+    auto start = benchClock::now();
+    std::unordered_map<ObjectID, int> index;
+    index.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        index[ObjectID::generate()] = i;
+    }
+    double binaryMs = std::chrono::duration<double, std::milli>(benchClock::now() - start).count();
+
+    start = benchClock::now();
+    std::unordered_map<std::string, int> legacyIndex;
+    legacyIndex.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        legacyIndex[legacyUUID()] = i;
+    }
+    double legacyMs = std::chrono::duration<double, std::milli>(benchClock::now() - start).count();
+
+    char buffer[160];
+    snprintf(buffer, sizeof(buffer), "Object IDs %d: binary %.2f ms, string %.2f ms (%.1fx)",
+        count, binaryMs, legacyMs, legacyMs / binaryMs);
+    addResult(buffer);
+}
+
+// Creates and destroys objects every simulated frame, the pool should stop growing after the first one
+void Benchmark::runObjectChurn() {
+    const int frames = 20;
+    const int objectsPerFrame = 2000;
+    GameObjectPool& pool = GameObjectPool::pool;
+    MeshData emptyMesh;
+
+    std::vector<GameObject*> created;
+    created.reserve(objectsPerFrame);
+
+    size_t capacityAfterWarmup = 0;
+    auto start = benchClock::now();
+    for (int frame = 0; frame < frames; ++frame) {
+        for (int i = 0; i < objectsPerFrame; ++i) {
+            created.push_back(pool.create("Churn", emptyMesh, 0));
+        }
+        for (GameObject* obj : created) {
+            pool.destroy(obj);
+        }
+        created.clear();
+
+        pool.flush();
+        TransformStore::transformStore.updateWorldMatrices();
+
+        if (frame == 0) {
+            capacityAfterWarmup = pool.capacity();
+        }
+    }
+    double elapsedMs = std::chrono::duration<double, std::milli>(benchClock::now() - start).count();
+
+    char buffer[192];
+    snprintf(buffer, sizeof(buffer), "Object churn %d/frame: %.3f ms per frame, pool slots %zu -> %zu after %d frames",
+        objectsPerFrame, elapsedMs / frames, capacityAfterWarmup, pool.capacity(), frames);
+    addResult(buffer);
+}
+
+// Throughput of parallelFor from 1 to N threads, on a compute-bound loop and on batched TRS composition
+void Benchmark::runJobScaling() {
+    JobSystem& jobs = JobSystem::jobSystem;
+    const unsigned previousThreads = jobs.getThreadCount();
+    const unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    const size_t computeCount = 1 << 20;
+    std::vector<float> computeResults(computeCount);
+
+    const size_t nodeCount = 1000000;
+    std::vector<glm::vec3> positions(nodeCount, glm::vec3(1.0f, 2.0f, 3.0f));
+    std::vector<glm::quat> rotations(nodeCount, TransformStore::eulerToQuat(glm::vec3(30.0f, 45.0f, 60.0f)));
+    std::vector<glm::vec3> scales(nodeCount, glm::vec3(2.0f));
+    std::vector<glm::mat4> matrices(nodeCount);
+
+    // Powers of two, then every hardware thread
+    std::vector<unsigned> threadCounts;
+    for (unsigned threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    double computeBaseMs = 0.0;
+    double composeBaseMs = 0.0;
+    for (unsigned threads : threadCounts) {
+        jobs.shutdown();
+        jobs.init(threads);
+
+        double computeMs = timeAverage([&]() {
+            jobs.parallelFor(computeCount, 1024, [&computeResults](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    float value = static_cast<float>(i);
+                    for (int step = 0; step < 32; ++step) {
+                        value = std::sin(value) * 0.5f + std::sqrt(std::fabs(value) + 1.0f);
+                    }
+                    computeResults[i] = value;
+                }
+            });
+        });
+
+        double composeMs = timeAverage([&]() {
+            jobs.parallelFor(nodeCount, 4096, [&](size_t begin, size_t end) {
+                TransformKernels::composeTRS(&positions[begin], &rotations[begin], &scales[begin], &matrices[begin], end - begin);
+            });
+        });
+
+        if (threads == 1) {
+            computeBaseMs = computeMs;
+            composeBaseMs = composeMs;
+        }
+
+        char buffer[192];
+        snprintf(buffer, sizeof(buffer), "Job scaling %2u threads: compute %.2f ms (%.2fx, %.1f M items/s), TRS 1M %.2f ms (%.2fx)",
+            threads, computeMs, computeBaseMs / computeMs, computeCount / (computeMs * 1000.0), composeMs, composeBaseMs / composeMs);
+        addResult(buffer);
+    }
+
+    jobs.shutdown();
+    jobs.init(previousThreads);
+}
+
+// Batched frustum test on 100k random world boxes, against the old per-corner projection of every box
+void Benchmark::runFrustumCulling() {
+    const size_t count = 100000;
+    std::mt19937 rng(777);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> size(0.1f, 5.0f);
+
+    std::vector<glm::vec3> centers(count), extents(count);
+    for (size_t i = 0; i < count; ++i) {
+        centers[i] = glm::vec3(position(rng), position(rng), position(rng));
+        extents[i] = glm::vec3(size(rng), size(rng), size(rng));
+    }
+
+    const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 5.0f, 20.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const Frustum frustum = Frustum::fromMatrix(projection * view);
+
+    // Separate instance, the renderer's results stay untouched
+    CullingSystem culling;
+    culling.setBounds(centers, extents);
+
+    double batchedMs = timeAverage([&]() { culling.cull(frustum); });
+
+    std::vector<uint64_t> reference;
+    culling.cullScalar(frustum, reference);
+    const bool matches = reference == culling.getVisibility();
+
+    // Old test: both matrices rebuilt for every corner, a box is kept when one corner lands in NDC
+    size_t legacyVisible = 0;
+    double legacyMs = timeAverage([&]() {
+        legacyVisible = 0;
+        for (size_t i = 0; i < count; ++i) {
+            for (int corner = 0; corner < 8; ++corner) {
+                const glm::vec3 offset((corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f, (corner & 4) ? 1.0f : -1.0f);
+                const glm::mat4 legacyProjection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+                const glm::mat4 legacyView = glm::lookAt(glm::vec3(0.0f, 5.0f, 20.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+                const glm::vec4 clip = legacyProjection * legacyView * glm::vec4(centers[i] + offset * extents[i], 1.0f);
+                const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+                if (std::fabs(ndc.x) <= 1.0f && std::fabs(ndc.y) <= 1.0f && std::fabs(ndc.z) <= 1.0f) {
+                    legacyVisible++;
+                    break;
+                }
+            }
+        }
+    }, 50.0);
+
+    char buffer[224];
+    snprintf(buffer, sizeof(buffer), "Frustum culling %zu boxes: batched %.3f ms, per-corner %.3f ms (%.0fx), visible %zu vs %zu, %s",
+        count, batchedMs, legacyMs, legacyMs / batchedMs, culling.getStats().visible, legacyVisible,
+        matches ? "matches scalar" : "MISMATCH with scalar");
+    addResult(buffer);
+}
+
+// Linear scans against the AABB tree for frustum, ray and box queries, on a level spread over 1km x 1km.
+// The same boxes also go through the static octree for its build and frustum costs.
+void Benchmark::runSpatialQueries() {
+    const size_t objectCounts[] = { 1000, 10000, 50000 };
+    const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 10.0f, 0.0f), glm::vec3(50.0f, 0.0f, 50.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const Frustum frustum = Frustum::fromMatrix(projection * view);
+
+    for (size_t count : objectCounts) {
+        std::mt19937 rng(99);
+        std::uniform_real_distribution<float> ground(-500.0f, 500.0f);
+        std::uniform_real_distribution<float> height(0.0f, 20.0f);
+        std::uniform_real_distribution<float> size(0.5f, 4.0f);
+
+        std::vector<glm::vec3> centers(count), extents(count);
+        std::vector<AABB> boxes(count);
+        for (size_t i = 0; i < count; ++i) {
+            centers[i] = glm::vec3(ground(rng), height(rng), ground(rng));
+            extents[i] = glm::vec3(size(rng), size(rng), size(rng));
+            boxes[i] = AABB::fromCenterExtents(centers[i], extents[i]);
+        }
+
+        auto buildStart = benchClock::now();
+        AABBTree tree;
+        for (size_t i = 0; i < count; ++i) {
+            tree.createProxy(boxes[i], static_cast<int>(i));
+        }
+        double insertMs = std::chrono::duration<double, std::milli>(benchClock::now() - buildStart).count();
+        buildStart = benchClock::now();
+        tree.rebuild();
+        double rebuildMs = std::chrono::duration<double, std::milli>(benchClock::now() - buildStart).count();
+
+        // Frustum: SIMD scan of every box against the tree walk with exact leaf tests
+        CullingSystem linear;
+        linear.setBounds(centers, extents);
+        double frustumLinearMs = timeAverage([&]() { linear.cull(frustum); }, 50.0);
+
+        size_t treeVisible = 0;
+        double frustumTreeMs = timeAverage([&]() {
+            treeVisible = 0;
+            tree.queryFrustum(frustum, [&](int leaf, bool fullyInside) {
+                const size_t i = static_cast<size_t>(tree.getUserData(leaf));
+                if (fullyInside || frustum.intersectsBox(centers[i], extents[i])) {
+                    treeVisible++;
+                }
+            });
+        }, 50.0);
+
+        // Rays: closest box along 256 random horizontal rays
+        std::vector<glm::vec3> origins(256), directions(256);
+        std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+        for (size_t r = 0; r < origins.size(); ++r) {
+            const float a = angle(rng);
+            origins[r] = glm::vec3(ground(rng), 5.0f, ground(rng));
+            directions[r] = glm::vec3(std::cos(a), 0.0f, std::sin(a));
+        }
+
+        size_t linearHits = 0;
+        double rayLinearMs = timeAverage([&]() {
+            linearHits = 0;
+            for (size_t r = 0; r < origins.size(); ++r) {
+                const glm::vec3 invDirection = 1.0f / directions[r];
+                float closest = 2000.0f, entry = 0.0f;
+                bool hit = false;
+                for (const AABB& box : boxes) {
+                    if (box.intersectsRay(origins[r], invDirection, closest, entry)) {
+                        closest = entry;
+                        hit = true;
+                    }
+                }
+                linearHits += hit;
+            }
+        }, 50.0);
+
+        size_t treeHits = 0;
+        double rayTreeMs = timeAverage([&]() {
+            treeHits = 0;
+            for (size_t r = 0; r < origins.size(); ++r) {
+                const glm::vec3 invDirection = 1.0f / directions[r];
+                float closest = 2000.0f;
+                bool hit = false;
+                tree.raycast(origins[r], directions[r], closest, [&](int leaf, float) {
+                    float entry = 0.0f;
+                    if (boxes[tree.getUserData(leaf)].intersectsRay(origins[r], invDirection, closest, entry)) {
+                        closest = entry;
+                        hit = true;
+                    }
+                    return closest;
+                });
+                treeHits += hit;
+            }
+        }, 50.0);
+
+        // Box overlap: 256 queries of 20m around random points
+        size_t linearOverlaps = 0;
+        double boxLinearMs = timeAverage([&]() {
+            linearOverlaps = 0;
+            for (size_t q = 0; q < origins.size(); ++q) {
+                const AABB query = AABB::fromCenterExtents(origins[q], glm::vec3(10.0f));
+                for (const AABB& box : boxes) {
+                    linearOverlaps += box.overlaps(query);
+                }
+            }
+        }, 50.0);
+
+        size_t treeOverlaps = 0;
+        double boxTreeMs = timeAverage([&]() {
+            treeOverlaps = 0;
+            for (size_t q = 0; q < origins.size(); ++q) {
+                const AABB query = AABB::fromCenterExtents(origins[q], glm::vec3(10.0f));
+                tree.queryBox(query, [&](int leaf) { treeOverlaps += boxes[tree.getUserData(leaf)].overlaps(query); });
+            }
+        }, 50.0);
+
+        // Static level: bulk octree build and cell by cell frustum query
+        std::vector<LooseOctree::Item> items(count);
+        for (size_t i = 0; i < count; ++i) {
+            items[i].box = boxes[i];
+            items[i].id = static_cast<uint32_t>(i);
+        }
+        LooseOctree octree;
+        buildStart = benchClock::now();
+        octree.build(items);
+        double octreeBuildMs = std::chrono::duration<double, std::milli>(benchClock::now() - buildStart).count();
+
+        std::vector<uint32_t> octreeVisible;
+        size_t visibleCells = 0;
+        double frustumOctreeMs = timeAverage([&]() {
+            octreeVisible.clear();
+            visibleCells = octree.queryFrustum(frustum, octreeVisible);
+        }, 50.0);
+
+        const bool matches = treeVisible == linear.getStats().visible && treeHits == linearHits && treeOverlaps == linearOverlaps;
+
+        char buffer[256];
+        snprintf(buffer, sizeof(buffer), "Spatial %5zu objects: build %.2f ms (+rebuild %.2f ms), height %d", count, insertMs, rebuildMs, tree.getHeight());
+        addResult(buffer);
+        snprintf(buffer, sizeof(buffer), "  frustum linear %.3f ms / tree %.3f ms, 256 rays %.3f / %.3f ms, 256 boxes %.3f / %.3f ms, %s",
+            frustumLinearMs, frustumTreeMs, rayLinearMs, rayTreeMs, boxLinearMs, boxTreeMs, matches ? "results match" : "RESULTS DIFFER");
+        addResult(buffer);
+        snprintf(buffer, sizeof(buffer), "  octree build %.2f ms, depth %d, %zu nodes, frustum %.3f ms, visible %zu in %zu cells",
+            octreeBuildMs, octree.getDepth(), octree.getNodeCount(), frustumOctreeMs, octreeVisible.size(), visibleCells);
+        addResult(buffer);
+    }
+}
+
+// Closest-hit rays against a bumpy terrain mesh: every triangle with Ray::intersectsTriangle against the BVH.
+// The brute force pass only runs a few rays, it takes seconds on the largest mesh.
+void Benchmark::runMeshPicking() {
+    const int gridSizes[] = { 100, 300, 708 };
+
+    for (int grid : gridSizes) {
+        MeshData mesh;
+        const int side = grid + 1;
+        mesh.vertices.reserve(static_cast<size_t>(side) * side * 3);
+        for (int z = 0; z < side; ++z) {
+            for (int x = 0; x < side; ++x) {
+                const float fx = static_cast<float>(x) / grid, fz = static_cast<float>(z) / grid;
+                mesh.vertices.push_back(fx * 100.0f - 50.0f);
+                mesh.vertices.push_back(std::sin(fx * 31.0f) * std::cos(fz * 23.0f) * 3.0f);
+                mesh.vertices.push_back(fz * 100.0f - 50.0f);
+            }
+        }
+        mesh.indices.reserve(static_cast<size_t>(grid) * grid * 6);
+        for (int z = 0; z < grid; ++z) {
+            for (int x = 0; x < grid; ++x) {
+                const uint32_t corner = static_cast<uint32_t>(z * side + x);
+                mesh.indices.insert(mesh.indices.end(), { corner, corner + side, corner + 1, corner + 1, corner + side, corner + side + 1 });
+            }
+        }
+        const size_t triangleCount = mesh.indices.size() / 3;
+
+        const MeshBVH& bvh = MeshBVH::of(mesh);
+
+        // Downward rays from random points above the terrain, slightly tilted like a camera's
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> ground(-45.0f, 45.0f);
+        std::uniform_real_distribution<float> tilt(-0.3f, 0.3f);
+        std::vector<Ray> rays;
+        for (int r = 0; r < 256; ++r) {
+            rays.emplace_back(glm::vec3(ground(rng), 20.0f, ground(rng)), glm::normalize(glm::vec3(tilt(rng), -1.0f, tilt(rng))));
+        }
+
+        // Compared by distance, a ray through a shared edge may report either triangle
+        std::vector<float> bvhDistances(rays.size());
+        double bvhMs = timeAverage([&]() {
+            for (size_t r = 0; r < rays.size(); ++r) {
+                MeshRayHit hit;
+                bvhDistances[r] = bvh.raycast(rays[r].origin, rays[r].direction, std::numeric_limits<float>::max(), hit) ? hit.distance : -1.0f;
+            }
+        }, 50.0);
+
+        const size_t bruteRays = 8;
+        size_t mismatches = 0;
+        const auto bruteStart = benchClock::now();
+        for (size_t r = 0; r < bruteRays; ++r) {
+            float closest = -1.0f;
+            auto vertexAt = [&](uint32_t index) { return glm::vec3(mesh.vertices[index * 3], mesh.vertices[index * 3 + 1], mesh.vertices[index * 3 + 2]); };
+            for (size_t t = 0; t < triangleCount; ++t) {
+                float distance = 0.0f;
+                if (rays[r].intersectsTriangle(vertexAt(mesh.indices[t * 3]), vertexAt(mesh.indices[t * 3 + 1]), vertexAt(mesh.indices[t * 3 + 2]), distance) && (closest < 0.0f || distance < closest)) {
+                    closest = distance;
+                }
+            }
+            mismatches += std::fabs(closest - bvhDistances[r]) > 1e-3f;
+        }
+        const double bruteMs = std::chrono::duration<double, std::milli>(benchClock::now() - bruteStart).count() / bruteRays;
+
+        char buffer[256];
+        snprintf(buffer, sizeof(buffer), "Picking %7zu triangles: BVH build %.1f ms, %zu nodes, depth %d",
+            triangleCount, bvh.getBuildMs(), bvh.getNodeCount(), bvh.getDepth());
+        addResult(buffer);
+        snprintf(buffer, sizeof(buffer), "  per ray: brute force %.3f ms / BVH %.4f ms, %s",
+            bruteMs, bvhMs / rays.size(), mismatches == 0 ? "results match" : "RESULTS DIFFER");
+        addResult(buffer);
+    }
+}
+
+// Ray/triangle throughput of each kernel backend, one ray against many triangles and packets of rays against
+// one triangle. Every backend is checked against the scalar path, also on ranges that don't fill a register.
+void Benchmark::runRayKernels() {
+    const size_t triangleCount = 4096;
+    const size_t rayCount = 512;
+
+    std::mt19937 rng(17);
+    std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+
+    PackedTriangles triangles;
+    triangles.reserve(triangleCount);
+    for (size_t i = 0; i < triangleCount; ++i) {
+        const glm::vec3 corner(position(rng), position(rng), position(rng));
+        triangles.add(corner, corner + glm::vec3(offset(rng), offset(rng), offset(rng)), corner + glm::vec3(offset(rng), offset(rng), offset(rng)));
+    }
+
+    std::vector<glm::vec3> origins(rayCount), directions(rayCount);
+    for (size_t r = 0; r < rayCount; ++r) {
+        origins[r] = glm::vec3(position(rng), position(rng), position(rng)) * 2.0f;
+        directions[r] = glm::vec3(position(rng), position(rng), position(rng)) - origins[r];
+    }
+
+    // Reference results: every triangle, then a range with ragged ends, per ray
+    auto rangeOf = [&](size_t r) { return std::make_pair(r % 7, triangleCount - r % 5); };
+    const RayKernels::Backend previous = RayKernels::getBackend();
+    RayKernels::setBackend(RayKernels::Backend::Scalar);
+
+    std::vector<TriangleHit> reference(rayCount), referenceRange(rayCount);
+    std::vector<bool> referenceFound(rayCount), referenceRangeFound(rayCount);
+    for (size_t r = 0; r < rayCount; ++r) {
+        float maxDistance = std::numeric_limits<float>::max();
+        referenceFound[r] = RayKernels::intersectClosest(triangles, 0, triangleCount, origins[r], directions[r], maxDistance, reference[r]);
+        maxDistance = std::numeric_limits<float>::max();
+        referenceRangeFound[r] = RayKernels::intersectClosest(triangles, rangeOf(r).first, rangeOf(r).second, origins[r], directions[r], maxDistance, referenceRange[r]);
+    }
+
+    auto sameHit = [](bool foundA, const TriangleHit& a, bool foundB, const TriangleHit& b) {
+        if (foundA != foundB) return false;
+        return !foundA || (a.index == b.index && std::fabs(a.distance - b.distance) <= 1e-5f * std::max(1.0f, a.distance));
+    };
+
+    const RayKernels::Backend backends[] = { RayKernels::Backend::Scalar, RayKernels::Backend::SSE, RayKernels::Backend::AVX2 };
+    const double tests = static_cast<double>(triangleCount) * rayCount;
+    char buffer[192];
+
+    for (RayKernels::Backend backend : backends) {
+        if (!CpuFeatures::isSupported(backend)) continue;
+        RayKernels::setBackend(backend);
+
+        size_t mismatches = 0;
+        for (size_t r = 0; r < rayCount; ++r) {
+            TriangleHit hit;
+            float maxDistance = std::numeric_limits<float>::max();
+            bool found = RayKernels::intersectClosest(triangles, 0, triangleCount, origins[r], directions[r], maxDistance, hit);
+            mismatches += !sameHit(referenceFound[r], reference[r], found, hit);
+
+            maxDistance = std::numeric_limits<float>::max();
+            found = RayKernels::intersectClosest(triangles, rangeOf(r).first, rangeOf(r).second, origins[r], directions[r], maxDistance, hit);
+            mismatches += !sameHit(referenceRangeFound[r], referenceRange[r], found, hit);
+        }
+
+        double singleMs = timeAverage([&]() {
+            for (size_t r = 0; r < rayCount; ++r) {
+                TriangleHit hit;
+                float maxDistance = std::numeric_limits<float>::max();
+                RayKernels::intersectClosest(triangles, 0, triangleCount, origins[r], directions[r], maxDistance, hit);
+            }
+        }, 50.0);
+
+        RayPacket packet;
+        auto runPacket = [&]() {
+            packet.clear();
+            for (size_t r = 0; r < rayCount; ++r) {
+                packet.add(origins[r], directions[r], std::numeric_limits<float>::max());
+            }
+            for (size_t t = 0; t < triangleCount; ++t) {
+                RayKernels::intersectPacket(packet, triangles, t);
+            }
+        };
+        double packetMs = timeAverage(runPacket, 50.0);
+
+        for (size_t r = 0; r < rayCount; ++r) {
+            TriangleHit hit;
+            hit.index = packet.triangle[r];
+            hit.distance = packet.tMax[r];
+            mismatches += !sameHit(referenceFound[r], reference[r], packet.triangle[r] != RayPacket::NO_HIT, hit);
+        }
+
+        snprintf(buffer, sizeof(buffer), "Ray kernels %s: 1 ray x %zu tris %.0f M tests/s, %zu-ray packets %.0f M tests/s, %s",
+            CpuFeatures::getBackendName(backend), triangleCount, tests / singleMs / 1000.0, rayCount, tests / packetMs / 1000.0,
+            mismatches == 0 ? "results match" : "RESULTS DIFFER");
+        addResult(buffer);
+    }
+    RayKernels::setBackend(previous);
+}
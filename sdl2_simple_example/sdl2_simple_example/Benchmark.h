@@ -0,0 +1,30 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <string>
+#include <vector>
+
+// Microbenchmarks for engine systems, launched from the Config window
+class Benchmark {
+public:
+    static Benchmark benchmark;
+
+    void renderPanel();
+
+    void runTransformUpdate();
+    void runTransformCompose();
+    void runObjectIDGeneration();
+    void runObjectChurn();
+    void runJobScaling();
+    void runFrustumCulling();
+    void runSpatialQueries();
+    void runMeshPicking();
+    void runRayKernels();
+
+private:
+    void addResult(const std::string& result);
+
+    std::vector<std::string> results;
+};
+
+#endif // BENCHMARK_H
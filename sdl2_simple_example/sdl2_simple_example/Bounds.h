@@ -0,0 +1,152 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// Axis aligned box in world space
+struct AABB {
+    glm::vec3 min = glm::vec3(0.0f);
+    glm::vec3 max = glm::vec3(0.0f);
+
+    AABB() = default;
+    AABB(const glm::vec3& min, const glm::vec3& max) : min(min), max(max) {}
+
+    static AABB fromCenterExtents(const glm::vec3& center, const glm::vec3& extents) { return AABB(center - extents, center + extents); }
+    static AABB merge(const AABB& a, const AABB& b) { return AABB(glm::min(a.min, b.min), glm::max(a.max, b.max)); }
+
+    glm::vec3 center() const { return (min + max) * 0.5f; }
+    glm::vec3 extents() const { return (max - min) * 0.5f; }
+
+    // Box around this box once transformed: the center goes through the matrix, the extents through |M|
+    AABB transformed(const glm::mat4& m) const {
+        const glm::vec3 e = extents();
+        const glm::vec3 newCenter = glm::vec3(m * glm::vec4(center(), 1.0f));
+        const glm::vec3 newExtents = glm::abs(glm::vec3(m[0])) * e.x + glm::abs(glm::vec3(m[1])) * e.y + glm::abs(glm::vec3(m[2])) * e.z;
+        return fromCenterExtents(newCenter, newExtents);
+    }
+
+    // Half the surface area, enough to compare insertion costs
+    float area() const {
+        const glm::vec3 size = max - min;
+        return size.x * size.y + size.y * size.z + size.z * size.x;
+    }
+
+    bool contains(const AABB& other) const {
+        return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z &&
+            other.max.x <= max.x && other.max.y <= max.y && other.max.z <= max.z;
+    }
+
+    bool overlaps(const AABB& other) const {
+        return min.x <= other.max.x && other.min.x <= max.x &&
+            min.y <= other.max.y && other.min.y <= max.y &&
+            min.z <= other.max.z && other.min.z <= max.z;
+    }
+
+    // Slab test, invDirection is 1 / direction (infinite on zero components).
+    // On a hit 'entry' is where the ray enters the box, 0 when the origin is inside.
+    bool intersectsRay(const glm::vec3& origin, const glm::vec3& invDirection, float maxDistance, float& entry) const {
+        const glm::vec3 t1 = (min - origin) * invDirection;
+        const glm::vec3 t2 = (max - origin) * invDirection;
+        const glm::vec3 tNear = glm::min(t1, t2);
+        const glm::vec3 tFar = glm::max(t1, t2);
+
+        const float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+        const float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+        entry = enter;
+        return enter <= exit;
+    }
+};
+
+// Six planes pointing inwards (xyz = normal, w = distance), a point p is inside when dot(n, p) + w >= 0
+struct Frustum {
+    enum Plane { Left, Right, Bottom, Top, Near, Far, PLANE_COUNT };
+    enum class Result { Outside, Intersecting, Inside };
+    static const uint32_t ALL_PLANES = (1u << PLANE_COUNT) - 1;
+
+    glm::vec4 planes[PLANE_COUNT];
+
+    // Extracts the planes from a projection * view matrix, they come out in world space
+    static Frustum fromMatrix(const glm::mat4& m) {
+        // Gribb-Hartmann: each plane is the last row of the matrix plus or minus one of the others
+        const glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+        const glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+        const glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+        const glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+        Frustum frustum;
+        frustum.planes[Left] = row3 + row0;
+        frustum.planes[Right] = row3 - row0;
+        frustum.planes[Bottom] = row3 + row1;
+        frustum.planes[Top] = row3 - row1;
+        frustum.planes[Near] = row3 + row2;
+        frustum.planes[Far] = row3 - row2;
+
+        for (glm::vec4& plane : frustum.planes) {
+            plane /= glm::length(glm::vec3(plane));
+        }
+        return frustum;
+    }
+
+    // Planes of the part of this frustum's screen between two points in normalized device coordinates,
+    // viewProjection being the matrix the frustum was extracted from
+    static Frustum fromRegion(const glm::mat4& viewProjection, const glm::vec2& ndcMin, const glm::vec2& ndcMax) {
+        // Scales and moves clip space so the region fills it
+        const glm::vec2 size = glm::max(ndcMax - ndcMin, glm::vec2(1e-6f));
+        glm::mat4 region(1.0f);
+        region[0][0] = 2.0f / size.x;
+        region[1][1] = 2.0f / size.y;
+        region[3][0] = -(ndcMin.x + ndcMax.x) / size.x;
+        region[3][1] = -(ndcMin.y + ndcMax.y) / size.y;
+        return fromMatrix(region * viewProjection);
+    }
+
+    // The same planes in the space m maps to this frustum's space, for instance a mesh's own space
+    // with m its world matrix. The planes aren't normalized anymore, which the tests don't need.
+    Frustum transformed(const glm::mat4& m) const {
+        const glm::mat4 transposed = glm::transpose(m);
+        Frustum frustum;
+        for (int i = 0; i < PLANE_COUNT; ++i) {
+            frustum.planes[i] = transposed * planes[i];
+        }
+        return frustum;
+    }
+
+    // A box is outside when it lies completely behind one of the planes
+    bool intersectsBox(const glm::vec3& center, const glm::vec3& extents) const {
+        for (const glm::vec4& plane : planes) {
+            const glm::vec3 normal(plane);
+            const float distance = glm::dot(normal, center) + plane.w;
+            const float radius = glm::dot(glm::abs(normal), extents);
+            if (distance + radius < 0.0f) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Only tests the planes in planeMask, and clears the ones the box is fully in front of,
+    // so the children of a box can skip them
+    Result classify(const AABB& box, uint32_t& planeMask) const {
+        const glm::vec3 center = box.center();
+        const glm::vec3 extents = box.extents();
+
+        for (int i = 0; i < PLANE_COUNT; ++i) {
+            if (!(planeMask & (1u << i))) continue;
+
+            const glm::vec3 normal(planes[i]);
+            const float distance = glm::dot(normal, center) + planes[i].w;
+            const float radius = glm::dot(glm::abs(normal), extents);
+            if (distance + radius < 0.0f) {
+                return Result::Outside;
+            }
+            if (distance - radius >= 0.0f) {
+                planeMask &= ~(1u << i);
+            }
+        }
+        return planeMask == 0 ? Result::Inside : Result::Intersecting;
+    }
+};
+
+#endif // BOUNDS_H
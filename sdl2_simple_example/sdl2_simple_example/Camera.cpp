@@ -1,11 +1,14 @@
 #include "Camera.h"
 #include <GL/glew.h>
 #include <iostream>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
 #include "Variables.h"
 #include "ConsoleWindow.h"
 #include "MyWindow.h"
 #include "Ray.h"
 #include "SceneWindow.h"
+#include "PickingBuffer.h"
 
 Camera camera;
 extern SceneWindow sceneWindow;
@@ -17,7 +20,7 @@ Camera::Camera() : position(0.0f, -1.0f, -10.0f), angleX(0.0f), angleY(0.0f), sp
 void Camera::reset() {
     if (variables->window->selectedObjects.size() == 1) {
         GameObject* obj = variables->window->selectedObjects.front();
-        position = -obj->getPosition();
+        position = -obj->getWorldPosition();
         position.y -= 1;
         position.z -= 10;
         angleX = angleY = 0.0f;
@@ -85,7 +88,8 @@ void Camera::processMouseButtonDown(const SDL_MouseButtonEvent& button) {
     if (button.button == SDL_BUTTON_RIGHT) {
         isRightMouseDragging = true;
     }
-    if (button.button == SDL_BUTTON_LEFT) {
+    // With the ID buffer the Scene window reads the clicked pixel instead
+    if (button.button == SDL_BUTTON_LEFT && !PickingBuffer::pickingBuffer.isActive()) {
         sceneWindow.checkRaycast(button.x, button.y, variables->window->width(), variables->window->height());
     }
 }
@@ -127,11 +131,14 @@ void Camera::move(const Uint8* keyboardState) {
 }
 
 void Camera::applyCameraTransformations() {
-    glRotatef(angleY, 1.0f, 0.0f, 0.0f);
-    glRotatef(angleX, 0.0f, 1.0f, 0.0f);
-    glTranslatef(position.x, position.y, position.z);
-    //glRotatef(objectAngleX, 1.0f, 0.0f, 0.0f);
-    //glRotatef(objectAngleY, 0.0f, 1.0f, 0.0f);
+    glMultMatrixf(glm::value_ptr(getViewMatrix()));
+}
+
+// Pitch, then yaw, then the translation, like the glRotatef/glTranslatef calls it replaces
+glm::mat4 Camera::getViewMatrix() const {
+    glm::mat4 view = glm::rotate(glm::mat4(1.0f), glm::radians(angleY), glm::vec3(1.0f, 0.0f, 0.0f));
+    view = glm::rotate(view, glm::radians(angleX), glm::vec3(0.0f, 1.0f, 0.0f));
+    return glm::translate(view, position);
 }
 
 glm::vec3 Camera::getForwardVector() {
@@ -148,23 +155,4 @@ glm::vec3 Camera::getForwardVector() {
 glm::vec3 Camera::getRightVector() {
     glm::vec3 forward = getForwardVector();
     return glm::normalize(glm::cross(forward, glm::vec3(0.0f, 1.0f, 0.0f)));
-}
-
-bool Camera::isInFrustum(glm::vec3 corners[8]) {
-    for (int i = 0; i < 8; ++i) {
-        const glm::vec3& vertex = corners[i];
-        glm::vec4 clipSpaceVertex = sceneWindow.ProjectionMatrix() * sceneWindow.ViewMatrix() * glm::vec4(vertex, 1.0f);
-
-        glm::vec3 ndcVertex = glm::vec3(clipSpaceVertex) / clipSpaceVertex.w;
-
-        bool inFrustum = ndcVertex.x >= -1.0f && ndcVertex.x <= 1.0f &&
-            ndcVertex.y >= -1.0f && ndcVertex.y <= 1.0f &&
-            ndcVertex.z >= -1.0f && ndcVertex.z <= 1.0f;
-
-        if (inFrustum) {
-            return true;  
-        }
-    }
-
-    return false;
 }
\ No newline at end of file
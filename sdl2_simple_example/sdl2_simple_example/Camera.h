@@ -25,11 +25,11 @@ public:
 	void move(const Uint8* keyboardState);
 
 	void applyCameraTransformations();
+	// Same transform applyCameraTransformations() sends to GL
+	glm::mat4 getViewMatrix() const;
 	glm::vec3 getForwardVector();
 	glm::vec3 getRightVector();
 
-	bool isInFrustum(glm::vec3 corners[8]);
-
 	glm::vec3 position; 
 	float angleX, angleY;
 
@@ -42,13 +42,6 @@ private:
 	float speed;
 	bool shiftPressed, altPressed, isLeftMouseDragging, isRightMouseDragging;
 	int lastMouseX, lastMouseY;
-
-	glm::vec4 leftPlaneFrustrum;
-	glm::vec4 rightPlaneFrustrum;
-	glm::vec4 bottomPlaneFrustrum;
-	glm::vec4 topPlaneFrustrum;
-	glm::vec4 nearPlaneFrustrum;
-	glm::vec4 farPlaneFrustrum;
 };
 
 #endif // CAMERA_H
\ No newline at end of file
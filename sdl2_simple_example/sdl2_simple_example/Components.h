@@ -0,0 +1,66 @@
+#ifndef COMPONENTS_H
+#define COMPONENTS_H
+
+#include <chrono>
+#include <glm/glm.hpp>
+#include <GL/glew.h>
+#include "ECS.h"
+
+struct MeshData;
+class GameObject;
+
+enum class MovementState {
+    Stopped,
+    Running,
+    Paused
+};
+
+// Slot of the entity in the TransformStore, kept up to date when the store reorders itself
+struct TransformComponent {
+    int transformIndex = -1;
+};
+
+struct MeshRendererComponent {
+    const MeshData* mesh = nullptr;
+    GLuint textureID = 0;
+};
+
+struct CameraComponent {
+    float fieldOfView = 45.0f;
+    float nearPlane = 0.1f;
+    float farPlane = 100.0f;
+};
+
+// Back and forth movement along X driven by the simulation
+struct MovementComponent {
+    MovementState state = MovementState::Stopped;
+    int direction = 1;
+    float speed = 3.0f;
+    float elapsedPausedTime = 0.0f;
+    float rangeMin = -5.0f;
+    float rangeMax = 5.0f;
+    std::chrono::time_point<std::chrono::high_resolution_clock> startTime;
+};
+
+// Bounding box of the mesh in local space
+struct BoundsComponent {
+    glm::vec3 localMin = glm::vec3(0.0f);
+    glm::vec3 localMax = glm::vec3(0.0f);
+};
+
+struct HierarchyComponent {
+    Entity parent;
+};
+
+// Link back to the editor object, the editor windows still work with GameObjects
+struct EditorObjectComponent {
+    GameObject* object = nullptr;
+};
+
+// Disabled entities, skipped by the renderer
+struct InactiveTag {};
+
+// Always rasterized into the occlusion buffer while visible, whatever its size on screen
+struct OccluderTag {};
+
+#endif // COMPONENTS_H
@@ -10,6 +10,7 @@ ConsoleWindow::ConsoleWindow() : autoScroll(true) {}
 ConsoleWindow::~ConsoleWindow() {}
 
 void ConsoleWindow::addLog(const std::string& log) {
+    std::lock_guard<std::mutex> guard(logMutex);
     if (std::find(logs.begin(), logs.end(), log) == logs.end()) {
         if (logs.size() >= maxLogs) {
             logs.erase(logs.begin());
@@ -23,6 +24,7 @@ void ConsoleWindow::addLog(const std::string& log) {
 }
 
 void ConsoleWindow::clearLogs() {
+    std::lock_guard<std::mutex> guard(logMutex);
     logs.clear();
     autoScroll = true;
 }
@@ -31,6 +33,8 @@ void ConsoleWindow::displayConsole() {
     ImGui::Begin("Console");
     ImGui::BeginChild("LogChild", ImVec2(0, 0), true, ImGuiWindowFlags_AlwaysVerticalScrollbar);
 
+    std::lock_guard<std::mutex> guard(logMutex);
+
     for (const std::string& log : logs) {
         ImGui::Text("%s", log.c_str());
     }
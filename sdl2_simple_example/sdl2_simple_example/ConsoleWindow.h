@@ -1,6 +1,7 @@
 #ifndef CONSOLE_WINDOW_H
 #define CONSOLE_WINDOW_H
 
+#include <mutex>
 #include <string>
 #include <vector>
 #include <imgui.h>
@@ -19,6 +20,10 @@ public:
 
     std::vector<std::string> logs;
     static const size_t maxLogs = 100;
+
+private:
+    // Jobs on worker threads log too
+    std::mutex logMutex;
 };
 
 extern ConsoleWindow console;
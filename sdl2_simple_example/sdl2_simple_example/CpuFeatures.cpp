@@ -0,0 +1,68 @@
+#include "CpuFeatures.h"
+
+#if defined(CPU_FEATURES_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+    bool detectAVX2() {
+#if defined(CPU_FEATURES_X86) && defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+
+        // The OS must also save the YMM registers on context switches
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#elif defined(CPU_FEATURES_X86) && (defined(__GNUC__) || defined(__clang__))
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    }
+}
+
+bool CpuFeatures::hasAVX2() {
+    static const bool avx2 = detectAVX2();
+    return avx2;
+}
+
+SimdBackend CpuFeatures::bestBackend() {
+#ifdef CPU_FEATURES_X86
+    return hasAVX2() ? SimdBackend::AVX2 : SimdBackend::SSE;
+#else
+    return SimdBackend::Scalar;
+#endif
+}
+
+bool CpuFeatures::isSupported(SimdBackend backend) {
+    switch (backend) {
+    case SimdBackend::Scalar:
+        return true;
+#ifdef CPU_FEATURES_X86
+    case SimdBackend::SSE:
+        return true;
+    case SimdBackend::AVX2:
+        return hasAVX2();
+#endif
+    default:
+        return false;
+    }
+}
+
+const char* CpuFeatures::getBackendName(SimdBackend backend) {
+    switch (backend) {
+    case SimdBackend::SSE:
+        return "SSE";
+    case SimdBackend::AVX2:
+        return "AVX2";
+    default:
+        return "Scalar";
+    }
+}
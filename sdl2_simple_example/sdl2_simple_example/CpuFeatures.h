@@ -0,0 +1,36 @@
+#ifndef CPUFEATURES_H
+#define CPUFEATURES_H
+
+// x86 builds always have SSE2, the SIMD kernels are only compiled there
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define CPU_FEATURES_X86 1
+#include <immintrin.h>
+#endif
+
+// GCC and Clang only emit AVX2 instructions inside functions that ask for them
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+// Instruction sets a family of kernels can be built for
+enum class SimdBackend {
+    Scalar,
+    SSE,
+    AVX2
+};
+
+// What the processor running the program supports, shared by every family of SIMD kernels
+class CpuFeatures {
+public:
+    // Checked once, later calls return the cached answer
+    static bool hasAVX2();
+
+    static SimdBackend bestBackend();
+    // Kernel families can be forced onto a supported backend, for benchmarks; others get bestBackend()
+    static bool isSupported(SimdBackend backend);
+    static const char* getBackendName(SimdBackend backend);
+};
+
+#endif // CPUFEATURES_H
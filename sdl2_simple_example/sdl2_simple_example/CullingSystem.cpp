@@ -0,0 +1,368 @@
+#include "CullingSystem.h"
+#include "Components.h"
+#include "TransformStore.h"
+#include "JobSystem.h"
+#include <bitset>
+#include <chrono>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define CULLING_SSE 1
+#include <immintrin.h>
+#endif
+
+CullingSystem CullingSystem::cullingSystem;
+
+namespace {
+    using cullClock = std::chrono::high_resolution_clock;
+
+    // Boxes per visibility word, a job always handles whole words
+    const size_t WORD_BITS = 64;
+
+    // The tree is rebuilt once this fraction of its leaves has been reinserted
+    const size_t REBUILD_DIVISOR = 4;
+    const size_t REBUILD_MINIMUM = 64;
+
+    // Moved by the simulation, directly or through one of its ancestors
+    bool isMoving(Entity entity) {
+        World& world = World::world;
+        while (world.isAlive(entity)) {
+            if (world.has<MovementComponent>(entity)) {
+                return true;
+            }
+            const HierarchyComponent* hierarchy = world.tryGet<HierarchyComponent>(entity);
+            if (!hierarchy) break;
+            entity = hierarchy->parent;
+        }
+        return false;
+    }
+}
+
+void CullingSystem::resize(size_t newCount) {
+    count = newCount;
+
+    // Padded to whole words so the SIMD loop never needs a tail
+    const size_t padded = (count + WORD_BITS - 1) / WORD_BITS * WORD_BITS;
+    centerX.resize(padded, 0.0f);
+    centerY.resize(padded, 0.0f);
+    centerZ.resize(padded, 0.0f);
+    extentX.resize(padded, 0.0f);
+    extentY.resize(padded, 0.0f);
+    extentZ.resize(padded, 0.0f);
+    visibility.resize(padded / WORD_BITS);
+}
+
+void CullingSystem::gatherBounds() {
+    const auto start = cullClock::now();
+
+    if (staticDirty || builtStructureVersion != World::world.getStructureVersion() ||
+        builtLayoutVersion != TransformStore::transformStore.getLayoutVersion()) {
+        partition();
+    }
+
+    const std::vector<glm::mat4>& worldMatrices = TransformStore::transformStore.worldMatrices;
+    JobSystem::jobSystem.parallelFor(count, 1024, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const AABB box = AABB::fromCenterExtents(localCenters[i], localExtents[i]).transformed(worldMatrices[transformIndices[i]]);
+            const glm::vec3 center = box.center();
+            const glm::vec3 extents = box.extents();
+
+            centerX[i] = center.x;
+            centerY[i] = center.y;
+            centerZ[i] = center.z;
+            extentX[i] = extents.x;
+            extentY[i] = extents.y;
+            extentZ[i] = extents.z;
+        }
+    });
+
+    updateTree();
+    stats.gatherMs = std::chrono::duration<double, std::milli>(cullClock::now() - start).count();
+}
+
+// Splits the renderables: static ones go to a fresh octree with their current world box, dynamic ones
+// become the slots updated every frame
+void CullingSystem::partition() {
+    const auto start = cullClock::now();
+    const std::vector<glm::mat4>& worldMatrices = TransformStore::transformStore.worldMatrices;
+
+    std::vector<LooseOctree::Item> staticItems;
+    staticEntities.clear();
+    slotEntities.clear();
+    transformIndices.clear();
+    localCenters.clear();
+    localExtents.clear();
+    World::world.each<TransformComponent, MeshRendererComponent, BoundsComponent>(Without<InactiveTag>(),
+        [&](Entity entity, TransformComponent& transform, MeshRendererComponent&, BoundsComponent& bounds) {
+        const glm::vec3 localCenter = (bounds.localMin + bounds.localMax) * 0.5f;
+        const glm::vec3 localExtent = (bounds.localMax - bounds.localMin) * 0.5f;
+
+        if (isMoving(entity)) {
+            slotEntities.push_back(entity);
+            transformIndices.push_back(transform.transformIndex);
+            localCenters.push_back(localCenter);
+            localExtents.push_back(localExtent);
+        }
+        else {
+            LooseOctree::Item item;
+            item.box = AABB::fromCenterExtents(localCenter, localExtent).transformed(worldMatrices[transform.transformIndex]);
+            item.id = static_cast<uint32_t>(staticEntities.size());
+            staticItems.push_back(item);
+            staticEntities.push_back(entity);
+        }
+    });
+
+    octree.build(std::move(staticItems));
+    resize(transformIndices.size());
+
+    builtStructureVersion = World::world.getStructureVersion();
+    builtLayoutVersion = TransformStore::transformStore.getLayoutVersion();
+    staticDirty = false;
+    staticVersion++;
+
+    stats.staticObjects = staticEntities.size();
+    stats.dynamicObjects = count;
+    stats.octreeNodes = octree.getNodeCount();
+    stats.octreeDepth = octree.getDepth();
+    stats.octreeBuildMs = std::chrono::duration<double, std::milli>(cullClock::now() - start).count();
+}
+
+AABB CullingSystem::slotBox(size_t slot) const {
+    return AABB::fromCenterExtents(glm::vec3(centerX[slot], centerY[slot], centerZ[slot]), glm::vec3(extentX[slot], extentY[slot], extentZ[slot]));
+}
+
+// Objects standing still never leave their fat box, so they cost one containment test per frame
+void CullingSystem::updateTree() {
+    frame++;
+    size_t reinserts = 0;
+
+    for (size_t slot = 0; slot < count; ++slot) {
+        const Entity entity = slotEntities[slot];
+        if (entity.index >= proxies.size()) {
+            proxies.resize(entity.index + 1);
+        }
+
+        Proxy& proxy = proxies[entity.index];
+        if (proxy.proxy != AABBTree::NULL_NODE && proxy.owner != entity) {
+            // The entity slot was reused by a new entity
+            tree.destroyProxy(proxy.proxy);
+            proxy.proxy = AABBTree::NULL_NODE;
+        }
+
+        if (proxy.proxy == AABBTree::NULL_NODE) {
+            if (proxy.lastFrame == 0) {
+                trackedEntities.push_back(entity.index);
+            }
+            proxy.proxy = tree.createProxy(slotBox(slot), static_cast<int>(entity.index));
+            proxy.owner = entity;
+            reinserts++;
+        }
+        else if (tree.moveProxy(proxy.proxy, slotBox(slot))) {
+            reinserts++;
+        }
+
+        proxy.slot = static_cast<int>(slot);
+        proxy.lastFrame = frame;
+    }
+
+    // Entities destroyed, deactivated, made static or without a mesh since the last frame
+    for (size_t i = 0; i < trackedEntities.size();) {
+        Proxy& proxy = proxies[trackedEntities[i]];
+        if (proxy.lastFrame == frame) {
+            ++i;
+            continue;
+        }
+
+        tree.destroyProxy(proxy.proxy);
+        proxy = Proxy();
+        trackedEntities[i] = trackedEntities.back();
+        trackedEntities.pop_back();
+    }
+
+    reinsertsSinceRebuild += reinserts;
+    if (reinsertsSinceRebuild > std::max(REBUILD_MINIMUM, tree.getProxyCount() / REBUILD_DIVISOR)) {
+        tree.rebuild();
+        reinsertsSinceRebuild = 0;
+    }
+
+    if (reinserts > 0 || stats.treeHeight == 0) {
+        stats.treeHeight = tree.getHeight();
+        stats.treeAreaRatio = tree.getAreaRatio();
+    }
+    stats.treeReinserts = reinserts;
+    treeInSync = true;
+}
+
+void CullingSystem::setBounds(const std::vector<glm::vec3>& centers, const std::vector<glm::vec3>& extents) {
+    treeInSync = false;
+    resize(centers.size());
+    for (size_t i = 0; i < count; ++i) {
+        centerX[i] = centers[i].x;
+        centerY[i] = centers[i].y;
+        centerZ[i] = centers[i].z;
+        extentX[i] = extents[i].x;
+        extentY[i] = extents[i].y;
+        extentZ[i] = extents[i].z;
+    }
+}
+
+void CullingSystem::cull(const Frustum& frustum) {
+    const auto start = cullClock::now();
+
+    if (useTree && treeInSync) {
+        cullTree(frustum);
+    }
+    else {
+        cullLinear(frustum);
+    }
+
+    size_t dynamicVisible = 0;
+    for (uint64_t word : visibility) {
+        dynamicVisible += std::bitset<64>(word).count();
+    }
+
+    // Static objects cell by cell, so neighbours in space are submitted together
+    visibleStatic.clear();
+    stats.visibleCells = octree.queryFrustum(frustum, visibleStatic);
+    stats.staticVisible = visibleStatic.size();
+
+    visibleEntities.clear();
+    visibleEntities.reserve(visibleStatic.size() + dynamicVisible);
+    for (uint32_t id : visibleStatic) {
+        visibleEntities.push_back(staticEntities[id]);
+    }
+    // Slots filled through setBounds() have no entity behind them
+    if (slotEntities.size() == count) {
+        for (size_t slot = 0; slot < count; ++slot) {
+            if ((visibility[slot / WORD_BITS] >> (slot % WORD_BITS)) & 1) {
+                visibleEntities.push_back(slotEntities[slot]);
+            }
+        }
+    }
+
+    stats.tested = count + octree.getItems().size();
+    stats.visible = dynamicVisible + stats.staticVisible;
+    stats.culled = stats.tested - stats.visible;
+    stats.testMs = std::chrono::duration<double, std::milli>(cullClock::now() - start).count();
+}
+
+// Leaves only get an exact test when their subtree straddles a plane, so the result matches the linear path
+void CullingSystem::cullTree(const Frustum& frustum) {
+    std::fill(visibility.begin(), visibility.end(), 0);
+
+    tree.queryFrustum(frustum, [&](int leaf, bool fullyInside) {
+        const size_t slot = static_cast<size_t>(proxies[tree.getUserData(leaf)].slot);
+        if (fullyInside || frustum.intersectsBox(glm::vec3(centerX[slot], centerY[slot], centerZ[slot]), glm::vec3(extentX[slot], extentY[slot], extentZ[slot]))) {
+            visibility[slot / WORD_BITS] |= uint64_t(1) << (slot % WORD_BITS);
+        }
+    });
+}
+
+void CullingSystem::cullLinear(const Frustum& frustum) {
+    const size_t words = visibility.size();
+
+    JobSystem::jobSystem.parallelFor(words, 16, [&](size_t beginWord, size_t endWord) {
+        for (size_t word = beginWord; word < endWord; ++word) {
+            uint64_t bits = 0;
+
+#ifdef CULLING_SSE
+            const __m128 signMask = _mm_set1_ps(-0.0f);
+            for (size_t group = 0; group < WORD_BITS; group += 4) {
+                const size_t i = word * WORD_BITS + group;
+                const __m128 cx = _mm_loadu_ps(&centerX[i]);
+                const __m128 cy = _mm_loadu_ps(&centerY[i]);
+                const __m128 cz = _mm_loadu_ps(&centerZ[i]);
+                const __m128 ex = _mm_loadu_ps(&extentX[i]);
+                const __m128 ey = _mm_loadu_ps(&extentY[i]);
+                const __m128 ez = _mm_loadu_ps(&extentZ[i]);
+
+                __m128 outside = _mm_setzero_ps();
+                for (const glm::vec4& plane : frustum.planes) {
+                    const __m128 nx = _mm_set1_ps(plane.x);
+                    const __m128 ny = _mm_set1_ps(plane.y);
+                    const __m128 nz = _mm_set1_ps(plane.z);
+
+                    // distance + radius = n.c + w + |n|.e
+                    __m128 reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)), _mm_add_ps(_mm_mul_ps(nz, cz), _mm_set1_ps(plane.w)));
+                    reach = _mm_add_ps(reach, _mm_mul_ps(_mm_andnot_ps(signMask, nx), ex));
+                    reach = _mm_add_ps(reach, _mm_mul_ps(_mm_andnot_ps(signMask, ny), ey));
+                    reach = _mm_add_ps(reach, _mm_mul_ps(_mm_andnot_ps(signMask, nz), ez));
+                    outside = _mm_or_ps(outside, _mm_cmplt_ps(reach, _mm_setzero_ps()));
+                }
+                bits |= static_cast<uint64_t>(~_mm_movemask_ps(outside) & 0xF) << group;
+            }
+#else
+            for (size_t bit = 0; bit < WORD_BITS; ++bit) {
+                const size_t i = word * WORD_BITS + bit;
+                if (frustum.intersectsBox(glm::vec3(centerX[i], centerY[i], centerZ[i]), glm::vec3(extentX[i], extentY[i], extentZ[i]))) {
+                    bits |= uint64_t(1) << bit;
+                }
+            }
+#endif
+            visibility[word] = bits;
+        }
+    });
+
+    // Padding slots past the last box are never visible
+    if (count % WORD_BITS != 0) {
+        visibility.back() &= (uint64_t(1) << (count % WORD_BITS)) - 1;
+    }
+}
+
+void CullingSystem::cullScalar(const Frustum& frustum, std::vector<uint64_t>& outVisibility) const {
+    outVisibility.assign(visibility.size(), 0);
+    for (size_t i = 0; i < count; ++i) {
+        if (frustum.intersectsBox(glm::vec3(centerX[i], centerY[i], centerZ[i]), glm::vec3(extentX[i], extentY[i], extentZ[i]))) {
+            outVisibility[i / WORD_BITS] |= uint64_t(1) << (i % WORD_BITS);
+        }
+    }
+}
+
+void CullingSystem::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, const std::function<float(Entity, float)>& visit) const {
+    octree.raycast(origin, direction, maxDistance, [&](const LooseOctree::Item& item, float entry) {
+        maxDistance = visit(staticEntities[item.id], entry);
+        return maxDistance;
+    });
+
+    const glm::vec3 invDirection = 1.0f / direction;
+    tree.raycast(origin, direction, maxDistance, [&](int leaf, float) {
+        const Proxy& proxy = proxies[tree.getUserData(leaf)];
+
+        // The fat box was hit, the ray may still miss the real one
+        float exactEntry = 0.0f;
+        if (!slotBox(proxy.slot).intersectsRay(origin, invDirection, maxDistance, exactEntry)) {
+            return maxDistance;
+        }
+        maxDistance = visit(proxy.owner, exactEntry);
+        return maxDistance;
+    });
+}
+
+void CullingSystem::queryBox(const AABB& box, std::vector<Entity>& outEntities) const {
+    octree.queryBox(box, [&](const LooseOctree::Item& item) {
+        outEntities.push_back(staticEntities[item.id]);
+    });
+
+    tree.queryBox(box, [&](int leaf) {
+        const Proxy& proxy = proxies[tree.getUserData(leaf)];
+        if (slotBox(proxy.slot).overlaps(box)) {
+            outEntities.push_back(proxy.owner);
+        }
+    });
+}
+
+void CullingSystem::queryFrustum(const Frustum& frustum, std::vector<Entity>& outEntities) const {
+    std::vector<uint32_t> ids;
+    octree.queryFrustum(frustum, ids);
+    for (uint32_t id : ids) {
+        outEntities.push_back(staticEntities[id]);
+    }
+
+    tree.queryFrustum(frustum, [&](int leaf, bool fullyInside) {
+        const Proxy& proxy = proxies[tree.getUserData(leaf)];
+        const size_t slot = static_cast<size_t>(proxy.slot);
+        if (fullyInside || frustum.intersectsBox(glm::vec3(centerX[slot], centerY[slot], centerZ[slot]), glm::vec3(extentX[slot], extentY[slot], extentZ[slot]))) {
+            outEntities.push_back(proxy.owner);
+        }
+    });
+}
@@ -0,0 +1,118 @@
+#ifndef CULLINGSYSTEM_H
+#define CULLINGSYSTEM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Bounds.h"
+#include "AABBTree.h"
+#include "LooseOctree.h"
+#include "ECS.h"
+
+struct CullStats {
+    size_t tested = 0;
+    size_t visible = 0;
+    size_t culled = 0;
+    double gatherMs = 0.0;    // World bounds update
+    double testMs = 0.0;      // Frustum test
+    size_t treeReinserts = 0; // Leaves that left their fat box this frame
+    int treeHeight = 0;
+    float treeAreaRatio = 0.0f;
+
+    size_t staticObjects = 0;
+    size_t dynamicObjects = 0;
+    size_t staticVisible = 0;
+    size_t visibleCells = 0;  // Octree cells with at least one visible object
+    size_t octreeNodes = 0;
+    int octreeDepth = 0;
+    double octreeBuildMs = 0.0; // Last static rebuild
+};
+
+// Frustum culling and spatial queries for every renderable entity (Transform + MeshRenderer + Bounds, without InactiveTag).
+// Static objects, those without a MovementComponent on themselves or an ancestor, are bulk loaded into a
+// loose octree whenever the scene's static content changes, and cost nothing on frames where it doesn't.
+// Dynamic objects get their world boxes every frame, kept as center/extents in separate arrays, and live in
+// a dynamic AABB tree: culling walks it to skip whole subtrees, or tests every box 4 at a time with SSE
+// when the tree is disabled. cull() lists the visible entities octree cell by cell, then the dynamic ones.
+class CullingSystem {
+public:
+    static CullingSystem cullingSystem;
+
+    // Updates the dynamic boxes and the tree, and the octree when needed. Call after updateWorldMatrices().
+    void gatherBounds();
+    void cull(const Frustum& frustum);
+
+    // Visible entities in submission order, valid until the next cull()
+    const std::vector<Entity>& getVisibleEntities() const { return visibleEntities; }
+    size_t size() const { return count; }
+    const CullStats& getStats() const { return stats; }
+    // Objects in the octree, and a counter bumped every time that set or their boxes are rebuilt
+    const std::vector<Entity>& getStaticEntities() const { return staticEntities; }
+    uint32_t getStaticVersion() const { return staticVersion; }
+
+    // Static objects moved or edited in a way the world doesn't track, the octree is rebuilt on the next gather.
+    // Creating, destroying or changing the components of an entity is detected automatically.
+    void invalidateStatic() { staticDirty = true; }
+
+    // visit(entity, entry) for the entities whose world box the ray crosses, roughly front to back. It
+    // returns the distance to keep searching within, usually the closest hit so far.
+    void raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, const std::function<float(Entity, float)>& visit) const;
+    void queryBox(const AABB& box, std::vector<Entity>& outEntities) const;
+    // Entities whose world box intersects the frustum, static ones first, without touching the visible list
+    void queryFrustum(const Frustum& frustum, std::vector<Entity>& outEntities) const;
+
+    bool useTree = true;
+
+    // Tests the current dynamic boxes, without stats and without SIMD, used to validate the fast paths
+    void cullScalar(const Frustum& frustum, std::vector<uint64_t>& outVisibility) const;
+    const std::vector<uint64_t>& getVisibility() const { return visibility; }
+
+    // Fills the dynamic arrays directly, for benchmarks
+    void setBounds(const std::vector<glm::vec3>& centers, const std::vector<glm::vec3>& extents);
+
+private:
+    // Tree leaf of each entity, indexed by entity index
+    struct Proxy {
+        Entity owner;
+        int proxy = AABBTree::NULL_NODE;
+        int slot = -1;
+        uint32_t lastFrame = 0;
+    };
+
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+    std::vector<Entity> slotEntities;
+    std::vector<int> transformIndices;
+    std::vector<glm::vec3> localCenters;
+    std::vector<glm::vec3> localExtents;
+    std::vector<uint64_t> visibility;
+    size_t count = 0;
+    CullStats stats;
+
+    LooseOctree octree;
+    std::vector<Entity> staticEntities;    // Indexed by octree item id
+    std::vector<uint32_t> visibleStatic;
+    std::vector<Entity> visibleEntities;
+    uint32_t builtStructureVersion = 0;
+    uint32_t builtLayoutVersion = 0;
+    uint32_t staticVersion = 0;
+    bool staticDirty = true;
+
+    AABBTree tree;
+    std::vector<Proxy> proxies;
+    std::vector<uint32_t> trackedEntities;
+    uint32_t frame = 0;
+    size_t reinsertsSinceRebuild = 0;
+    bool treeInSync = false;
+
+    void resize(size_t newCount);
+    void partition();
+    void updateTree();
+    void cullLinear(const Frustum& frustum);
+    void cullTree(const Frustum& frustum);
+    AABB slotBox(size_t slot) const;
+};
+
+#endif // CULLINGSYSTEM_H
@@ -0,0 +1,336 @@
+#include "DebugDraw.h"
+#include "ConsoleWindow.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+DebugDraw DebugDraw::debugDraw;
+
+namespace {
+    const GLuint POSITION_ATTRIBUTE = 0;
+    const GLuint COLOR_ATTRIBUTE = 1;
+    const float POINT_SIZE = 5.0f;
+
+    const char* DEBUG_VERTEX_SHADER = R"(#version 140
+uniform mat4 viewProjection;
+in vec3 position;
+in vec4 color;
+out vec4 vertexColor;
+void main() {
+    vertexColor = color;
+    gl_Position = viewProjection * vec4(position, 1.0);
+}
+)";
+
+    const char* DEBUG_FRAGMENT_SHADER = R"(#version 140
+in vec4 vertexColor;
+out vec4 fragColor;
+void main() {
+    fragColor = vertexColor;
+}
+)";
+
+    glm::vec3 boxCorner(const AABB& box, int bits) {
+        return glm::vec3(bits & 1 ? box.max.x : box.min.x, bits & 2 ? box.max.y : box.min.y, bits & 4 ? box.max.z : box.min.z);
+    }
+
+    // The twelve edges of a box given by its corners, corner i has bit 0, 1, 2 set on the max x, y, z side
+    void boxEdges(const glm::vec3 corners[8], glm::vec3 edges[24]) {
+        int edge = 0;
+        for (int corner = 0; corner < 8; corner++) {
+            for (int bit = 1; bit < 8; bit <<= 1) {
+                if (!(corner & bit)) {
+                    edges[edge++] = corners[corner];
+                    edges[edge++] = corners[corner | bit];
+                }
+            }
+        }
+    }
+}
+
+void DebugDraw::init() {
+    if (!GLEW_VERSION_3_1) {
+        console.addLog("OpenGL 3.1 is not available, debug shapes are drawn with the fixed pipeline");
+        return;
+    }
+    if (!program.build("Debug draw", DEBUG_VERTEX_SHADER, DEBUG_FRAGMENT_SHADER,
+        { { POSITION_ATTRIBUTE, "position" }, { COLOR_ATTRIBUTE, "color" } }, { { 0, "fragColor" } })) {
+        console.addLog("Debug draw shaders failed to build, debug shapes are drawn with the fixed pipeline");
+        return;
+    }
+    viewProjectionLocation = program.uniform("viewProjection");
+
+    ringCapacity = RING_BYTES;
+    ringOffset = 0;
+    stats.ringBytes = ringCapacity;
+
+    glGenVertexArrays(1, &vertexArray);
+    glBindVertexArray(vertexArray);
+    glGenBuffers(1, &ringBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, ringBuffer);
+    glBufferData(GL_ARRAY_BUFFER, ringCapacity, nullptr, GL_STREAM_DRAW);
+    glEnableVertexAttribArray(POSITION_ATTRIBUTE);
+    glVertexAttribPointer(POSITION_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<const void*>(offsetof(Vertex, position)));
+    glEnableVertexAttribArray(COLOR_ATTRIBUTE);
+    glVertexAttribPointer(COLOR_ATTRIBUTE, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), reinterpret_cast<const void*>(offsetof(Vertex, color)));
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    available = true;
+}
+
+void DebugDraw::release() {
+    program.release();
+    glDeleteBuffers(1, &ringBuffer);
+    glDeleteVertexArrays(1, &vertexArray);
+    ringBuffer = vertexArray = 0;
+    ringCapacity = ringOffset = 0;
+    available = false;
+}
+
+uint32_t DebugDraw::pack(const glm::vec3& color) {
+    const auto channel = [](float value) { return static_cast<uint8_t>(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f); };
+    // Bytes in memory order r, g, b, a, as GL reads them
+    const uint8_t rgba[4] = { channel(color.x), channel(color.y), channel(color.z), 255 };
+    uint32_t packed;
+    std::memcpy(&packed, rgba, sizeof(packed));
+    return packed;
+}
+
+// One lock per shape, the vertices are built before taking it
+void DebugDraw::append(List list, const Vertex* vertices, size_t count) {
+    std::lock_guard<std::mutex> guard(lock);
+    lists[list].insert(lists[list].end(), vertices, vertices + count);
+}
+
+void DebugDraw::appendLines(const glm::vec3* positions, size_t count, const glm::vec3& color, Mode mode) {
+    const uint32_t packed = pack(color);
+    Vertex vertices[SPHERE_SEGMENTS * 6];
+    const List list = mode == Mode::Depth ? DepthLines : OverlayLines;
+
+    // Chunked so large strips don't need a heap copy
+    for (size_t start = 0; start < count; start += SPHERE_SEGMENTS * 6) {
+        const size_t chunk = std::min(count - start, static_cast<size_t>(SPHERE_SEGMENTS * 6));
+        for (size_t i = 0; i < chunk; i++) {
+            vertices[i] = { positions[start + i], packed };
+        }
+        append(list, vertices, chunk);
+    }
+}
+
+void DebugDraw::line(const glm::vec3& from, const glm::vec3& to, const glm::vec3& color, Mode mode) {
+    const glm::vec3 positions[2] = { from, to };
+    appendLines(positions, 2, color, mode);
+}
+
+void DebugDraw::point(const glm::vec3& position, const glm::vec3& color, Mode mode) {
+    const Vertex vertex = { position, pack(color) };
+    append(mode == Mode::Depth ? DepthPoints : OverlayPoints, &vertex, 1);
+}
+
+void DebugDraw::box(const AABB& box, const glm::vec3& color, Mode mode) {
+    glm::vec3 corners[8];
+    for (int corner = 0; corner < 8; corner++) {
+        corners[corner] = boxCorner(box, corner);
+    }
+    glm::vec3 edges[24];
+    boxEdges(corners, edges);
+    appendLines(edges, 24, color, mode);
+}
+
+void DebugDraw::box(const AABB& localBox, const glm::mat4& world, const glm::vec3& color, Mode mode) {
+    glm::vec3 corners[8];
+    for (int corner = 0; corner < 8; corner++) {
+        corners[corner] = glm::vec3(world * glm::vec4(boxCorner(localBox, corner), 1.0f));
+    }
+    glm::vec3 edges[24];
+    boxEdges(corners, edges);
+    appendLines(edges, 24, color, mode);
+}
+
+void DebugDraw::sphere(const glm::vec3& center, float radius, const glm::vec3& color, Mode mode) {
+    glm::vec3 positions[SPHERE_SEGMENTS * 6];
+    size_t count = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        const int u = (axis + 1) % 3;
+        const int v = (axis + 2) % 3;
+        for (int segment = 0; segment < SPHERE_SEGMENTS; segment++) {
+            for (int end = 0; end < 2; end++) {
+                const float angle = 6.2831853f * (segment + end) / SPHERE_SEGMENTS;
+                glm::vec3 position = center;
+                position[u] += std::cos(angle) * radius;
+                position[v] += std::sin(angle) * radius;
+                positions[count++] = position;
+            }
+        }
+    }
+    appendLines(positions, count, color, mode);
+}
+
+void DebugDraw::ray(const glm::vec3& origin, const glm::vec3& direction, float length, const glm::vec3& color, Mode mode) {
+    const glm::vec3 end = origin + direction * length;
+    line(origin, end, color, mode);
+
+    const uint32_t packed = pack(color);
+    const Vertex ends[2] = { { origin, packed }, { end, packed } };
+    append(mode == Mode::Depth ? DepthPoints : OverlayPoints, ends, 2);
+}
+
+void DebugDraw::frustum(const glm::mat4& viewProjection, const glm::vec3& color, Mode mode) {
+    // Corners of the clip space cube taken back to world space
+    const glm::mat4 inverse = glm::inverse(viewProjection);
+    glm::vec3 corners[8];
+    for (int corner = 0; corner < 8; corner++) {
+        const glm::vec4 clip(corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f, corner & 4 ? 1.0f : -1.0f, 1.0f);
+        const glm::vec4 world = inverse * clip;
+        corners[corner] = glm::vec3(world) / world.w;
+    }
+    glm::vec3 edges[24];
+    boxEdges(corners, edges);
+    appendLines(edges, 24, color, mode);
+}
+
+void DebugDraw::lineStrip(const float* positions, size_t count, const glm::mat4& world, const glm::vec3& color, Mode mode) {
+    if (count < 2) return;
+
+    std::vector<Vertex> vertices;
+    vertices.reserve((count - 1) * 2);
+    const uint32_t packed = pack(color);
+    glm::vec3 previous = glm::vec3(world * glm::vec4(positions[0], positions[1], positions[2], 1.0f));
+    for (size_t i = 1; i < count; i++) {
+        const glm::vec3 current = glm::vec3(world * glm::vec4(positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2], 1.0f));
+        vertices.push_back({ previous, packed });
+        vertices.push_back({ current, packed });
+        previous = current;
+    }
+    append(mode == Mode::Depth ? DepthLines : OverlayLines, vertices.data(), vertices.size());
+}
+
+void DebugDraw::flush(const glm::mat4& projection, const glm::mat4& view) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (int list = 0; list < LIST_COUNT; list++) {
+            drawing[list].clear();
+            std::swap(lists[list], drawing[list]);
+        }
+    }
+
+    stats.lines = (drawing[DepthLines].size() + drawing[OverlayLines].size()) / 2;
+    stats.points = drawing[DepthPoints].size() + drawing[OverlayPoints].size();
+    stats.drawCalls = 0;
+    stats.uploadedBytes = 0;
+
+    size_t vertexCount = 0;
+    for (int list = 0; list < LIST_COUNT; list++) {
+        vertexCount += drawing[list].size();
+    }
+    if (!enabled || vertexCount == 0) return;
+
+    GLint first[LIST_COUNT] = {};
+    if (available) {
+        const size_t bytes = vertexCount * sizeof(Vertex);
+        GLint vertex = static_cast<GLint>(upload(bytes) / sizeof(Vertex));
+        for (int list = 0; list < LIST_COUNT; list++) {
+            first[list] = vertex;
+            vertex += static_cast<GLint>(drawing[list].size());
+        }
+        stats.uploadedBytes = bytes;
+
+        program.use();
+        const glm::mat4 viewProjection = projection * view;
+        glUniformMatrix4fv(viewProjectionLocation, 1, GL_FALSE, glm::value_ptr(viewProjection));
+        glBindVertexArray(vertexArray);
+        drawLists(first);
+        glBindVertexArray(0);
+        glUseProgram(0);
+    }
+    else {
+        glMatrixMode(GL_PROJECTION);
+        glPushMatrix();
+        glLoadMatrixf(glm::value_ptr(projection));
+        glMatrixMode(GL_MODELVIEW);
+        glPushMatrix();
+        glLoadMatrixf(glm::value_ptr(view));
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_COLOR_ARRAY);
+
+        drawLists(first);
+
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+        glPopMatrix();
+        glMatrixMode(GL_PROJECTION);
+        glPopMatrix();
+        glMatrixMode(GL_MODELVIEW);
+    }
+}
+
+// Copies this frame's lists after the previous frames' in the ring, returns where they start
+size_t DebugDraw::upload(size_t bytes) {
+    glBindBuffer(GL_ARRAY_BUFFER, ringBuffer);
+
+    // Once full the ring gets a new allocation, the driver keeps the old one until the GPU is done with it.
+    // Until then every frame writes past the others, nothing the GPU may still read is overwritten.
+    // It holds a few frames of the current size, so it isn't reallocated every frame.
+    if (ringOffset + bytes > ringCapacity) {
+        while (ringCapacity < bytes * RING_FRAMES) {
+            ringCapacity *= 2;
+        }
+        glBufferData(GL_ARRAY_BUFFER, ringCapacity, nullptr, GL_STREAM_DRAW);
+        ringOffset = 0;
+        stats.orphans++;
+        stats.ringBytes = ringCapacity;
+    }
+
+    const size_t offset = ringOffset;
+    char* mapped = static_cast<char*>(glMapBufferRange(GL_ARRAY_BUFFER, offset, bytes,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+    size_t written = 0;
+    for (int list = 0; list < LIST_COUNT; list++) {
+        const size_t listBytes = drawing[list].size() * sizeof(Vertex);
+        if (listBytes == 0) continue;
+        if (mapped) {
+            std::memcpy(mapped + written, drawing[list].data(), listBytes);
+        }
+        else {
+            glBufferSubData(GL_ARRAY_BUFFER, offset + written, listBytes, drawing[list].data());
+        }
+        written += listBytes;
+    }
+    if (mapped) {
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    ringOffset += bytes;
+    return offset;
+}
+
+// One draw per non empty list, overlay lists with the depth test off
+void DebugDraw::drawLists(GLint first[LIST_COUNT]) {
+    glPointSize(POINT_SIZE);
+    for (int list = 0; list < LIST_COUNT; list++) {
+        const std::vector<Vertex>& vertices = drawing[list];
+        if (vertices.empty()) continue;
+
+        if (!available) {
+            glVertexPointer(3, GL_FLOAT, sizeof(Vertex), &vertices[0].position);
+            glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Vertex), &vertices[0].color);
+        }
+
+        const bool overlay = list == OverlayLines || list == OverlayPoints;
+        if (overlay) {
+            glDisable(GL_DEPTH_TEST);
+        }
+        const bool points = list == DepthPoints || list == OverlayPoints;
+        glDrawArrays(points ? GL_POINTS : GL_LINES, first[list], static_cast<GLsizei>(vertices.size()));
+        if (overlay) {
+            glEnable(GL_DEPTH_TEST);
+        }
+        stats.drawCalls++;
+    }
+    glPointSize(1.0f);
+}
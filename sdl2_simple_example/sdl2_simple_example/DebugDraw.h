@@ -0,0 +1,106 @@
+#ifndef DEBUGDRAW_H
+#define DEBUGDRAW_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "Bounds.h"
+#include "ShaderProgram.h"
+
+struct DebugDrawStats {
+    size_t lines = 0;               // Lines drawn last frame, both modes
+    size_t points = 0;
+    size_t drawCalls = 0;
+    size_t uploadedBytes = 0;
+    size_t orphans = 0;             // Times the ring buffer wrapped and was reallocated, since startup
+    size_t ringBytes = 0;           // Ring buffer capacity
+};
+
+// Lines, boxes, spheres, rays and frustums for debugging, instead of glBegin() at every call site.
+// Shapes are appended as colored line vertices to this frame's lists, from any thread, and drawn all at once
+// by flush(): the lists are copied once into a streaming ring buffer, written unsynchronized after the
+// previous frames' data and reallocated only when it wraps, then drawn with one glDrawArrays per primitive
+// type and mode. Depth tested shapes are hidden by the scene, overlay ones are drawn over it.
+// Without shaders the same lists are drawn from client arrays.
+class DebugDraw {
+public:
+    static DebugDraw debugDraw;
+
+    enum class Mode {
+        Depth,
+        Overlay,
+    };
+
+    // Ring buffer capacity at startup, it grows to fit larger frames
+    static const size_t RING_BYTES = 1 << 20;
+    static const size_t RING_FRAMES = 3;       // Frames of the current size it grows to hold
+    static const int SPHERE_SEGMENTS = 32;
+
+    void init();
+    // Deletes the program and ring buffer, the GL context must still be current
+    void release();
+
+    void line(const glm::vec3& from, const glm::vec3& to, const glm::vec3& color, Mode mode = Mode::Depth);
+    void point(const glm::vec3& position, const glm::vec3& color, Mode mode = Mode::Depth);
+    void box(const AABB& box, const glm::vec3& color, Mode mode = Mode::Depth);
+    // Box in the local space of 'world', its edges follow the object's rotation
+    void box(const AABB& localBox, const glm::mat4& world, const glm::vec3& color, Mode mode = Mode::Depth);
+    // Three circles, one per axis plane
+    void sphere(const glm::vec3& center, float radius, const glm::vec3& color, Mode mode = Mode::Depth);
+    // The segment and a point at both ends
+    void ray(const glm::vec3& origin, const glm::vec3& direction, float length, const glm::vec3& color, Mode mode = Mode::Depth);
+    // Edges of the volume a view projection matrix sees
+    void frustum(const glm::mat4& viewProjection, const glm::vec3& color, Mode mode = Mode::Depth);
+    // Consecutive points of 'positions' (x, y, z triplets) joined by lines, through 'world'
+    void lineStrip(const float* positions, size_t count, const glm::mat4& world, const glm::vec3& color, Mode mode = Mode::Depth);
+
+    // Draws and clears everything appended since the last flush. Main thread, into the bound framebuffer.
+    void flush(const glm::mat4& projection, const glm::mat4& view);
+
+    const DebugDrawStats& getStats() const { return stats; }
+
+    bool enabled = true;
+    // World boxes of every object drawn, added by the renderer each frame
+    bool showBounds = false;
+
+private:
+    struct Vertex {
+        glm::vec3 position;
+        uint32_t color;     // RGBA8
+    };
+
+    // Lines and points, depth tested then overlay
+    enum List {
+        DepthLines,
+        DepthPoints,
+        OverlayLines,
+        OverlayPoints,
+        LIST_COUNT,
+    };
+
+    std::mutex lock;
+    std::vector<Vertex> lists[LIST_COUNT];
+    // Swapped with 'lists' by flush(), so other threads can append the next frame while this one draws
+    std::vector<Vertex> drawing[LIST_COUNT];
+
+    ShaderProgram program;
+    GLint viewProjectionLocation = -1;
+    GLuint vertexArray = 0;
+    GLuint ringBuffer = 0;
+    size_t ringCapacity = 0;
+    size_t ringOffset = 0;
+    bool available = false;
+
+    DebugDrawStats stats;
+
+    void append(List list, const Vertex* vertices, size_t count);
+    void appendLines(const glm::vec3* positions, size_t count, const glm::vec3& color, Mode mode);
+    size_t upload(size_t bytes);
+    void drawLists(GLint first[LIST_COUNT]);
+    static uint32_t pack(const glm::vec3& color);
+};
+
+#endif // DEBUGDRAW_H
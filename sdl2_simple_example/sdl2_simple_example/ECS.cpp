@@ -0,0 +1,212 @@
+#include "ECS.h"
+#include <algorithm>
+
+World World::world;
+
+World::World() {
+    // Every new entity starts in the archetype without components
+    getArchetype(0);
+}
+
+World::~World() {}
+
+std::vector<size_t>& World::componentSizes() {
+    static std::vector<size_t> sizes;
+    return sizes;
+}
+
+ComponentId World::registerComponent(size_t size) {
+    std::vector<size_t>& sizes = componentSizes();
+    if (sizes.size() >= Archetype::MAX_COMPONENTS) {
+        throw std::runtime_error("Too many component types registered");
+    }
+    sizes.push_back(size);
+    return static_cast<ComponentId>(sizes.size() - 1);
+}
+
+Entity World::create() {
+    Entity entity;
+    if (!freeIndices.empty()) {
+        entity.index = freeIndices.back();
+        freeIndices.pop_back();
+    }
+    else {
+        entity.index = static_cast<uint32_t>(records.size());
+        records.emplace_back();
+    }
+
+    EntityRecord& newRecord = records[entity.index];
+    entity.generation = newRecord.generation;
+
+    Archetype* empty = archetypeByMask[0];
+    allocateRow(empty, entity, newRecord.chunk, newRecord.row);
+    newRecord.archetype = empty;
+    structureVersion++;
+
+    return entity;
+}
+
+void World::destroy(Entity entity) {
+    if (!isAlive(entity)) {
+        return;
+    }
+
+    EntityRecord& oldRecord = records[entity.index];
+    removeRow(oldRecord.archetype, oldRecord.chunk, oldRecord.row);
+    oldRecord.archetype = nullptr;
+    oldRecord.generation++;
+    freeIndices.push_back(entity.index);
+    structureVersion++;
+}
+
+bool World::isAlive(Entity entity) const {
+    return entity.index < records.size() && records[entity.index].archetype != nullptr &&
+        records[entity.index].generation == entity.generation;
+}
+
+const World::EntityRecord& World::record(Entity entity) const {
+    if (!isAlive(entity)) {
+        throw std::runtime_error("Invalid or destroyed entity");
+    }
+    return records[entity.index];
+}
+
+Archetype* World::getArchetype(ComponentMask mask) {
+    auto it = archetypeByMask.find(mask);
+    if (it != archetypeByMask.end()) {
+        return it->second;
+    }
+
+    auto archetype = std::make_unique<Archetype>();
+    archetype->mask = mask;
+    std::fill(std::begin(archetype->columns), std::end(archetype->columns), -1);
+
+    size_t bytesPerEntity = sizeof(Entity);
+    for (ComponentId id = 0; id < Archetype::MAX_COMPONENTS; ++id) {
+        if (mask & (ComponentMask(1) << id)) {
+            archetype->columns[id] = static_cast<int>(archetype->components.size());
+            archetype->components.push_back(id);
+            archetype->sizes.push_back(componentSizes()[id]);
+            bytesPerEntity += componentSizes()[id];
+        }
+    }
+
+    // Lay the arrays one after the other, dropping entities until the padding fits in the chunk
+    uint32_t capacity = static_cast<uint32_t>(Archetype::CHUNK_SIZE / bytesPerEntity);
+    while (true) {
+        size_t offset = sizeof(Entity) * capacity;
+        archetype->offsets.clear();
+        for (size_t size : archetype->sizes) {
+            offset = (offset + 15) & ~size_t(15);
+            archetype->offsets.push_back(offset);
+            offset += size * capacity;
+        }
+        if (offset <= Archetype::CHUNK_SIZE) break;
+        capacity--;
+    }
+    archetype->capacity = capacity;
+
+    Archetype* result = archetype.get();
+    archetypes.push_back(std::move(archetype));
+    archetypeByMask[mask] = result;
+    return result;
+}
+
+void World::allocateRow(Archetype* archetype, Entity entity, uint32_t& chunk, uint32_t& row) {
+    if (archetype->chunks.empty() || archetype->chunks.back()->count == archetype->capacity) {
+        archetype->chunks.push_back(std::make_unique<Archetype::Chunk>());
+    }
+
+    chunk = static_cast<uint32_t>(archetype->chunks.size() - 1);
+    Archetype::Chunk& target = *archetype->chunks.back();
+    row = target.count++;
+    archetype->entities(target)[row] = entity;
+    archetype->entityCount++;
+}
+
+// Fills the hole with the last entity of the archetype so chunks stay tightly packed
+void World::removeRow(Archetype* archetype, uint32_t chunk, uint32_t row) {
+    Archetype::Chunk& last = *archetype->chunks.back();
+    const uint32_t lastChunk = static_cast<uint32_t>(archetype->chunks.size() - 1);
+    const uint32_t lastRow = last.count - 1;
+
+    if (chunk != lastChunk || row != lastRow) {
+        Archetype::Chunk& hole = *archetype->chunks[chunk];
+        Entity moved = archetype->entities(last)[lastRow];
+        archetype->entities(hole)[row] = moved;
+
+        for (size_t column = 0; column < archetype->components.size(); ++column) {
+            std::memcpy(archetype->element(hole, static_cast<int>(column), row),
+                archetype->element(last, static_cast<int>(column), lastRow), archetype->sizes[column]);
+        }
+
+        records[moved.index].chunk = chunk;
+        records[moved.index].row = row;
+    }
+
+    last.count--;
+    archetype->entityCount--;
+    if (last.count == 0) {
+        archetype->chunks.pop_back();
+    }
+}
+
+void World::moveEntity(Entity entity, Archetype* target) {
+    EntityRecord& current = records[entity.index];
+    Archetype* source = current.archetype;
+    Archetype::Chunk& sourceChunk = *source->chunks[current.chunk];
+
+    uint32_t chunk, row;
+    allocateRow(target, entity, chunk, row);
+    Archetype::Chunk& targetChunk = *target->chunks[chunk];
+
+    // Shared components are copied over, the new ones start zeroed until add() writes them
+    for (size_t column = 0; column < target->components.size(); ++column) {
+        const int sourceColumn = source->columns[target->components[column]];
+        unsigned char* destination = target->element(targetChunk, static_cast<int>(column), row);
+
+        if (sourceColumn >= 0) {
+            std::memcpy(destination, source->element(sourceChunk, sourceColumn, current.row), target->sizes[column]);
+        }
+        else {
+            std::memset(destination, 0, target->sizes[column]);
+        }
+    }
+
+    removeRow(source, current.chunk, current.row);
+
+    current.archetype = target;
+    current.chunk = chunk;
+    current.row = row;
+    structureVersion++;
+}
+
+unsigned char* World::componentData(Entity entity, ComponentId id) {
+    const EntityRecord& current = record(entity);
+    Archetype* archetype = current.archetype;
+    return archetype->element(*archetype->chunks[current.chunk], archetype->columns[id], current.row);
+}
+
+Query& World::findQuery(ComponentMask include, ComponentMask exclude) {
+    for (auto& query : queries) {
+        if (query->include == include && query->exclude == exclude) {
+            return *query;
+        }
+    }
+
+    auto query = std::make_unique<Query>();
+    query->include = include;
+    query->exclude = exclude;
+    queries.push_back(std::move(query));
+    return *queries.back();
+}
+
+// Only the archetypes created since the last refresh need to be tested
+void World::refreshQuery(Query& query) {
+    for (; query.checkedArchetypes < archetypes.size(); ++query.checkedArchetypes) {
+        Archetype* archetype = archetypes[query.checkedArchetypes].get();
+        if ((archetype->mask & query.include) == query.include && (archetype->mask & query.exclude) == 0) {
+            query.archetypes.push_back(archetype);
+        }
+    }
+}
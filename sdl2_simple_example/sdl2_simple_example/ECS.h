@@ -0,0 +1,271 @@
+#ifndef ECS_H
+#define ECS_H
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "JobSystem.h"
+
+// Handle to an entity, the generation changes every time its slot gets reused
+struct Entity {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool isValid() const { return index != UINT32_MAX; }
+    bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const Entity& other) const { return !(*this == other); }
+};
+
+using ComponentId = uint32_t;
+using ComponentMask = uint64_t;
+
+// Components a query must not have, e.g. world.each<A, B>(Without<C>(), ...)
+template <typename... Components>
+struct Without {};
+
+// Every entity with exactly the same set of components.
+// Entities are packed in fixed-size chunks, each component in its own array inside the chunk.
+struct Archetype {
+    static const size_t CHUNK_SIZE = 16 * 1024;
+    static const int MAX_COMPONENTS = 64;
+
+    struct alignas(64) Chunk {
+        unsigned char data[CHUNK_SIZE];
+        uint32_t count = 0;
+    };
+
+    ComponentMask mask = 0;
+    std::vector<ComponentId> components;
+    std::vector<size_t> sizes;
+    std::vector<size_t> offsets;       // Byte offset of each component array inside a chunk
+    int columns[MAX_COMPONENTS];       // Position of each component id in 'components', -1 if missing
+    uint32_t capacity = 0;             // Entities per chunk
+    size_t entityCount = 0;
+    std::vector<std::unique_ptr<Chunk>> chunks;
+
+    Entity* entities(Chunk& chunk) const { return reinterpret_cast<Entity*>(chunk.data); }
+    unsigned char* element(Chunk& chunk, int column, uint32_t row) const {
+        return chunk.data + offsets[column] + sizes[column] * row;
+    }
+    void* columnData(Chunk& chunk, ComponentId id) const { return chunk.data + offsets[columns[id]]; }
+};
+
+// Cached list of the archetypes matching a component mask, refreshed when new archetypes appear
+struct Query {
+    ComponentMask include = 0;
+    ComponentMask exclude = 0;
+    std::vector<Archetype*> archetypes;
+    size_t checkedArchetypes = 0;
+};
+
+// Archetype based entity-component storage.
+// Components must be trivially copyable: they are moved between chunks with memcpy.
+class World {
+public:
+    static World world;
+
+    World();
+    ~World();
+
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    Entity create();
+    void destroy(Entity entity);
+    bool isAlive(Entity entity) const;
+
+    template <typename T> T& add(Entity entity, const T& value = T());
+    template <typename T> void remove(Entity entity);
+    template <typename T> bool has(Entity entity) const;
+    template <typename T> T& get(Entity entity);
+    template <typename T> T* tryGet(Entity entity);
+
+    // Calls function(entity, components...) for every entity having all the listed components.
+    // Adding or removing components from inside the callback is not allowed.
+    template <typename... Ts, typename Function>
+    void each(Function&& function);
+    template <typename... Ts, typename... Excluded, typename Function>
+    void each(Without<Excluded...>, Function&& function);
+
+    // Same as each() with the chunks spread over the job system, the callback must be thread-safe
+    template <typename... Ts, typename Function>
+    void parallelEach(Function&& function);
+    template <typename... Ts, typename... Excluded, typename Function>
+    void parallelEach(Without<Excluded...>, Function&& function);
+
+    template <typename T> static ComponentId componentId();
+    template <typename... Ts> static ComponentMask maskOf() { return (ComponentMask(0) | ... | (ComponentMask(1) << componentId<Ts>())); }
+
+    size_t entityCount() const { return records.size() - freeIndices.size(); }
+    size_t archetypeCount() const { return archetypes.size(); }
+    // Changes whenever an entity is created, destroyed or gains/loses a component
+    uint32_t getStructureVersion() const { return structureVersion; }
+
+private:
+    struct EntityRecord {
+        Archetype* archetype = nullptr;
+        uint32_t chunk = 0;
+        uint32_t row = 0;
+        uint32_t generation = 0;
+    };
+
+    std::vector<EntityRecord> records;
+    std::vector<uint32_t> freeIndices;
+    std::vector<std::unique_ptr<Archetype>> archetypes;
+    std::unordered_map<ComponentMask, Archetype*> archetypeByMask;
+    std::vector<std::unique_ptr<Query>> queries;
+    uint32_t structureVersion = 0;
+
+    static ComponentId registerComponent(size_t size);
+    static std::vector<size_t>& componentSizes();
+
+    Archetype* getArchetype(ComponentMask mask);
+    void allocateRow(Archetype* archetype, Entity entity, uint32_t& chunk, uint32_t& row);
+    void removeRow(Archetype* archetype, uint32_t chunk, uint32_t row);
+    void moveEntity(Entity entity, Archetype* target);
+    unsigned char* componentData(Entity entity, ComponentId id);
+    const EntityRecord& record(Entity entity) const;
+
+    Query& findQuery(ComponentMask include, ComponentMask exclude);
+    void refreshQuery(Query& query);
+
+    template <typename... Ts, typename Function>
+    void run(Query& query, Function& function);
+    template <typename... Ts, typename Function>
+    void runParallel(Query& query, Function& function);
+    template <typename... Ts, typename Function>
+    static void runChunk(Archetype& archetype, Archetype::Chunk& chunk, Function& function);
+};
+
+template <typename T>
+ComponentId World::componentId() {
+    static_assert(std::is_trivially_copyable<T>::value, "Components must be trivially copyable");
+    // Tags (empty structs) take no space in the chunks
+    static const ComponentId id = registerComponent(std::is_empty<T>::value ? 0 : sizeof(T));
+    return id;
+}
+
+template <typename T>
+T& World::add(Entity entity, const T& value) {
+    const ComponentId id = componentId<T>();
+    const EntityRecord& current = record(entity);
+
+    if (!(current.archetype->mask & (ComponentMask(1) << id))) {
+        moveEntity(entity, getArchetype(current.archetype->mask | (ComponentMask(1) << id)));
+    }
+
+    if constexpr (std::is_empty<T>::value) {
+        static T tag;
+        return tag;
+    }
+    else {
+        T* component = reinterpret_cast<T*>(componentData(entity, id));
+        std::memcpy(static_cast<void*>(component), &value, sizeof(T));
+        return *component;
+    }
+}
+
+template <typename T>
+void World::remove(Entity entity) {
+    const ComponentId id = componentId<T>();
+    const EntityRecord& current = record(entity);
+
+    if (current.archetype->mask & (ComponentMask(1) << id)) {
+        moveEntity(entity, getArchetype(current.archetype->mask & ~(ComponentMask(1) << id)));
+    }
+}
+
+template <typename T>
+bool World::has(Entity entity) const {
+    return isAlive(entity) && (record(entity).archetype->mask & (ComponentMask(1) << componentId<T>()));
+}
+
+template <typename T>
+T& World::get(Entity entity) {
+    T* component = tryGet<T>(entity);
+    if (!component) {
+        throw std::runtime_error("Entity does not have the requested component");
+    }
+    return *component;
+}
+
+template <typename T>
+T* World::tryGet(Entity entity) {
+    static_assert(!std::is_empty<T>::value, "Tags have no data, use has<T>() instead");
+    if (!has<T>(entity)) {
+        return nullptr;
+    }
+    return reinterpret_cast<T*>(componentData(entity, componentId<T>()));
+}
+
+template <typename... Ts, typename Function>
+void World::each(Function&& function) {
+    run<Ts...>(findQuery(maskOf<Ts...>(), 0), function);
+}
+
+template <typename... Ts, typename... Excluded, typename Function>
+void World::each(Without<Excluded...>, Function&& function) {
+    run<Ts...>(findQuery(maskOf<Ts...>(), maskOf<Excluded...>()), function);
+}
+
+template <typename... Ts, typename Function>
+void World::parallelEach(Function&& function) {
+    runParallel<Ts...>(findQuery(maskOf<Ts...>(), 0), function);
+}
+
+template <typename... Ts, typename... Excluded, typename Function>
+void World::parallelEach(Without<Excluded...>, Function&& function) {
+    runParallel<Ts...>(findQuery(maskOf<Ts...>(), maskOf<Excluded...>()), function);
+}
+
+template <typename... Ts, typename Function>
+void World::run(Query& query, Function& function) {
+    static_assert(!(std::is_empty<Ts>::value || ...), "Tags can only be used to filter queries");
+    refreshQuery(query);
+
+    for (Archetype* archetype : query.archetypes) {
+        for (auto& chunk : archetype->chunks) {
+            runChunk<Ts...>(*archetype, *chunk, function);
+        }
+    }
+}
+
+// One job batch is a range of whole chunks, so two threads never touch the same chunk
+template <typename... Ts, typename Function>
+void World::runParallel(Query& query, Function& function) {
+    static_assert(!(std::is_empty<Ts>::value || ...), "Tags can only be used to filter queries");
+    refreshQuery(query);
+
+    std::vector<std::pair<Archetype*, Archetype::Chunk*>> chunks;
+    for (Archetype* archetype : query.archetypes) {
+        for (auto& chunk : archetype->chunks) {
+            if (chunk->count > 0) {
+                chunks.emplace_back(archetype, chunk.get());
+            }
+        }
+    }
+
+    JobSystem::jobSystem.parallelFor(chunks.size(), 1, [&chunks, &function](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            runChunk<Ts...>(*chunks[i].first, *chunks[i].second, function);
+        }
+    });
+}
+
+template <typename... Ts, typename Function>
+void World::runChunk(Archetype& archetype, Archetype::Chunk& chunk, Function& function) {
+    Entity* entities = archetype.entities(chunk);
+    std::tuple<Ts*...> columns(static_cast<Ts*>(archetype.columnData(chunk, componentId<Ts>()))...);
+
+    const uint32_t count = chunk.count;
+    for (uint32_t row = 0; row < count; ++row) {
+        function(entities[row], std::get<Ts*>(columns)[row]...);
+    }
+}
+
+#endif // ECS_H
@@ -1,115 +1,209 @@
 ﻿#include "GameObject.h"
 #include <iostream>
 #include <string>
-#include <iomanip>
-#include <sstream>
-#include <random>
 #include <fstream>
+#include <cmath>
 #include "Importer.h"
 #include "ConsoleWindow.h"
 #include "SimulationManager.h"
+#include "CullingSystem.h"
+#include "GpuMesh.h"
+#include "StaticBatcher.h"
+#include "DebugDraw.h"
 
 extern Importer importer;
-std::vector<GameObject> gameObjects;
+std::unordered_map<ObjectID, GameObject*> GameObject::objectsByID;
+
+namespace {
+    // Static objects sit in the culling octree and in a static batch, both rebuilt when the editor moves,
+    // reshapes or retextures one
+    void staticContentEdited(const GameObject& object) {
+        if (!object.isDynamic()) {
+            CullingSystem::cullingSystem.invalidateStatic();
+            StaticBatcher::staticBatcher.invalidate(object.entity);
+        }
+    }
+
+    std::string primitivePath(const std::string& primitiveType) {
+        std::string filePath = "Assets/Primitives/";
+
+        if (primitiveType == "Sphere") {
+            filePath += "sphere.fbx";
+        }
+        else if (primitiveType == "Cube") {
+            filePath += "cube.fbx";
+        }
+        else if (primitiveType == "Cylinder") {
+            filePath += "cylinder.fbx";
+        }
+        else if (primitiveType == "Cone") {
+            filePath += "cone.fbx";
+        }
+        else if (primitiveType == "Torus") {
+            filePath += "torus.fbx";
+        }
+        else if (primitiveType == "Plane") {
+            filePath += "plane.fbx";
+        }
+        return filePath;
+    }
+}
 
 GameObject::GameObject(const std::string& name, const MeshData& mesh, GLuint texID, const std::string& texPath)
-    : name(name)
-    , meshData(mesh)
-    , textureID(texID)
-    , texturePath(texPath)
-    , position(0.0f)
+    : uuid(ObjectID::generate())
+    , name(name)
     , rotation(0.0f)
-    , scale(1.0f)
-    , uuid(GenerateUUID())
-    , elapsedPausedTime(0.0f)
-    , parent(nullptr)
-    , movementState(MovementState::Stopped)
-    , active(true) {
-    setTexture(texPath, texID);
-    initialPosition = position;
+    , texturePath(texPath)
+    , parent(nullptr) {
+    World& world = World::world;
+    entity = world.create();
+    world.add(entity, TransformComponent{ TransformStore::transformStore.add(entity) });
+    world.add(entity, HierarchyComponent{});
+    world.add(entity, EditorObjectComponent{ this });
+
+    objectsByID[uuid] = this;
+
+    setMeshData(mesh);
+    if (texID != 0) {
+        setTexture(texPath, texID);
+    }
+
+    initialPosition = getPosition();
     initialRotation = rotation;
-    initialScale = scale;
-    console.addLog("GameObject created with UUID: " + uuid);
+    initialScale = getScale();
+    console.addLog("GameObject created with UUID: " + uuid.toString());
 }
 
-void GameObject::updateMovement(float deltaTime) {
-    if (dynamic && movementState == MovementState::Running) {
-        position.x += movementDirection * speed * deltaTime;
-        if (position.x >= movementRange.second || position.x <= movementRange.first) {
-            movementDirection *= -1; 
-        }
-        console.addLog("Dynamic: " + std::to_string(dynamic));
+GameObject::~GameObject() {
+    TransformStore::transformStore.remove(getTransformIndex());
+    World::world.destroy(entity);
+}
+
+// Called by the pool as soon as destruction is requested: the object disappears from the
+// hierarchy, the ID index and the renderer, the memory itself is released at the end of the frame
+void GameObject::prepareForDestroy() {
+    if (parent) {
+        parent->removeChild(this);
+    }
+    std::vector<GameObject*> childrenCopy = children;
+    for (GameObject* child : childrenCopy) {
+        removeChild(child);
+    }
 
+    auto it = objectsByID.find(uuid);
+    if (it != objectsByID.end() && it->second == this) {
+        objectsByID.erase(it);
     }
+    setActive(false);
 }
 
-void GameObject::startMovement() {
-    if (movementState != MovementState::Running) {
-        movementState = MovementState::Running;
-        startTime = std::chrono::high_resolution_clock::now() - std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(std::chrono::duration<float>(elapsedPausedTime));
-        console.addLog(name + " started moving.");
+void GameObject::setUUID(const ObjectID& newID) {
+    auto it = objectsByID.find(uuid);
+    if (it != objectsByID.end() && it->second == this) {
+        objectsByID.erase(it);
     }
+    uuid = newID;
+    objectsByID[uuid] = this;
 }
 
-void GameObject::pauseMovement() {
-    if (movementState == MovementState::Running) {
-        movementState = MovementState::Paused;
-        auto currentTime = std::chrono::high_resolution_clock::now();
-        elapsedPausedTime = std::chrono::duration<float>(currentTime - startTime).count();
-        console.addLog(name + " paused movement.");
+GameObject* GameObject::findByID(const ObjectID& id) {
+    auto it = objectsByID.find(id);
+    return it != objectsByID.end() ? it->second : nullptr;
+}
+
+void GameObject::setTexture(const std::string& path, GLuint texID) {
+    texturePath = path;
+
+    MeshRendererComponent* renderer = World::world.tryGet<MeshRendererComponent>(entity);
+    if (!renderer) {
+        renderer = &World::world.add(entity, MeshRendererComponent{ &meshData, 0 });
     }
+    renderer->textureID = texID;
+    staticContentEdited(*this);
+}
+
+GLuint GameObject::getTextureID() const {
+    const MeshRendererComponent* renderer = World::world.tryGet<MeshRendererComponent>(entity);
+    return renderer ? renderer->textureID : 0;
 }
 
-void GameObject::stopMovement() {
-    if (movementState != MovementState::Stopped) {
-        movementState = MovementState::Stopped;
-        elapsedPausedTime = 0.0f; 
-        movementDirection = 1.0f;
-        console.addLog(name + " stopped and reset position.");
+// Objects with geometry get the components the renderer queries for
+void GameObject::setMeshData(const MeshData& data) {
+    if (&data != &meshData) {
+        // Every object made from the same mesh shares one set of GPU buffers, uploaded on the first draw
+        if (!data.gpu) {
+            data.gpu = std::make_shared<GpuMesh>();
+        }
+        meshData = data;
+    }
+    else {
+        // Edited in place, e.g. loaded from a scene file: any picking tree or GPU copy is out of date
+        meshData.bvh.reset();
+        meshData.gpu.reset();
+    }
+    if (meshData.vertices.empty()) {
+        return;
     }
+
+    World& world = World::world;
+    if (!world.has<MeshRendererComponent>(entity)) {
+        world.add(entity, MeshRendererComponent{ &meshData, 0 });
+    }
+    BoundingBoxGeneration();
+    staticContentEdited(*this);
 }
 
-// Generate a random UUID to identify each object uniquely
-std::string GameObject::GenerateUUID() {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(0, 15);
-    std::uniform_int_distribution<> dis2(8, 11);
+// Local bounds from the mesh's vertices, its GPU buffers and picking tree are kept
+void GameObject::BoundingBoxGeneration() {
+    if (meshData.vertices.empty()) {
+        return;
+    }
 
-    std::stringstream ss;
-    ss << std::hex;
+    BoundsComponent bounds;
+    bounds.localMin = glm::vec3(FLT_MAX);
+    bounds.localMax = glm::vec3(-FLT_MAX);
+    for (size_t i = 0; i + 2 < meshData.vertices.size(); i += 3) {
+        glm::vec3 vertex(meshData.vertices[i], meshData.vertices[i + 1], meshData.vertices[i + 2]);
+        bounds.localMin = glm::min(bounds.localMin, vertex);
+        bounds.localMax = glm::max(bounds.localMax, vertex);
+    }
+    World::world.add(entity, bounds);
+}
 
-    for (int i = 0; i < 8; i++) {
-        ss << dis(gen);
+void GameObject::setActive(bool isActive) {
+    if (isActive) {
+        World::world.remove<InactiveTag>(entity);
     }
-    ss << "-";
-    for (int i = 0; i < 4; i++) {
-        ss << dis(gen);
+    else {
+        World::world.add(entity, InactiveTag{});
     }
-    ss << "-4";
-    for (int i = 0; i < 3; i++) {
-        ss << dis(gen);
+}
+
+void GameObject::setDynamic(bool isDynamic) {
+    if (isDynamic == this->isDynamic()) {
+        return;
     }
-    ss << "-";
-    ss << dis2(gen);
-    for (int i = 0; i < 3; i++) {
-        ss << dis(gen);
+    if (isDynamic) {
+        World::world.add(entity, MovementComponent{});
     }
-    ss << "-";
-    for (int i = 0; i < 12; i++) {
-        ss << dis(gen);
+    else {
+        World::world.remove<MovementComponent>(entity);
     }
-    return ss.str();
 }
 
-void GameObject::setTexture(const std::string& path, GLuint texID) {
-    texturePath = path;
-    textureID = texID;
+void GameObject::setOccluder(bool isOccluder) {
+    if (isOccluder) {
+        World::world.add(entity, OccluderTag{});
+    }
+    else {
+        World::world.remove<OccluderTag>(entity);
+    }
 }
 
 void GameObject::loadTextureFromPath() {
     if (!texturePath.empty()) {
-        textureID = importer.loadTexture(texturePath);
+        GLuint textureID = importer.loadTexture(texturePath);
+        setTexture(texturePath, textureID);
         if (textureID == 0) {
             console.addLog("Failed to load texture from: " + texturePath);
         }
@@ -121,55 +215,62 @@ void GameObject::loadTextureFromPath() {
 
 // Adds a child object to the list of children of this object
 void GameObject::addChild(GameObject* child) {
-    child->parent = this;
+    if (child == this || child->parent == this) {
+        return;
+    }
+    if (child->parent != nullptr) {
+        child->parent->removeChild(child);
+    }
 
-    child->initialPosition = child->position - this->position;  
-    child->initialRotation = child->rotation - this->rotation; 
-    child->initialScale = child->scale / this->scale;
+    // Re-express the child relative to its new parent so it keeps its place in the world
+    glm::mat4 local = glm::inverse(getFinalTransformMatrix()) * child->getFinalTransformMatrix();
+    glm::vec3 localPosition, localScale;
+    glm::quat localRotation;
+    TransformStore::decompose(local, localPosition, localRotation, localScale);
 
-    children.push_back(child);
+    child->setParentLink(this);
+    child->setLocalTransform(localPosition, TransformStore::quatToEuler(localRotation), localScale);
+
+    child->initialPosition = child->getPosition();
+    child->initialRotation = child->rotation;
+    child->initialScale = child->getScale();
 
-    updateChildTransforms();
+    children.push_back(child);
 }
 
 void GameObject::removeChild(GameObject* child) {
     auto it = std::find(children.begin(), children.end(), child);
 
     if (it != children.end()) {
+        glm::vec3 worldPosition, worldRotation, worldScale;
+        child->getWorldTransform(worldPosition, worldRotation, worldScale);
+
         children.erase(it);
-        child->parent = nullptr;
+        child->setParentLink(nullptr);
+        child->setLocalTransform(worldPosition, worldRotation, worldScale);
     }
 }
 
+// Keeps the editor pointer, the hierarchy component and the transform store in agreement
+void GameObject::setParentLink(GameObject* newParent) {
+    parent = newParent;
+    World::world.get<HierarchyComponent>(entity).parent = newParent ? newParent->entity : Entity();
+    TransformStore::transformStore.setParent(getTransformIndex(), newParent ? newParent->getTransformIndex() : -1);
+
+    // A new parent can turn the object from static to dynamic or back
+    CullingSystem::cullingSystem.invalidateStatic();
+}
+
 void GameObject::createPrimitive(const std::string& primitiveType, std::vector<GameObject*>& gameObjects) {
     MeshData meshData;
     GLuint textureID = 0;
-    std::string filePath = "Assets/Primitives/";
-
-    if (primitiveType == "Sphere") {
-        filePath += "sphere.fbx";
-    }
-    else if (primitiveType == "Cube") {
-        filePath += "cube.fbx";
-    }
-    else if (primitiveType == "Cylinder") {
-        filePath += "cylinder.fbx";
-    }
-    else if (primitiveType == "Cone") {
-        filePath += "cone.fbx";
-    }
-    else if (primitiveType == "Torus") {
-        filePath += "torus.fbx";
-    }
-    else if (primitiveType == "Plane") {
-        filePath += "plane.fbx";
-    }
+    const std::string filePath = primitivePath(primitiveType);
 
     try {
         std::vector<MeshData> meshes = importer.loadFBX(filePath, textureID);
         if (!meshes.empty()) {
             meshData = meshes[0];
-            GameObject* modelObject = new GameObject(primitiveType, meshData, textureID);
+            GameObject* modelObject = GameObjectPool::pool.create(primitiveType, meshData, textureID);
             gameObjects.push_back(modelObject);
             SimulationManager::simulationManager.trackObject(modelObject);
             console.addLog("Model " + primitiveType + " loaded from " + filePath);
@@ -180,10 +281,36 @@ void GameObject::createPrimitive(const std::string& primitiveType, std::vector<G
     }
 }
 
+// Many copies of one primitive on a square grid around the origin, all sharing the same mesh buffers.
+// Used to stress the renderer's batching, culling and picking.
+void GameObject::createStressScene(const std::string& primitiveType, int copies, std::vector<GameObject*>& gameObjects) {
+    const float spacing = 2.0f;
+    GLuint textureID = 0;
+    const std::string filePath = primitivePath(primitiveType);
+
+    try {
+        std::vector<MeshData> meshes = importer.loadFBX(filePath, textureID);
+        if (meshes.empty()) return;
+
+        const int side = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(copies))));
+        const float offset = (side - 1) * spacing * 0.5f;
+        for (int i = 0; i < copies; i++) {
+            GameObject* copy = GameObjectPool::pool.create(primitiveType + "_" + std::to_string(i), meshes[0], textureID);
+            copy->setPosition(glm::vec3((i % side) * spacing - offset, 0.0f, (i / side) * spacing - offset));
+            gameObjects.push_back(copy);
+            SimulationManager::simulationManager.trackObject(copy);
+        }
+        console.addLog("Stress scene: " + std::to_string(copies) + " copies of " + primitiveType);
+    }
+    catch (const std::exception& e) {
+        console.addLog("Error when loading model " + primitiveType + ": " + e.what());
+    }
+}
+
 void GameObject::createEmptyObject(const std::string& name, std::vector<GameObject*>& gameObjects) {
     MeshData emptyMeshData;
     GLuint emptyTextureID = 0;
-    GameObject* emptyObject = new GameObject(name, emptyMeshData, emptyTextureID);
+    GameObject* emptyObject = GameObjectPool::pool.create(name, emptyMeshData, emptyTextureID);
 
     gameObjects.push_back(emptyObject);
     SimulationManager::simulationManager.trackObject(emptyObject);
@@ -193,65 +320,28 @@ void GameObject::createEmptyObject(const std::string& name, std::vector<GameObje
 void GameObject::createCameraObject(const std::string& name, std::vector<GameObject*>& gameObjects) {
     MeshData emptyMeshData;
     GLuint emptyTextureID = 0;
-    GameObject* emptyObject = new GameObject(name, emptyMeshData, emptyTextureID);
+    GameObject* emptyObject = GameObjectPool::pool.create(name, emptyMeshData, emptyTextureID);
 
-    emptyObject->isCamera = true;
+    World::world.add(emptyObject->entity, CameraComponent{});
 
     gameObjects.push_back(emptyObject);
     SimulationManager::simulationManager.trackObject(emptyObject);
     console.addLog("Camera object created");
-
-    // Call the method for drawing the bounding box at the origin (0, 0, 0)
-    emptyObject->DrawBoundingBox();
 }
+// Local bounds through the world matrix, a unit box for objects without a mesh such as cameras
 void GameObject::DrawBoundingBox() {
-    glPushMatrix();
-
-    glTranslatef(0.0f, 0.0f, 0.0f);
-
-	glColor3f(1.0f, 0.0f, 0.0f);  // Red colour for the bounding box
-
-    glBegin(GL_LINES);
-
-    float size = 1.0f;
-
-    glm::vec3 v0(-size / 2, -size / 2, -size / 2);
-    glm::vec3 v1(size / 2, -size / 2, -size / 2);
-    glm::vec3 v2(size / 2, size / 2, -size / 2);
-    glm::vec3 v3(-size / 2, size / 2, -size / 2);
-    glm::vec3 v4(-size / 2, -size / 2, size / 2);
-    glm::vec3 v5(size / 2, -size / 2, size / 2);
-    glm::vec3 v6(size / 2, size / 2, size / 2);
-    glm::vec3 v7(-size / 2, size / 2, size / 2);
-
-    // Draw the 12 lines of the cube(connecting the vertices).
-    glVertex3f(v0.x, v0.y, v0.z); glVertex3f(v1.x, v1.y, v1.z);  // Line 1
-    glVertex3f(v1.x, v1.y, v1.z); glVertex3f(v2.x, v2.y, v2.z);  // Line 2
-    glVertex3f(v2.x, v2.y, v2.z); glVertex3f(v3.x, v3.y, v3.z);  // Line 3
-    glVertex3f(v3.x, v3.y, v3.z); glVertex3f(v0.x, v0.y, v0.z);  // Line 4
-
-    glVertex3f(v4.x, v4.y, v4.z); glVertex3f(v5.x, v5.y, v5.z);  // Line 5
-    glVertex3f(v5.x, v5.y, v5.z); glVertex3f(v6.x, v6.y, v6.z);  // Line 6
-    glVertex3f(v6.x, v6.y, v6.z); glVertex3f(v7.x, v7.y, v7.z);  // Line 7
-    glVertex3f(v7.x, v7.y, v7.z); glVertex3f(v4.x, v4.y, v4.z);  // Line 8
-
-    glVertex3f(v0.x, v0.y, v0.z); glVertex3f(v4.x, v4.y, v4.z);  // Line 9
-    glVertex3f(v1.x, v1.y, v1.z); glVertex3f(v5.x, v5.y, v5.z);  // Line 10
-    glVertex3f(v2.x, v2.y, v2.z); glVertex3f(v6.x, v6.y, v6.z);  // Line 11
-    glVertex3f(v3.x, v3.y, v3.z); glVertex3f(v7.x, v7.y, v7.z);  // Line 12
-
-    glEnd();
-
-    glPopMatrix();   // Restores the state of the transformation matrix
+    const BoundsComponent* bounds = World::world.tryGet<BoundsComponent>(entity);
+    if (bounds && bounds->localMin != bounds->localMax) {
+        DebugDraw::debugDraw.box(AABB(bounds->localMin, bounds->localMax), getWorldMatrix(), glm::vec3(1.0f, 1.0f, 0.0f));
+    }
+    else {
+        DebugDraw::debugDraw.box(AABB(glm::vec3(-0.5f), glm::vec3(0.5f)), getWorldMatrix(), glm::vec3(1.0f, 0.0f, 0.0f));
+    }
 }
 glm::mat4 GameObject::getTransformMatrix() const {
-    glm::mat4 transform = glm::mat4(1.0f);
-    transform = glm::translate(transform, position);
-    transform = glm::rotate(transform, glm::radians(rotation.x), glm::vec3(1, 0, 0));
-    transform = glm::rotate(transform, glm::radians(rotation.y), glm::vec3(0, 1, 0));
-    transform = glm::rotate(transform, glm::radians(rotation.z), glm::vec3(0, 0, 1));
-    transform = glm::scale(transform, scale);
-    return transform;
+    const TransformStore& store = TransformStore::transformStore;
+    const int index = getTransformIndex();
+    return TransformStore::composeTRS(store.positions[index], store.rotations[index], store.scales[index]);
 }
 
 // Transforms for parenting logic
@@ -264,133 +354,72 @@ glm::mat4 GameObject::getFinalTransformMatrix() const {
     return localTransform;
 }
 
-void GameObject::updateChildTransforms() {
-    for (GameObject* child : children) {
-        child->position = this->position + child->initialPosition;
-        child->rotation = this->rotation + child->initialRotation;
-        child->scale = this->scale * child->initialScale;
-
-        child->updateChildTransforms();
-    }
-}
-
 void GameObject::setPosition(const glm::vec3& newPosition) {
-    position = newPosition;
-    RegenerateCorners();
+    TransformStore::transformStore.positions[getTransformIndex()] = newPosition;
+    staticContentEdited(*this);
 }
 
 void GameObject::setRotation(const glm::vec3& newRotation) {
     rotation = newRotation;
+    TransformStore::transformStore.rotations[getTransformIndex()] = TransformStore::eulerToQuat(newRotation);
+    staticContentEdited(*this);
 }
 
 void GameObject::setScale(const glm::vec3& newScale) {
-    scale = newScale;
-    RegenerateCorners();
+    TransformStore::transformStore.scales[getTransformIndex()] = newScale;
+    staticContentEdited(*this);
 }
 
-void GameObject::resetTransform() {
-    position = initialPosition;
-    rotation = initialRotation;
-    scale = initialScale;
-
-    movementDirection = 1.0f;
-
-    if (parent != nullptr) {
-        parent->updateChildTransforms();
-    }
+void GameObject::setLocalTransform(const glm::vec3& newPosition, const glm::vec3& newRotation, const glm::vec3& newScale) {
+    rotation = newRotation;
+    TransformStore::transformStore.setLocal(getTransformIndex(), newPosition, TransformStore::eulerToQuat(newRotation), newScale);
+    staticContentEdited(*this);
 }
 
-void GameObject::BoundingBoxGeneration() {
-    console.addLog("Doing bounding box !!!");
-    MeshData* meshData = getMeshData();
-    if (meshData) {
-        glm::vec3 minLocal(FLT_MAX, FLT_MAX, FLT_MAX);
-        glm::vec3 maxLocal(-FLT_MAX, -FLT_MAX, -FLT_MAX);
-
-        for (size_t i = 0; i < meshData->vertices.size(); i += 3) {
-            glm::vec3 vertex(meshData->vertices[i], meshData->vertices[i + 1], meshData->vertices[i + 2]);
-            minLocal = glm::min(minLocal, vertex);
-            maxLocal = glm::max(maxLocal, vertex);
-        }
-        boundingBoxMinLocal = minLocal;
-        boundingBoxMaxLocal = maxLocal; 
+// World placement, computed through the parent chain so it's valid before the next store sweep
+void GameObject::getWorldTransform(glm::vec3& outPosition, glm::vec3& outRotation, glm::vec3& outScale) const {
+    if (parent == nullptr) {
+        outPosition = getPosition();
+        outRotation = rotation;
+        outScale = getScale();
+        return;
     }
 
-    RegenerateCorners();
+    glm::quat worldRotation;
+    TransformStore::decompose(getFinalTransformMatrix(), outPosition, worldRotation, outScale);
+    outRotation = TransformStore::quatToEuler(worldRotation);
 }
-void GameObject::DrawVertex() {
-    console.addLog("Entra en la funcion de dibujar los vertices");
 
-    MeshData* meshData = getMeshData();
-    if (meshData) {
-        glLineWidth(2.0f);
-        glBegin(GL_LINES);
-        glBindTexture(GL_TEXTURE_2D, 0);
+void GameObject::resetTransform() {
+    setLocalTransform(initialPosition, initialRotation, initialScale);
 
-        for (size_t i = 0; i < meshData->vertices.size(); i += 3) {
-            glm::vec3 vertex1(meshData->vertices[i], meshData->vertices[i + 1], meshData->vertices[i + 2]);
+    if (MovementComponent* movement = World::world.tryGet<MovementComponent>(entity)) {
+        movement->direction = 1;
+    }
+}
 
-            if (i + 3 < meshData->vertices.size()) {
-                glm::vec3 vertex2(meshData->vertices[i + 3], meshData->vertices[i + 4], meshData->vertices[i + 5]);
+// The mesh's vertices joined in order, as a wireframe
+void GameObject::DrawVertex() {
+    const MeshData* meshData = getMeshData();
+    if (meshData && !meshData->vertices.empty()) {
+        DebugDraw::debugDraw.lineStrip(meshData->vertices.data(), meshData->vertices.size() / 3, getWorldMatrix(), glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+}
 
-                glColor3f(0.0f, 1.0f, 0.0f);  // Green colour
-				glVertex3f(vertex1.x, vertex1.y, vertex1.z);  // First vertex
-				glVertex3f(vertex2.x, vertex2.y, vertex2.z);  // Second vertex
-            }
-        }
-        glEnd();
-    }
-}
-
-void GameObject::RegenerateCorners()
-{
-    glm::mat4 transMatrix = glm::translate(glm::mat4(1.0f), position);
-    glm::mat4 rotMatrix = glm::mat4(1.0f);
-    rotMatrix = glm::rotate(rotMatrix, rotation.x, glm::vec3(1.0f, 0.0f, 0.0f));
-    rotMatrix = glm::rotate(rotMatrix, rotation.y, glm::vec3(0.0f, 1.0f, 0.0f));
-    rotMatrix = glm::rotate(rotMatrix, rotation.z, glm::vec3(0.0f, 0.0f, 1.0f));
-    glm::mat4 scaleMatrix = glm::scale(glm::mat4(1.0f), scale);
-
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-
-    glm::vec3 temp[8] = {
-         glm::vec3(boundingBoxMinLocal.x, boundingBoxMinLocal.y, boundingBoxMinLocal.z),  // V0
-         glm::vec3(boundingBoxMaxLocal.x, boundingBoxMinLocal.y, boundingBoxMinLocal.z),  // V1
-         glm::vec3(boundingBoxMinLocal.x, boundingBoxMaxLocal.y, boundingBoxMinLocal.z),  // V2
-         glm::vec3(boundingBoxMaxLocal.x, boundingBoxMaxLocal.y, boundingBoxMinLocal.z),  // V3
-         glm::vec3(boundingBoxMinLocal.x, boundingBoxMinLocal.y, boundingBoxMaxLocal.z),  // V4
-         glm::vec3(boundingBoxMaxLocal.x, boundingBoxMinLocal.y, boundingBoxMaxLocal.z),  // V5
-         glm::vec3(boundingBoxMinLocal.x, boundingBoxMaxLocal.y, boundingBoxMaxLocal.z),  // V6
-         glm::vec3(boundingBoxMaxLocal.x, boundingBoxMaxLocal.y, boundingBoxMaxLocal.z)   // V7
-    };
-
-    std::copy(std::begin(temp), std::end(temp), corners);
-    
-	glColor3f(1.0f, 1.0f, 0.0f);    //Yellow colour
-
-    // Draw the 12 edges of the bounding box using lines
-    glBegin(GL_LINES);
-
-    // Bottom part (edges of the minWorld.z plane)
-    glVertex3fv(glm::value_ptr(corners[0])); glVertex3fv(glm::value_ptr(corners[1])); // V0 ↔ V1
-    glVertex3fv(glm::value_ptr(corners[1])); glVertex3fv(glm::value_ptr(corners[3])); // V1 ↔ V3
-    glVertex3fv(glm::value_ptr(corners[3])); glVertex3fv(glm::value_ptr(corners[2])); // V3 ↔ V2
-    glVertex3fv(glm::value_ptr(corners[2])); glVertex3fv(glm::value_ptr(corners[0])); // V2 ↔ V0
-
-    // Upper part (edges of the maxWorld.z plane)
-    glVertex3fv(glm::value_ptr(corners[4])); glVertex3fv(glm::value_ptr(corners[5])); // V4 ↔ V5
-    glVertex3fv(glm::value_ptr(corners[5])); glVertex3fv(glm::value_ptr(corners[7])); // V5 ↔ V7
-    glVertex3fv(glm::value_ptr(corners[7])); glVertex3fv(glm::value_ptr(corners[6])); // V7 ↔ V6
-    glVertex3fv(glm::value_ptr(corners[6])); glVertex3fv(glm::value_ptr(corners[4])); // V6 ↔ V4
-
-    // Vertical connections (lower vertices to upper vertices)
-    glVertex3fv(glm::value_ptr(corners[0])); glVertex3fv(glm::value_ptr(corners[4])); // V0 ↔ V4
-    glVertex3fv(glm::value_ptr(corners[1])); glVertex3fv(glm::value_ptr(corners[5])); // V1 ↔ V5
-    glVertex3fv(glm::value_ptr(corners[2])); glVertex3fv(glm::value_ptr(corners[6])); // V2 ↔ V6
-    glVertex3fv(glm::value_ptr(corners[3])); glVertex3fv(glm::value_ptr(corners[7])); // V3 ↔ V7
-
-    glEnd();
-
-    glPopMatrix();
-}
\ No newline at end of file
+void GameObject::getLocalCorners(glm::vec3 corners[8]) const {
+    BoundsComponent bounds;
+    if (const BoundsComponent* meshBounds = World::world.tryGet<BoundsComponent>(entity)) {
+        bounds = *meshBounds;
+    }
+    const glm::vec3& boundingBoxMinLocal = bounds.localMin;
+    const glm::vec3& boundingBoxMaxLocal = bounds.localMax;
+
+    corners[0] = glm::vec3(boundingBoxMinLocal.x, boundingBoxMinLocal.y, boundingBoxMinLocal.z);  // V0
+    corners[1] = glm::vec3(boundingBoxMaxLocal.x, boundingBoxMinLocal.y, boundingBoxMinLocal.z);  // V1
+    corners[2] = glm::vec3(boundingBoxMinLocal.x, boundingBoxMaxLocal.y, boundingBoxMinLocal.z);  // V2
+    corners[3] = glm::vec3(boundingBoxMaxLocal.x, boundingBoxMaxLocal.y, boundingBoxMinLocal.z);  // V3
+    corners[4] = glm::vec3(boundingBoxMinLocal.x, boundingBoxMinLocal.y, boundingBoxMaxLocal.z);  // V4
+    corners[5] = glm::vec3(boundingBoxMaxLocal.x, boundingBoxMinLocal.y, boundingBoxMaxLocal.z);  // V5
+    corners[6] = glm::vec3(boundingBoxMinLocal.x, boundingBoxMaxLocal.y, boundingBoxMaxLocal.z);  // V6
+    corners[7] = glm::vec3(boundingBoxMaxLocal.x, boundingBoxMaxLocal.y, boundingBoxMaxLocal.z);  // V7
+}
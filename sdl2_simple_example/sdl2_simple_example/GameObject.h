@@ -2,6 +2,7 @@
 #define GAMEOBJECT_H
 
 #include <chrono>
+#include <memory>
 #include <vector>
 #include <string>
 #include <glm/glm.hpp>
@@ -11,6 +12,15 @@
 #include <cereal/types/string.hpp>
 #include <cereal/archives/json.hpp>
 #include <GL/glew.h>
+#include "TransformStore.h"
+#include "ECS.h"
+#include "Components.h"
+#include "ObjectID.h"
+#include "GameObjectPool.h"
+#include <unordered_map>
+
+class MeshBVH;
+class GpuMesh;
 
 struct MeshData {
     std::string name;
@@ -20,6 +30,11 @@ struct MeshData {
     std::vector<GLfloat> normals;
     glm::mat4 transform;
 
+    // Picking tree over the triangles, built by MeshBVH::of and shared with copies of the mesh
+    mutable std::shared_ptr<const MeshBVH> bvh;
+    // GL buffers, filled by GpuMesh::of on the first draw and shared with copies of the mesh
+    mutable std::shared_ptr<GpuMesh> gpu;
+
     template <class Archive>
     void serialize(Archive& archive) {
         archive(CEREAL_NVP(name), CEREAL_NVP(vertices), CEREAL_NVP(indices), CEREAL_NVP(textCoords), CEREAL_NVP(transform));
@@ -43,23 +58,15 @@ namespace glm {
     }
 }
 
-enum class MovementState {
-    Stopped,
-    Running,
-    Paused
-};
-
 class GameObject {
 public:
-    std::string uuid;
+    ObjectID uuid;
     std::string name;
-    glm::vec3 position;
-    glm::vec3 rotation;
-    glm::vec3 scale;
-    bool isCamera = false;
+    // Editor facade over an ECS entity: transform, rendering, movement and bounds live in its components
+    Entity entity;
+    glm::vec3 rotation;     // Euler degrees as edited in the Inspector
 
     MeshData meshData;
-    GLuint textureID;
     std::string texturePath;
 
     glm::vec3 initialPosition;
@@ -67,50 +74,46 @@ public:
     glm::vec3 initialScale;
 
     static std::vector<GameObject*> gameObjects;
-    std::vector<std::string> pendingChildUUIDs;
+    std::vector<ObjectID> pendingChildUUIDs;
     std::vector<GameObject*> children;
     GameObject* parent = nullptr;
 
-    glm::mat4 globalTransform;
-
-    // Simulation States
-    MovementState movementState;
-    int movementDirection;
-    float speed;
-    float elapsedPausedTime = 0.0f;
-    std::pair<float, float> movementRange;
-    std::chrono::time_point<std::chrono::high_resolution_clock> startTime;
-
-    bool active = true;
-    bool dynamic = false;
     bool fromScene = false;
 
-    GameObject(const std::string& name, const MeshData& mesh, GLuint texID, const std::string& texPath = "");
+    // Slot of the object in the GameObjectPool, prefer it over raw pointers for long-lived references
+    GameObjectHandle handle;
+
+    GameObject(const GameObject&) = delete;
+    GameObject& operator=(const GameObject&) = delete;
 
-    const std::string& getUUID() const { return uuid; };
+    const ObjectID& getUUID() const { return uuid; };
+    void setUUID(const ObjectID& newID);
 
-    void updateMovement(float deltaTime);
-    void startMovement();
-    void pauseMovement();
-    void stopMovement();
+    // O(1) lookup through the global ID index, nullptr if no live object has that ID
+    static GameObject* findByID(const ObjectID& id);
 
     // PARENTING
     void addChild(GameObject* child);
     void removeChild(GameObject* child);
-    void updateChildTransforms();
+    void setParentLink(GameObject* newParent);
     glm::mat4 getFinalTransformMatrix() const;
+    int getTransformIndex() const { return World::world.get<TransformComponent>(entity).transformIndex; }
+    const glm::mat4& getWorldMatrix() const { return TransformStore::transformStore.worldMatrices[getTransformIndex()]; }
+    glm::vec3 getWorldPosition() const { return glm::vec3(getFinalTransformMatrix()[3]); }
 
     static void createPrimitive(const std::string& primitiveType, std::vector<GameObject*>& gameObjects);
+    static void createStressScene(const std::string& primitiveType, int copies, std::vector<GameObject*>& gameObjects);
     static void createEmptyObject(const std::string& name, std::vector<GameObject*>& gameObjects);
     static void createCameraObject(const std::string& name, std::vector<GameObject*>& gameObjects);
+    // Queued in the debug draw lists, drawn at the end of the frame
     void DrawBoundingBox();
     static void createDynamicObject(const std::string& name, std::vector<GameObject*>& gameObjects);
     glm::mat4 getTransformMatrix() const;
 
     const std::string& getName() const { return name; }
-    glm::vec3 getPosition() const { return position; }
+    glm::vec3 getPosition() const { return TransformStore::transformStore.positions[getTransformIndex()]; }
     glm::vec3 getRotation() const { return rotation; }
-    glm::vec3 getScale() const { return scale; }
+    glm::vec3 getScale() const { return TransformStore::transformStore.scales[getTransformIndex()]; }
 
     void setPosition(const glm::vec3& newPosition);
     void setRotation(const glm::vec3& newRotation);
@@ -118,44 +121,91 @@ public:
     void resetTransform();
 
     void BoundingBoxGeneration();
-    void RegenerateCorners();
-    glm::vec3 boundingBoxMinLocal;
-    glm::vec3 boundingBoxMaxLocal;
-    glm::vec3 corners[8];
+    void getLocalCorners(glm::vec3 corners[8]) const;
 
     void DrawVertex();
     std::vector<glm::vec3>  selectedVertices;
 
     void setTexture(const std::string& path, GLuint texID);
     void loadTextureFromPath();
+    GLuint getTextureID() const;
 
-    static std::string GenerateUUID();
 
     MeshData* getMeshData() { return &meshData; }
-    void setMeshData(const MeshData& data) { meshData = data; }
+    void setMeshData(const MeshData& data);
+
+    bool getActive() const { return !World::world.has<InactiveTag>(entity); }
+    void setActive(bool isActive);
 
-    bool getActive() const { return active; }
-    void setActive(bool isActive) { active = isActive; }
+    bool isCamera() const { return World::world.has<CameraComponent>(entity); }
+    bool isDynamic() const { return World::world.has<MovementComponent>(entity); }
+    void setDynamic(bool isDynamic);
+
+    bool isOccluder() const { return World::world.has<OccluderTag>(entity); }
+    void setOccluder(bool isOccluder);
+
+    void setLocalTransform(const glm::vec3& newPosition, const glm::vec3& newRotation, const glm::vec3& newScale);
+    void getWorldTransform(glm::vec3& outPosition, glm::vec3& outRotation, glm::vec3& outScale) const;
 
     template <class Archive>
     void serialize(Archive& archive) {
+        // Scenes store world placement, children get re-expressed relative to their parent on load
+        glm::vec3 position, scale;
+        glm::vec3 rotation = this->rotation;
+        std::string uuid = this->uuid.toString();
+        GLuint textureID = getTextureID();
+        bool active = getActive();
+        bool dynamic = isDynamic();
+        if constexpr (Archive::is_saving::value) {
+            getWorldTransform(position, rotation, scale);
+        }
+
         archive(CEREAL_NVP(uuid), CEREAL_NVP(name), CEREAL_NVP(position), CEREAL_NVP(rotation),
             CEREAL_NVP(scale), CEREAL_NVP(meshData), CEREAL_NVP(textureID), CEREAL_NVP(texturePath),
             CEREAL_NVP(active), CEREAL_NVP(dynamic));
 
+        if constexpr (Archive::is_loading::value) {
+            ObjectID loadedID;
+            if (ObjectID::fromString(uuid, loadedID)) {
+                setUUID(loadedID);
+            }
+            setLocalTransform(position, rotation, scale);
+            setMeshData(meshData);
+            setTexture(texturePath, textureID);
+            setActive(active);
+            setDynamic(dynamic);
+        }
+
         std::vector<std::string> childUUIDs;
         if constexpr (Archive::is_saving::value) {
             childUUIDs.reserve(children.size());
             for (const auto& child : children) {
-                childUUIDs.push_back(child->uuid);
+                childUUIDs.push_back(child->uuid.toString());
             }
         }
         archive(CEREAL_NVP(childUUIDs));
 
         if constexpr (Archive::is_loading::value) {
-            pendingChildUUIDs = childUUIDs;
+            pendingChildUUIDs.clear();
+            for (const std::string& childText : childUUIDs) {
+                ObjectID childID;
+                if (ObjectID::fromString(childText, childID)) {
+                    pendingChildUUIDs.push_back(childID);
+                }
+            }
         }
     }
+
+private:
+    // Only the pool creates and destroys GameObjects
+    friend class GameObjectPool;
+
+    GameObject(const std::string& name, const MeshData& mesh, GLuint texID, const std::string& texPath = "");
+    ~GameObject();
+
+    void prepareForDestroy();
+
+    static std::unordered_map<ObjectID, GameObject*> objectsByID;
 };
 
 // To work with cereal 
@@ -169,7 +219,7 @@ struct GameObjectWrapper {
 template <class Archive>
 void GameObjectWrapper::serialize(Archive& ar) {
     if (ptr == nullptr) {
-        ptr = new GameObject("TempName", MeshData(), 0);
+        ptr = GameObjectPool::pool.create("TempName", MeshData(), 0);
     }
     ar(*ptr);
 };
@@ -0,0 +1,101 @@
+#include "GameObjectPool.h"
+#include "GameObject.h"
+#include <cstddef>
+#include <new>
+
+GameObjectPool GameObjectPool::pool;
+
+static_assert(alignof(GameObject) <= alignof(std::max_align_t), "Slab storage is not aligned enough for GameObject");
+
+GameObject* GameObjectPool::slotObject(uint32_t index) const {
+    unsigned char* slab = slabs[index / SLAB_SIZE].get();
+    return reinterpret_cast<GameObject*>(slab + (index % SLAB_SIZE) * sizeof(GameObject));
+}
+
+uint32_t GameObjectPool::slotIndex(const GameObject* object) const {
+    const unsigned char* address = reinterpret_cast<const unsigned char*>(object);
+
+    for (size_t slab = 0; slab < slabs.size(); ++slab) {
+        const unsigned char* begin = slabs[slab].get();
+        if (address >= begin && address < begin + SLAB_SIZE * sizeof(GameObject)) {
+            const size_t offset = address - begin;
+            if (offset % sizeof(GameObject) != 0) break;
+            return static_cast<uint32_t>(slab * SLAB_SIZE + offset / sizeof(GameObject));
+        }
+    }
+    return UINT32_MAX;
+}
+
+void GameObjectPool::addSlab() {
+    const uint32_t first = static_cast<uint32_t>(capacity());
+    slabs.emplace_back(new unsigned char[SLAB_SIZE * sizeof(GameObject)]);
+
+    generations.resize(capacity(), 0);
+    states.resize(capacity(), SlotState::Free);
+    freeSlots.reserve(capacity());
+    pendingFree.reserve(capacity());
+
+    // Pushed in reverse so the lowest slots are handed out first
+    for (uint32_t index = first + SLAB_SIZE; index > first; --index) {
+        freeSlots.push_back(index - 1);
+    }
+}
+
+GameObject* GameObjectPool::create(const std::string& name, const MeshData& mesh, GLuint texID, const std::string& texPath) {
+    if (freeSlots.empty()) {
+        addSlab();
+    }
+
+    const uint32_t index = freeSlots.back();
+    freeSlots.pop_back();
+
+    GameObject* object = new (slotObject(index)) GameObject(name, mesh, texID, texPath);
+    object->handle = GameObjectHandle{ index, generations[index] };
+    states[index] = SlotState::Live;
+    liveObjects++;
+    return object;
+}
+
+void GameObjectPool::destroy(GameObject* object) {
+    if (!object) return;
+
+    const uint32_t index = slotIndex(object);
+    if (index == UINT32_MAX || states[index] != SlotState::Live) {
+        return;
+    }
+
+    object->prepareForDestroy();
+
+    generations[index]++;
+    states[index] = SlotState::PendingDestroy;
+    pendingFree.push_back(index);
+    liveObjects--;
+}
+
+// Called once per frame, after rendering
+size_t GameObjectPool::flush() {
+    // Destructors may queue more objects, so walk by index
+    for (size_t i = 0; i < pendingFree.size(); ++i) {
+        const uint32_t index = pendingFree[i];
+        slotObject(index)->~GameObject();
+        states[index] = SlotState::Free;
+        freeSlots.push_back(index);
+    }
+    const size_t released = pendingFree.size();
+    pendingFree.clear();
+    return released;
+}
+
+GameObject* GameObjectPool::get(GameObjectHandle handle) const {
+    return isAlive(handle) ? slotObject(handle.index) : nullptr;
+}
+
+bool GameObjectPool::isAlive(GameObjectHandle handle) const {
+    return handle.index < states.size() && states[handle.index] == SlotState::Live &&
+        generations[handle.index] == handle.generation;
+}
+
+bool GameObjectPool::isAlive(const GameObject* object) const {
+    const uint32_t index = slotIndex(object);
+    return index != UINT32_MAX && states[index] == SlotState::Live;
+}
@@ -0,0 +1,67 @@
+#ifndef GAMEOBJECTPOOL_H
+#define GAMEOBJECTPOOL_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+
+class GameObject;
+struct MeshData;
+
+// Reference to a pooled GameObject that can tell when the object is gone
+struct GameObjectHandle {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool isValid() const { return index != UINT32_MAX; }
+    bool operator==(const GameObjectHandle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const GameObjectHandle& other) const { return !(*this == other); }
+};
+
+// Slab allocator for every GameObject in the editor.
+// Slots are recycled through a free list and slabs are never released, so creating and destroying
+// objects at runtime does not hit the heap for the objects themselves.
+class GameObjectPool {
+public:
+    static GameObjectPool pool;
+    static const uint32_t SLAB_SIZE = 256;
+
+    GameObject* create(const std::string& name, const MeshData& mesh, GLuint texID, const std::string& texPath = "");
+
+    // The object is unlinked and its handle becomes stale right away, but the memory is only
+    // released in flush() so raw pointers used during the current frame stay valid
+    void destroy(GameObject* object);
+    // Returns how many objects were released
+    size_t flush();
+
+    GameObject* get(GameObjectHandle handle) const;
+    bool isAlive(GameObjectHandle handle) const;
+    // Checks a raw pointer against the slabs without dereferencing it
+    bool isAlive(const GameObject* object) const;
+
+    size_t liveCount() const { return liveObjects; }
+    size_t capacity() const { return slabs.size() * SLAB_SIZE; }
+    size_t pendingCount() const { return pendingFree.size(); }
+
+private:
+    enum class SlotState : uint8_t {
+        Free,
+        Live,
+        PendingDestroy
+    };
+
+    std::vector<std::unique_ptr<unsigned char[]>> slabs;
+    std::vector<uint32_t> generations;
+    std::vector<SlotState> states;
+    std::vector<uint32_t> freeSlots;
+    std::vector<uint32_t> pendingFree;
+    size_t liveObjects = 0;
+
+    GameObject* slotObject(uint32_t index) const;
+    uint32_t slotIndex(const GameObject* object) const;
+    void addSlab();
+};
+
+#endif // GAMEOBJECTPOOL_H
@@ -0,0 +1,144 @@
+#include "GpuMesh.h"
+#include "GameObject.h"
+#include "JobSystem.h"
+#include "RenderPipeline.h"
+#include "IndirectRenderer.h"
+
+GpuMeshStats GpuMesh::stats;
+std::mutex GpuMesh::liveLock;
+std::unordered_set<GpuMesh*> GpuMesh::live;
+
+GpuMesh::~GpuMesh() {
+    if (!isUploaded()) return;
+
+    if (JobSystem::jobSystem.isMainThread()) {
+        release();
+        return;
+    }
+
+    // The last copy of the mesh died on a worker, GL objects can only be deleted on the main thread
+    {
+        std::lock_guard<std::mutex> guard(liveLock);
+        live.erase(this);
+        stats.meshes--;
+        stats.residentBytes -= bytes;
+    }
+    const GLuint arrays = vao;
+    const GLuint buffers[3] = { vertexBuffer, texCoordBuffer, indexBuffer };
+    const int entry = arenaEntry;
+    JobSystem::jobSystem.runOnMainThread([arrays, buffers, entry]() {
+        glDeleteVertexArrays(1, &arrays);
+        glDeleteBuffers(3, buffers);
+        IndirectRenderer::indirectRenderer.forget(entry);
+    });
+}
+
+const GpuMesh& GpuMesh::of(const MeshData& mesh) {
+    if (!mesh.gpu) {
+        mesh.gpu = std::make_shared<GpuMesh>();
+    }
+    if (!mesh.gpu->isUploaded()) {
+        mesh.gpu->upload(mesh);
+    }
+    return *mesh.gpu;
+}
+
+void GpuMesh::upload(const MeshData& mesh) {
+    const size_t vertexBytes = mesh.vertices.size() * sizeof(GLfloat);
+    const size_t texCoordBytes = mesh.textCoords.size() * sizeof(GLfloat);
+    const size_t indexBytes = mesh.indices.size() * sizeof(uint32_t);
+
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+
+    // The fixed pipeline arrays are part of the vertex array's state in a compatibility context.
+    // The same buffers also feed the shaders' generic attributes, so either pipeline can draw the mesh.
+    glGenBuffers(1, &vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertexBytes, mesh.vertices.data(), GL_STATIC_DRAW);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, nullptr);
+    glEnableVertexAttribArray(RenderPipeline::POSITION_ATTRIBUTE);
+    glVertexAttribPointer(RenderPipeline::POSITION_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+    if (!mesh.textCoords.empty()) {
+        glGenBuffers(1, &texCoordBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, texCoordBuffer);
+        glBufferData(GL_ARRAY_BUFFER, texCoordBytes, mesh.textCoords.data(), GL_STATIC_DRAW);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexCoordPointer(2, GL_FLOAT, 0, nullptr);
+        glEnableVertexAttribArray(RenderPipeline::TEXCOORD_ATTRIBUTE);
+        glVertexAttribPointer(RenderPipeline::TEXCOORD_ATTRIBUTE, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+    }
+
+    glGenBuffers(1, &indexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, mesh.indices.data(), GL_STATIC_DRAW);
+
+    // The element buffer binding belongs to the vertex array, it's only unbound once that is
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    indexCount = static_cast<GLsizei>(mesh.indices.size());
+    vertexCount = static_cast<GLsizei>(mesh.vertices.size() / 3);
+    bytes = vertexBytes + texCoordBytes + indexBytes;
+
+    std::lock_guard<std::mutex> guard(liveLock);
+    live.insert(this);
+    stats.meshes++;
+    stats.residentBytes += bytes;
+    stats.uploads++;
+    stats.uploadedBytes += bytes;
+}
+
+void GpuMesh::draw() const {
+    bind();
+    drawTriangles();
+}
+
+void GpuMesh::bind() const {
+    glBindVertexArray(vao);
+}
+
+void GpuMesh::drawTriangles(GLsizei instances) const {
+    if (instances > 1) {
+        glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, nullptr, instances);
+    }
+    else {
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, nullptr);
+    }
+}
+
+void GpuMesh::release() {
+    if (!isUploaded()) return;
+
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vertexBuffer);
+    glDeleteBuffers(1, &texCoordBuffer);
+    glDeleteBuffers(1, &indexBuffer);
+    vao = vertexBuffer = texCoordBuffer = indexBuffer = 0;
+    IndirectRenderer::indirectRenderer.forget(arenaEntry);
+    arenaEntry = -1;
+
+    std::lock_guard<std::mutex> guard(liveLock);
+    live.erase(this);
+    stats.meshes--;
+    stats.residentBytes -= bytes;
+}
+
+void GpuMesh::beginFrame() {
+    stats.uploads = 0;
+    stats.uploadedBytes = 0;
+}
+
+void GpuMesh::releaseAll() {
+    std::unordered_set<GpuMesh*> meshes;
+    {
+        std::lock_guard<std::mutex> guard(liveLock);
+        meshes = live;
+    }
+    for (GpuMesh* mesh : meshes) {
+        mesh->release();
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef GPUMESH_H
+#define GPUMESH_H
+
+#include <cstddef>
+#include <mutex>
+#include <unordered_set>
+#include <GL/glew.h>
+
+struct MeshData;
+
+struct GpuMeshStats {
+    size_t meshes = 0;              // Meshes with buffers on the GPU
+    size_t residentBytes = 0;       // Their vertex, texture coordinate and index data
+    size_t uploads = 0;             // Meshes uploaded this frame
+    size_t uploadedBytes = 0;       // Geometry sent to the GPU this frame
+};
+
+// A mesh's vertices, texture coordinates and indices in GL buffer objects, with a vertex array object
+// recording the whole layout so a draw is one bind and one call. The buffers are filled on the first
+// draw and shared by every copy of the MeshData, the last copy to go deletes them.
+class GpuMesh {
+public:
+    GpuMesh() = default;
+    GpuMesh(const GpuMesh&) = delete;
+    GpuMesh& operator=(const GpuMesh&) = delete;
+    ~GpuMesh();
+
+    // The mesh's buffers, uploaded on first use. GL thread only.
+    static const GpuMesh& of(const MeshData& mesh);
+
+    // Leaves the vertex array bound, the caller unbinds it once done drawing
+    void draw() const;
+    // draw() in two steps, so consecutive draws of the same mesh bind it once.
+    // More than one instance draws the mesh once per instance in a single call.
+    void bind() const;
+    void drawTriangles(GLsizei instances = 1) const;
+
+    bool isUploaded() const { return vao != 0; }
+    GLuint getVertexArray() const { return vao; }
+    GLsizei getIndexCount() const { return indexCount; }
+    size_t getBytes() const { return bytes; }
+
+    // Starts counting this frame's uploads
+    static void beginFrame();
+    static const GpuMeshStats& getStats() { return stats; }
+
+    // Deletes the buffers of every mesh, the GL context must still be current
+    static void releaseAll();
+
+private:
+    friend class IndirectRenderer;
+
+    GLuint vao = 0;
+    GLuint vertexBuffer = 0;
+    GLuint texCoordBuffer = 0;
+    GLuint indexBuffer = 0;
+    GLsizei indexCount = 0;
+    GLsizei vertexCount = 0;
+    size_t bytes = 0;
+    // Copy in the indirect renderer's arenas, made on the first indirect draw
+    mutable int arenaEntry = -1;
+
+    void upload(const MeshData& mesh);
+    void release();
+
+    static GpuMeshStats stats;
+
+    // Meshes with GL objects, MeshData copies may be destroyed on any thread
+    static std::mutex liveLock;
+    static std::unordered_set<GpuMesh*> live;
+};
+
+#endif // GPUMESH_H
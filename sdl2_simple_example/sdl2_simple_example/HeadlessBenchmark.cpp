@@ -0,0 +1,401 @@
+#include "HeadlessBenchmark.h"
+#include "Renderer.h"
+#include "Camera.h"
+#include "GameObject.h"
+#include "Variables.h"
+#include "ConsoleWindow.h"
+#include "SceneManager.h"
+#include "SimulationManager.h"
+#include "JobSystem.h"
+#include "OcclusionQueries.h"
+#include "PickingBuffer.h"
+#include "GpuMesh.h"
+#include "RenderPipeline.h"
+#include "StaticBatcher.h"
+#include "IndirectRenderer.h"
+#include "DebugDraw.h"
+#include "Bounds.h"
+#include "IL/il.h"
+#include "IL/ilu.h"
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+extern Camera camera;
+extern Renderer renderer;
+
+HeadlessBenchmark HeadlessBenchmark::headlessBenchmark;
+
+namespace {
+    using benchClock = std::chrono::high_resolution_clock;
+
+    // The OpenGL context belongs to a hidden SDL window that is never shown nor swapped, every frame is drawn
+    // into the scene target. Machines without a display, like CI runners with only Mesa's llvmpipe, get SDL's
+    // offscreen driver instead, which makes the context through EGL with no window system at all.
+    class HeadlessContext {
+    public:
+        bool create() {
+            if (createWindow(nullptr)) return true;
+
+            // Older SDL versions only pick the offscreen driver when the environment asks for it
+            SDL_setenv("SDL_VIDEODRIVER", "offscreen", 1);
+            return createWindow("offscreen");
+        }
+
+        void destroy() {
+            if (context) {
+                SDL_GL_DeleteContext(context);
+                context = nullptr;
+            }
+            if (window) {
+                SDL_DestroyWindow(window);
+                window = nullptr;
+            }
+            SDL_QuitSubSystem(SDL_INIT_VIDEO);
+        }
+
+    private:
+        SDL_Window* window = nullptr;
+        SDL_GLContext context = nullptr;
+
+        bool createWindow(const char* driver) {
+            const std::string driverName = driver ? driver : "default";
+            if (SDL_InitSubSystem(SDL_INIT_VIDEO) != 0) {
+                console.addLog("Headless: " + driverName + " video driver unavailable, " + SDL_GetError());
+                return false;
+            }
+
+            SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+            SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
+            SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 8);
+            window = SDL_CreateWindow("Benchmark", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 64, 64, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+
+            // The newest compatibility context the driver gives, so indirect drawing (4.3) gets measured too.
+            // The fixed pipeline fallback and the grid display list need the compatibility profile.
+            const int versions[][2] = { { 4, 6 }, { 4, 5 }, { 4, 3 }, { 4, 0 }, { 3, 3 }, { 3, 0 } };
+            for (const int* version : versions) {
+                if (!window) break;
+                SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_COMPATIBILITY);
+                SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, version[0]);
+                SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, version[1]);
+                context = SDL_GL_CreateContext(window);
+                if (context) break;
+            }
+            if (!window || !context || SDL_GL_MakeCurrent(window, context) != 0) {
+                console.addLog("Headless: no OpenGL context with the " + driverName + " video driver, " + SDL_GetError());
+                destroy();
+                return false;
+            }
+
+            // Nothing is presented, but a driver forcing vsync on would still throttle glFinish() on some platforms
+            SDL_GL_SetSwapInterval(0);
+            console.addLog("Headless: OpenGL context from the " + std::string(SDL_GetCurrentVideoDriver()) + " video driver");
+            return true;
+        }
+    };
+
+    struct Summary {
+        double mean = 0.0;
+        double median = 0.0;
+        double p95 = 0.0;
+        double max = 0.0;
+    };
+
+    Summary summarize(std::vector<double> values) {
+        Summary summary;
+        if (values.empty()) return summary;
+
+        std::sort(values.begin(), values.end());
+        double total = 0.0;
+        for (double value : values) {
+            total += value;
+        }
+        summary.mean = total / values.size();
+        summary.median = values[values.size() / 2];
+        summary.p95 = values[std::min(values.size() - 1, values.size() * 95 / 100)];
+        summary.max = values.back();
+        return summary;
+    }
+
+    std::string jsonString(const std::string& text) {
+        std::string quoted = "\"";
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                quoted += '\\';
+            }
+            quoted += (static_cast<unsigned char>(c) < 0x20) ? ' ' : c;
+        }
+        return quoted + "\"";
+    }
+
+    std::string glString(GLenum name) {
+        const GLubyte* value = glGetString(name);
+        return value ? reinterpret_cast<const char*>(value) : "";
+    }
+
+    // Points the editor camera from 'eye' at 'target', the camera stores its position negated
+    void lookAt(const glm::vec3& eye, const glm::vec3& target) {
+        const glm::vec3 direction = glm::normalize(target - eye);
+        camera.position = -eye;
+        camera.angleY = glm::degrees(std::asin(-direction.y));
+        camera.angleX = glm::degrees(std::atan2(direction.x, -direction.z));
+    }
+
+    // World box of everything with a mesh
+    bool sceneBounds(const std::vector<GameObject*>& gameObjects, AABB& bounds) {
+        bool any = false;
+        for (const GameObject* object : gameObjects) {
+            const BoundsComponent* local = World::world.tryGet<BoundsComponent>(object->entity);
+            if (!local || local->localMin == local->localMax) continue;
+
+            const AABB box = AABB(local->localMin, local->localMax).transformed(object->getWorldMatrix());
+            bounds = any ? AABB::merge(bounds, box) : box;
+            any = true;
+        }
+        return any;
+    }
+}
+
+bool HeadlessBenchmark::requested(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--benchmark") == 0) return true;
+    }
+    return false;
+}
+
+bool HeadlessBenchmark::parseArguments(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        const std::string argument = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (argument == "--benchmark") continue;
+        if (argument == "--fixed") {
+            options.fixedPipeline = true;
+            continue;
+        }
+        if (!hasValue) {
+            std::cerr << "Missing value for " << argument << "\n";
+            return false;
+        }
+
+        const std::string value = argv[++i];
+        if (argument == "--scene") {
+            options.scene = value;
+        }
+        else if (argument == "--stress") {
+            // Primitive:copies, or just the number of cubes
+            const size_t colon = value.find(':');
+            if (colon != std::string::npos) {
+                options.stressPrimitive = value.substr(0, colon);
+                options.stressCopies = std::atoi(value.c_str() + colon + 1);
+            }
+            else {
+                options.stressCopies = std::atoi(value.c_str());
+            }
+        }
+        else if (argument == "--frames") {
+            options.frames = std::atoi(value.c_str());
+        }
+        else if (argument == "--warmup") {
+            options.warmup = std::atoi(value.c_str());
+        }
+        else if (argument == "--width") {
+            options.width = std::atoi(value.c_str());
+        }
+        else if (argument == "--height") {
+            options.height = std::atoi(value.c_str());
+        }
+        else if (argument == "--output") {
+            options.output = value;
+        }
+        else {
+            std::cerr << "Unknown benchmark option " << argument << "\n";
+            return false;
+        }
+    }
+
+    if (options.frames <= 0 || options.warmup < 0 || options.width <= 0 || options.height <= 0 || options.stressCopies <= 0) {
+        std::cerr << "Frames, sizes and copies must be positive\n";
+        return false;
+    }
+    return true;
+}
+
+int HeadlessBenchmark::run(int argc, char** argv) {
+    if (!parseArguments(argc, argv)) {
+        return 2;
+    }
+
+    // No editor window: the renderer sees no selection and the scene target is the only framebuffer
+    variables = new Variables;
+    variables->window = nullptr;
+
+    HeadlessContext context;
+    if (!context.create()) {
+        for (const std::string& log : console.logs) {
+            std::cerr << log << "\n";
+        }
+        delete variables;
+        variables = nullptr;
+        return 1;
+    }
+
+    int exitCode = 0;
+    std::vector<GameObject*> gameObjects;
+    try {
+        renderer.initOpenGL();
+        ilInit();
+        iluInit();
+        JobSystem::jobSystem.init();
+        RenderPipeline::renderPipeline.enabled = !options.fixedPipeline;
+
+        if (!options.scene.empty()) {
+            SceneManager::sceneManager.loadScene(options.scene, gameObjects);
+        }
+        else {
+            GameObject::createStressScene(options.stressPrimitive, options.stressCopies, gameObjects);
+        }
+        renderer.updateFrameBuffer(options.width, options.height);
+
+        // An orbit around the scene's center, flying in and out twice per turn
+        TransformStore::transformStore.updateWorldMatrices();
+        AABB bounds(glm::vec3(-10.0f), glm::vec3(10.0f));
+        sceneBounds(gameObjects, bounds);
+        const glm::vec3 center = bounds.center();
+        const float radius = std::min(std::max(glm::length(bounds.extents()), 5.0f), 60.0f);
+
+        const int totalFrames = options.warmup + options.frames;
+        samples.clear();
+        samples.reserve(options.frames);
+        for (int frame = 0; frame < totalFrames; frame++) {
+            const float t = static_cast<float>(frame) / totalFrames;
+            const float angle = 6.2831853f * t;
+            const float distance = radius * (0.75f + 0.25f * std::cos(2.0f * angle));
+            lookAt(center + glm::vec3(std::sin(angle) * distance, distance * 0.4f, std::cos(angle) * distance), center);
+
+            // GL work queued by jobs during the last frame, as in the editor loop
+            JobSystem::jobSystem.pumpMainThread();
+
+            const auto start = benchClock::now();
+            renderer.render();
+            const auto submitted = benchClock::now();
+            glFinish();
+            const auto finished = benchClock::now();
+            GameObjectPool::pool.flush();
+
+            if (frame < options.warmup) continue;
+
+            const RenderStats& stats = renderer.getStats();
+            FrameSample sample;
+            sample.cpuMs = std::chrono::duration<double, std::milli>(submitted - start).count();
+            sample.frameMs = std::chrono::duration<double, std::milli>(finished - start).count();
+            sample.cullMs = stats.cullMs;
+            sample.submitMs = stats.submitMs;
+            sample.drawCalls = stats.drawCalls;
+            sample.triangles = stats.triangles;
+            sample.objectsDrawn = stats.objectsDrawn;
+            samples.push_back(sample);
+        }
+
+        if (options.output.empty()) {
+            writeResults(std::cout, gameObjects.size());
+        }
+        else {
+            std::ofstream file(options.output);
+            if (!file) {
+                std::cerr << "Could not write " << options.output << "\n";
+                exitCode = 1;
+            }
+            else {
+                writeResults(file, gameObjects.size());
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Benchmark failed: " << e.what() << "\n";
+        exitCode = 1;
+    }
+
+    // The console has no window to show in, its messages go to stderr
+    for (const std::string& log : console.logs) {
+        std::cerr << log << "\n";
+    }
+
+    // The scene goes before the GL objects, its meshes still hold buffers
+    for (GameObject* obj : gameObjects) {
+        GameObjectPool::pool.destroy(obj);
+    }
+    gameObjects.clear();
+    GameObjectPool::pool.flush();
+
+    renderer.cleanupFrameBuffer();
+    PickingBuffer::pickingBuffer.release();
+    OcclusionQueries::occlusionQueries.releaseQueries();
+    StaticBatcher::staticBatcher.release();
+    GpuMesh::releaseAll();
+    IndirectRenderer::indirectRenderer.release();
+    DebugDraw::debugDraw.release();
+    RenderPipeline::renderPipeline.release();
+    JobSystem::jobSystem.shutdown();
+    context.destroy();
+    delete variables;
+    variables = nullptr;
+    return exitCode;
+}
+
+void HeadlessBenchmark::writeResults(std::ostream& out, size_t objectCount) const {
+    std::vector<double> cpu, frame, cull, submit, drawCalls, triangles;
+    for (const FrameSample& sample : samples) {
+        cpu.push_back(sample.cpuMs);
+        frame.push_back(sample.frameMs);
+        cull.push_back(sample.cullMs);
+        submit.push_back(sample.submitMs);
+        drawCalls.push_back(static_cast<double>(sample.drawCalls));
+        triangles.push_back(static_cast<double>(sample.triangles));
+    }
+
+    const auto writeSummary = [&](const char* name, const std::vector<double>& values, bool last) {
+        const Summary summary = summarize(values);
+        out << "    \"" << name << "\": { \"mean\": " << summary.mean << ", \"median\": " << summary.median
+            << ", \"p95\": " << summary.p95 << ", \"max\": " << summary.max << " }" << (last ? "\n" : ",\n");
+    };
+
+    const std::string scene = options.scene.empty() ? "stress:" + options.stressPrimitive + ":" + std::to_string(options.stressCopies) : options.scene;
+    out << std::fixed << std::setprecision(4);
+    out << "{\n";
+    out << "  \"scene\": " << jsonString(scene) << ",\n";
+    out << "  \"objects\": " << objectCount << ",\n";
+    out << "  \"width\": " << options.width << ",\n";
+    out << "  \"height\": " << options.height << ",\n";
+    out << "  \"frames\": " << samples.size() << ",\n";
+    out << "  \"warmup\": " << options.warmup << ",\n";
+    out << "  \"pipeline\": " << jsonString(RenderPipeline::renderPipeline.isActive() ? "shaders" : "fixed") << ",\n";
+    out << "  \"glRenderer\": " << jsonString(glString(GL_RENDERER)) << ",\n";
+    out << "  \"glVersion\": " << jsonString(glString(GL_VERSION)) << ",\n";
+
+    out << "  \"summary\": {\n";
+    writeSummary("cpuMs", cpu, false);
+    writeSummary("frameMs", frame, false);
+    writeSummary("cullMs", cull, false);
+    writeSummary("submitMs", submit, false);
+    writeSummary("drawCalls", drawCalls, false);
+    writeSummary("triangles", triangles, true);
+    out << "  },\n";
+
+    out << "  \"perFrame\": [\n";
+    for (size_t i = 0; i < samples.size(); i++) {
+        const FrameSample& sample = samples[i];
+        out << "    { \"cpuMs\": " << sample.cpuMs << ", \"frameMs\": " << sample.frameMs << ", \"cullMs\": " << sample.cullMs
+            << ", \"submitMs\": " << sample.submitMs << ", \"drawCalls\": " << sample.drawCalls << ", \"triangles\": " << sample.triangles
+            << ", \"objectsDrawn\": " << sample.objectsDrawn << " }" << (i + 1 < samples.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
@@ -0,0 +1,53 @@
+#ifndef HEADLESSBENCHMARK_H
+#define HEADLESSBENCHMARK_H
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// Renders a scene offscreen, with no window and no ImGui, and writes per frame timings as JSON:
+//   sdl2_simple_example --benchmark [--scene file.json | --stress Cube:2500] [--frames 300] [--warmup 30]
+//                       [--width 1280] [--height 720] [--fixed] [--output results.json]
+// The GL context comes from a hidden SDL window, or from SDL's offscreen driver on machines with no display,
+// so it also runs on build machines with only Mesa's llvmpipe.
+// The camera orbits the scene on a fixed path, in and out, so runs of the same scene are comparable.
+class HeadlessBenchmark {
+public:
+    static HeadlessBenchmark headlessBenchmark;
+
+    // True when the command line asks for the benchmark instead of the editor
+    static bool requested(int argc, char** argv);
+    // Returns the process exit code
+    int run(int argc, char** argv);
+
+private:
+    struct Options {
+        std::string scene;              // Saved scene, otherwise the stress scene
+        std::string stressPrimitive = "Cube";
+        int stressCopies = 2500;
+        int frames = 300;
+        int warmup = 30;                // Frames drawn before measuring, static batches get built meanwhile
+        int width = 1280;
+        int height = 720;
+        bool fixedPipeline = false;
+        std::string output;             // Standard output when empty
+    };
+
+    struct FrameSample {
+        double cpuMs = 0.0;             // Renderer::render() returning
+        double frameMs = 0.0;           // Until the GPU is done too
+        double cullMs = 0.0;
+        double submitMs = 0.0;
+        size_t drawCalls = 0;
+        size_t triangles = 0;
+        size_t objectsDrawn = 0;
+    };
+
+    Options options;
+    std::vector<FrameSample> samples;
+
+    bool parseArguments(int argc, char** argv);
+    void writeResults(std::ostream& out, size_t objectCount) const;
+};
+
+#endif // HEADLESSBENCHMARK_H
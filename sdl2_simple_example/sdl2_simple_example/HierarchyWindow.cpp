@@ -9,7 +9,7 @@ namespace {
     const ImVec4 DEFAULT_COLOR(0.3f, 0.3f, 0.3f, 1.0f);
 }
 
-void HierarchyWindow::deleteSelectedObjects(std::vector<GameObject*>& gameObjects, std::vector<GameObject*>& selectedObjects, GameObject*& selectedObject) {
+void HierarchyWindow::deleteSelectedObjects(std::vector<GameObject*>& gameObjects, Selection& selectedObjects, GameObject*& selectedObject) {
     if (SimulationManager::simulationManager.getState() == SimulationManager::SimulationState::Running) {
         ImGui::OpenPopup("Error");
         return;
@@ -17,7 +17,7 @@ void HierarchyWindow::deleteSelectedObjects(std::vector<GameObject*>& gameObject
 
     std::vector<GameObject*> objectsToDelete;
     for (auto* obj : selectedObjects) {
-        if (!obj->parent || std::find(selectedObjects.begin(), selectedObjects.end(), obj->parent) == selectedObjects.end()) {
+        if (!obj->parent || !selectedObjects.contains(obj->parent)) {
             objectsToDelete.push_back(obj);
         }
     }
@@ -42,10 +42,10 @@ void HierarchyWindow::deleteObjectAndChildren(GameObject* obj, std::vector<GameO
     }
     obj->children.clear();
     gameObjects.erase(std::remove(gameObjects.begin(), gameObjects.end(), obj), gameObjects.end());
-    delete obj;
+    GameObjectPool::pool.destroy(obj);
 }
 
-void HierarchyWindow::render(std::vector<GameObject*>& gameObjects, std::vector<GameObject*>& selectedObjects, GameObject*& selectedObject) {
+void HierarchyWindow::render(std::vector<GameObject*>& gameObjects, Selection& selectedObjects, GameObject*& selectedObject) {
     ImGui::Begin("Hierarchy", nullptr);
 
     if (SimulationManager::simulationManager.getState() == SimulationManager::SimulationState::Running) {
@@ -76,10 +76,9 @@ void HierarchyWindow::render(std::vector<GameObject*>& gameObjects, std::vector<
 
     processNewObjects(gameObjects);
     handleParenting(selectedObjects);
-    applyTransforms(gameObjects, selectedObjects);
 }
 
-void HierarchyWindow::handleKeyboardInput(const Uint8* keyboardState, std::vector<GameObject*>& gameObjects, std::vector<GameObject*>& selectedObjects, GameObject*& selectedObject) {
+void HierarchyWindow::handleKeyboardInput(const Uint8* keyboardState, std::vector<GameObject*>& gameObjects, Selection& selectedObjects, GameObject*& selectedObject) {
     if (keyboardState[SDL_SCANCODE_DELETE]) {
         deleteKeyPressed = true;
         deleteSelectedObjects(gameObjects, selectedObjects, selectedObject);
@@ -90,23 +89,26 @@ void HierarchyWindow::handleKeyboardInput(const Uint8* keyboardState, std::vecto
 }
 
 void HierarchyWindow::renderHierarchyTree(const std::vector<GameObject*>& gameObjects,
-    std::vector<GameObject*>& selectedObjects,
+    Selection& selectedObjects,
     GameObject*& selectedObject,
     const Uint8* keyboardState) {
     std::function<void(GameObject*)> renderGameObject = [&](GameObject* obj) {
-        std::string uniqueLabel = obj->getName() + "##" + obj->getUUID();
+        // The binary ID keeps the ImGui id unique without formatting it as text
+        const ObjectID& id = obj->getUUID();
+        ImGui::PushID(reinterpret_cast<const char*>(&id), reinterpret_cast<const char*>(&id) + sizeof(ObjectID));
 
-        bool isSelected = std::find(selectedObjects.begin(), selectedObjects.end(), obj) != selectedObjects.end();
+        bool isSelected = selectedObjects.contains(obj);
 
         ImGui::PushStyleColor(ImGuiCol_Header,
             isSelected && selectedObject == obj ? SELECTED_PRIMARY_COLOR :
             isSelected ? SELECTED_SECONDARY_COLOR : DEFAULT_COLOR);
 
-        if (ImGui::Selectable(uniqueLabel.c_str(), isSelected)) {
+        if (ImGui::Selectable(obj->getName().c_str(), isSelected)) {
             handleObjectSelection(obj, gameObjects, selectedObjects, selectedObject, keyboardState);
         }
 
         ImGui::PopStyleColor();
+        ImGui::PopID();
 
         if (!obj->children.empty()) {
             ImGui::Indent();
@@ -126,7 +128,7 @@ void HierarchyWindow::renderHierarchyTree(const std::vector<GameObject*>& gameOb
 
 void HierarchyWindow::handleObjectSelection(GameObject* obj,
     const std::vector<GameObject*>& gameObjects,
-    std::vector<GameObject*>& selectedObjects,
+    Selection& selectedObjects,
     GameObject*& selectedObject,
     const Uint8* keyboardState) {
     bool ctrlPressed = keyboardState[SDL_SCANCODE_LCTRL] || keyboardState[SDL_SCANCODE_RCTRL];
@@ -134,15 +136,13 @@ void HierarchyWindow::handleObjectSelection(GameObject* obj,
 
     if (ctrlPressed) {
         // Multi-seleccin with Ctrl
-        auto it = std::find(selectedObjects.begin(), selectedObjects.end(), obj);
-        if (it != selectedObjects.end()) {
-            selectedObjects.erase(it);
+        if (selectedObjects.remove(obj)) {
             if (selectedObject == obj) {
                 selectedObject = selectedObjects.empty() ? nullptr : selectedObjects.back();
             }
         }
         else {
-            selectedObjects.push_back(obj);
+            selectedObjects.add(obj);
             selectedObject = obj;
         }
     }
@@ -175,19 +175,18 @@ void HierarchyWindow::handleObjectSelection(GameObject* obj,
 
             selectedObjects.clear();
             for (size_t i = startIdx; i <= endIdx; ++i) {
-                selectedObjects.push_back(siblingObjects[i]);
+                selectedObjects.add(siblingObjects[i]);
             }
             selectedObject = obj;
         }
     }
     else {
-        selectedObjects.clear();
-        selectedObjects.push_back(obj);
+        selectedObjects.set(obj);
         selectedObject = obj;
     }
 }
 
-void HierarchyWindow::handleParenting(std::vector<GameObject*>& selectedObjects) {
+void HierarchyWindow::handleParenting(Selection& selectedObjects) {
     const Uint8* keyboardState = SDL_GetKeyboardState(nullptr);
 
     if (keyboardState[SDL_SCANCODE_P]) {
@@ -201,7 +200,7 @@ void HierarchyWindow::handleParenting(std::vector<GameObject*>& selectedObjects)
     }
 }
 
-void HierarchyWindow::processParenting(std::vector<GameObject*>& selectedObjects) {
+void HierarchyWindow::processParenting(Selection& selectedObjects) {
     if (selectedObjects.size() == 1) {
         GameObject* parent = selectedObjects[0];
         std::vector<GameObject*> childrenCopy = parent->children;
@@ -211,28 +210,13 @@ void HierarchyWindow::processParenting(std::vector<GameObject*>& selectedObjects
     }
     else if (selectedObjects.size() > 1) {
         GameObject* parent = selectedObjects.back();
-        selectedObjects.pop_back();
+        selectedObjects.remove(parent);
 
         for (GameObject* child : selectedObjects) {
             parent->addChild(child);
         }
 
-        parent->updateChildTransforms();
-        selectedObjects = { parent };
-    }
-}
-
-void HierarchyWindow::applyTransforms(std::vector<GameObject*>& gameObjects, std::vector<GameObject*>& selectedObjects) {
-    if (selectedObjects.empty()) return;
-
-    GameObject* lastSelected = selectedObjects.back();
-    if (!lastSelected->parent) {
-        for (GameObject* obj : selectedObjects) {
-            obj->updateChildTransforms();
-        }
-    }
-    else {
-        lastSelected->updateChildTransforms();
+        selectedObjects.set(parent);
     }
 }
 
@@ -278,5 +262,4 @@ void HierarchyWindow::setupInitialHierarchy(std::vector<GameObject*>& gameObject
             parent->addChild(child);
         }
     }
-    parent->updateChildTransforms();
 }
\ No newline at end of file
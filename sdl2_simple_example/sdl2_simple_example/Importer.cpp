@@ -11,6 +11,7 @@
 #include <fstream>
 #include "Variables.h"
 #include "ConsoleWindow.h"
+#include "JobSystem.h"
 
 Importer importer;
 
@@ -42,10 +43,13 @@ void Importer::checkAndCreateDirectories() {
             std::filesystem::create_directories(dirPath);
         }
     }
-    processAssetsToLibrary();
 }
 
+// Runs at startup once the job system is up: every new FBX is converted in its own job
 void Importer::processAssetsToLibrary() {
+    std::vector<std::filesystem::path> models;
+    std::vector<std::filesystem::path> textures;
+
     for (const auto& entry : std::filesystem::directory_iterator("Assets")) {
  
         if (entry.is_regular_file()) {
@@ -54,27 +58,32 @@ void Importer::processAssetsToLibrary() {
             std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
 
             if (extension == ".fbx") {
-                std::string fileName = entry.path().filename().string();
                 std::string outputPath = "Library/Models/" + entry.path().stem().string() + ".dat";
-
                 if (!std::filesystem::exists(outputPath)) {
-                    GLuint textureID = 0;
-                    std::vector<MeshData> meshes = loadFBX(entry.path().string(), textureID);
-                    saveCustomFormat(outputPath, meshes);
-
-                    std::filesystem::path texturePathPNG = entry.path().parent_path() /
-                        (entry.path().stem().string() + ".png");
-
-                    if (std::filesystem::exists(texturePathPNG)) {
-                        processTextureFile(texturePathPNG);
-                    }
+                    models.push_back(entry.path());
                 }
             }
             else if (extension == ".png") {
-                processTextureFile(entry.path());
+                textures.push_back(entry.path());
             }
         }
     }
+
+    JobCounter modelJobs;
+    for (const std::filesystem::path& modelPath : models) {
+        JobSystem::jobSystem.run([this, modelPath]() {
+            std::vector<MeshData> meshes = readFBXMeshes(modelPath.string());
+            if (!meshes.empty()) {
+                saveCustomFormat("Library/Models/" + modelPath.stem().string() + ".dat", meshes);
+            }
+        }, &modelJobs);
+    }
+
+    // DevIL keeps global state, so textures are converted on this thread while the models are processed
+    for (const std::filesystem::path& texturePath : textures) {
+        processTextureFile(texturePath);
+    }
+    JobSystem::jobSystem.wait(modelJobs);
 }
 
 void Importer::processTextureFile(const std::filesystem::path& texturePath) {
@@ -127,25 +136,40 @@ TextureData Importer::loadTextureData(const std::string& texturePath) {
 }
 
 GLuint Importer::loadTextureFromCustomFormat(const std::string& texturePath) {
+    TextureData texData = readTextureFromCustomFormat(texturePath);
+    if (!texData.pixels) {
+        return 0;
+    }
+
+    GLuint textureID = uploadTexture(texData);
+    console.addLog("Custom format texture loaded: " + texturePath);
+    return textureID;
+}
+
+TextureData Importer::readTextureFromCustomFormat(const std::string& texturePath) {
+    TextureData texData = { nullptr, 0, 0, 0 };
+
     std::ifstream file(texturePath, std::ios::binary);
     if (!file) {
         console.addLog("Error: Cannot open texture file: " + texturePath);
-        return 0;
+        return texData;
     }
 
-    int width, height, channels;
-    file.read(reinterpret_cast<char*>(&width), sizeof(int));
-    file.read(reinterpret_cast<char*>(&height), sizeof(int));
-    file.read(reinterpret_cast<char*>(&channels), sizeof(int));
+    file.read(reinterpret_cast<char*>(&texData.width), sizeof(int));
+    file.read(reinterpret_cast<char*>(&texData.height), sizeof(int));
+    file.read(reinterpret_cast<char*>(&texData.channels), sizeof(int));
 
-    size_t dataSize = width * height * channels;
-    unsigned char* pixels = new unsigned char[dataSize];
-    file.read(reinterpret_cast<char*>(pixels), dataSize);
+    size_t dataSize = texData.width * texData.height * texData.channels;
+    texData.pixels = new unsigned char[dataSize];
+    file.read(reinterpret_cast<char*>(texData.pixels), dataSize);
+    return texData;
+}
 
+GLuint Importer::uploadTexture(TextureData& texData) {
     GLuint textureID;
     glGenTextures(1, &textureID);
     glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texData.width, texData.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, texData.pixels);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -153,8 +177,8 @@ GLuint Importer::loadTextureFromCustomFormat(const std::string& texturePath) {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glGenerateMipmap(GL_TEXTURE_2D);
 
-    delete[] pixels;
-    console.addLog("Custom format texture loaded: " + texturePath);
+    delete[] texData.pixels;
+    texData.pixels = nullptr;
     return textureID;
 }
 
@@ -201,6 +225,32 @@ std::vector<MeshData> Importer::loadFBX(const std::string& relativeFilePath, GLu
 
     auto start = std::chrono::high_resolution_clock::now();
 
+    std::vector<MeshData> meshes = readFBXMeshes(filePath);
+    if (meshes.empty()) {
+        return {};
+    }
+
+    std::filesystem::path modelPath(filePath);
+    std::filesystem::path texturePath = modelPath.parent_path() / (modelPath.stem().string() + ".png");
+
+    if (std::filesystem::exists(texturePath)) {
+        textureID = loadTexture(texturePath.string());
+        console.addLog("Texture found & loaded: " + texturePath.string());
+    }
+    else {
+        console.addLog("Texture not found for " + filePath);
+        textureID = 0;
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = end - start;
+    console.addLog("Loading time for FBX: " + std::to_string(elapsed.count()) + " seconds");
+
+    return meshes;
+}
+
+std::vector<MeshData> Importer::readFBXMeshes(const std::string& filePath) {
+    // One Assimp::Importer per call, they share no state so several models can load at once
     Assimp::Importer importer;
     const aiScene* scene = importer.ReadFile(filePath, aiProcess_Triangulate);
 
@@ -235,23 +285,6 @@ std::vector<MeshData> Importer::loadFBX(const std::string& relativeFilePath, GLu
         }
         meshes.push_back(meshData);
     }
-
-    std::filesystem::path modelPath(filePath);
-    std::filesystem::path texturePath = modelPath.parent_path() / (modelPath.stem().string() + ".png");
-
-    if (std::filesystem::exists(texturePath)) {
-        textureID = loadTexture(texturePath.string());
-        console.addLog("Texture found & loaded: " + texturePath.string());
-    }
-    else {
-        console.addLog("Texture not found for " + filePath);
-        textureID = 0;
-    }
-
-    auto end = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> elapsed = end - start;
-    console.addLog("Loading time for FBX: " + std::to_string(elapsed.count()) + " seconds");
-
     return meshes;
 }
 
@@ -21,6 +21,8 @@ public:
     // Model & load
     std::vector<MeshData> loadModelFromCustomFormat(const std::string& relativeFilePath, GLuint& textureID);
     std::vector<MeshData> loadFBX(const std::string& relativefilePath, GLuint& textureID);
+    // Assimp only, safe to call from a job
+    std::vector<MeshData> readFBXMeshes(const std::string& filePath);
     void processAssetsToLibrary();
     void saveCustomFormat(const std::string& outputPath, const std::vector<MeshData>& meshes);
     std::vector<MeshData> loadCustomFormat(const std::string& inputPath);
@@ -28,6 +30,10 @@ public:
     // Texture & utilities
     GLuint loadTexture(const std::string& texturePath);
     GLuint loadTextureFromCustomFormat(const std::string& texturePath);
+    // File part of loadTextureFromCustomFormat, safe to call from a job. Pixels are null on failure.
+    TextureData readTextureFromCustomFormat(const std::string& texturePath);
+    // GL upload, main thread only. Frees the pixels.
+    GLuint uploadTexture(TextureData& texData);
     void getTextureDimensions(GLuint textureID, int& width, int& height);
 
     // Texture handling
@@ -0,0 +1,303 @@
+#include "IndirectRenderer.h"
+#include "GpuMesh.h"
+#include "RenderPipeline.h"
+#include "RenderQueue.h"
+#include "ConsoleWindow.h"
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+
+IndirectRenderer IndirectRenderer::indirectRenderer;
+
+namespace {
+    using submitClock = std::chrono::high_resolution_clock;
+
+    const size_t MIN_REGION_COMMANDS = 1024;
+    const size_t MIN_RECORDS = 4096;
+    const GLuint64 FENCE_TIMEOUT_NS = 1000000;
+
+    const size_t POSITION_BYTES = 3 * sizeof(GLfloat);
+    const size_t TEXCOORD_BYTES = 2 * sizeof(GLfloat);
+    const size_t INDEX_BYTES = sizeof(uint32_t);
+}
+
+void IndirectRenderer::init() {
+    if (!GLEW_VERSION_4_3 || !(GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage)) {
+        console.addLog("Multi-draw indirect is not available, the render queue is drawn draw by draw");
+        return;
+    }
+
+    reserveRecords(MIN_RECORDS);
+    reserveCommands(MIN_REGION_COMMANDS);
+    available = mappedCommands != nullptr;
+    if (!available) {
+        console.addLog("Indirect command buffer could not be mapped, the render queue is drawn draw by draw");
+    }
+}
+
+void IndirectRenderer::release() {
+    for (GLsync& fence : fences) {
+        if (fence) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    if (commandBuffer != 0) {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+        glUnmapBuffer(GL_DRAW_INDIRECT_BUFFER);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        glDeleteBuffers(1, &commandBuffer);
+    }
+    for (Arena& arena : arenas) {
+        glDeleteVertexArrays(1, &arena.vao);
+        glDeleteBuffers(3, arena.buffers);
+    }
+    glDeleteBuffers(1, &recordBuffer);
+
+    arenas.clear();
+    entries.clear();
+    freeEntries.clear();
+    commandBuffer = recordBuffer = 0;
+    mappedCommands = nullptr;
+    regionCommands = 0;
+    recordCapacity = 0;
+    stats = IndirectStats();
+    available = false;
+}
+
+void IndirectRenderer::submit(const RenderQueue& queue) {
+    const auto start = submitClock::now();
+    RenderPipeline& pipeline = RenderPipeline::renderPipeline;
+    const std::vector<DrawPacket>& packets = queue.getPackets();
+    stats.commands = stats.multiDraws = 0;
+    if (packets.empty()) return;
+
+    // A packet is at most one command, and every record needs its number in the instanced attribute
+    reserveCommands(packets.size());
+    reserveRecords(pipeline.getStats().objects);
+
+    region = (region + 1) % FRAMES_IN_FLIGHT;
+    waitForRegion(region);
+    DrawCommand* commands = mappedCommands + region * regionCommands;
+    size_t written = 0;
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    for (size_t first = 0; first < packets.size();) {
+        // The queue is sorted by texture: each texture's runs of one mesh become commands, one call per arena
+        const GLuint texture = packets[first].texture;
+        size_t last = first;
+        while (last < packets.size() && packets[last].texture == texture) {
+            const DrawPacket& packet = packets[last];
+            const size_t count = queue.batchLength(last);
+            const Entry& entry = entries[entryOf(*packet.mesh)];
+
+            DrawCommand command;
+            command.count = static_cast<GLuint>(packet.mesh->getIndexCount());
+            command.instanceCount = static_cast<GLuint>(count);
+            command.firstIndex = entry.firstIndex;
+            command.baseVertex = entry.baseVertex;
+            command.baseInstance = static_cast<GLuint>(pipeline.getRecord(packet.entity));
+            arenas[entry.arena].pending.push_back(command);
+            arenas[entry.arena].pendingObjects += count;
+            last += count;
+        }
+
+        pipeline.setTexture(texture);
+        for (Arena& arena : arenas) {
+            if (arena.pending.empty()) continue;
+
+            std::copy(arena.pending.begin(), arena.pending.end(), commands + written);
+            const size_t offset = (region * regionCommands + written) * sizeof(DrawCommand);
+            pipeline.drawIndirect(arena.vao, offset, static_cast<GLsizei>(arena.pending.size()), arena.pendingObjects);
+            written += arena.pending.size();
+            arena.pending.clear();
+            arena.pendingObjects = 0;
+            stats.multiDraws++;
+        }
+        first = last;
+    }
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    // Signaled once the GPU has read this frame's commands, the region is written again three frames later
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    stats.commands = written;
+    stats.submitMs = std::chrono::duration<double, std::milli>(submitClock::now() - start).count();
+}
+
+void IndirectRenderer::forget(int entry) {
+    if (entry < 0 || entry >= static_cast<int>(entries.size())) return;
+
+    Entry& released = entries[entry];
+    Arena& arena = arenas[released.arena];
+    arena.liveMeshes--;
+    arena.deadBytes += released.bytes;
+    stats.deadBytes += released.bytes;
+    stats.meshes--;
+
+    // GL orders the copies after the draws already issued, so an empty arena is refilled from the start
+    if (arena.liveMeshes == 0) {
+        stats.deadBytes -= arena.deadBytes;
+        arena.deadBytes = 0;
+        arena.vertices = arena.indices = 0;
+    }
+    released.arena = -1;
+    freeEntries.push_back(entry);
+}
+
+// The mesh's place in an arena, copied there from its own buffers the first time
+int IndirectRenderer::entryOf(const GpuMesh& mesh) {
+    if (mesh.arenaEntry >= 0) return mesh.arenaEntry;
+
+    const int arenaIndex = arenaFor(mesh.vertexCount, mesh.indexCount);
+    Arena& arena = arenas[arenaIndex];
+
+    Entry entry;
+    entry.arena = arenaIndex;
+    entry.baseVertex = arena.vertices;
+    entry.firstIndex = static_cast<GLuint>(arena.indices);
+    entry.bytes = mesh.vertexCount * (POSITION_BYTES + TEXCOORD_BYTES) + mesh.indexCount * INDEX_BYTES;
+
+    glBindBuffer(GL_COPY_READ_BUFFER, mesh.vertexBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, arena.buffers[0]);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, arena.vertices * POSITION_BYTES, mesh.vertexCount * POSITION_BYTES);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, arena.buffers[1]);
+    if (mesh.texCoordBuffer != 0) {
+        glBindBuffer(GL_COPY_READ_BUFFER, mesh.texCoordBuffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, arena.vertices * TEXCOORD_BYTES, mesh.vertexCount * TEXCOORD_BYTES);
+    }
+    else {
+        const std::vector<GLfloat> zeros(mesh.vertexCount * 2, 0.0f);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, arena.vertices * TEXCOORD_BYTES, mesh.vertexCount * TEXCOORD_BYTES, zeros.data());
+    }
+
+    // Indices stay relative to the mesh, the command's base vertex offsets them
+    glBindBuffer(GL_COPY_READ_BUFFER, mesh.indexBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, arena.buffers[2]);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, arena.indices * INDEX_BYTES, mesh.indexCount * INDEX_BYTES);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    arena.vertices += mesh.vertexCount;
+    arena.indices += mesh.indexCount;
+    arena.liveMeshes++;
+    stats.meshes++;
+
+    int index;
+    if (!freeEntries.empty()) {
+        index = freeEntries.back();
+        freeEntries.pop_back();
+        entries[index] = entry;
+    }
+    else {
+        index = static_cast<int>(entries.size());
+        entries.push_back(entry);
+    }
+    mesh.arenaEntry = index;
+    return index;
+}
+
+int IndirectRenderer::arenaFor(GLint vertices, GLint indices) {
+    for (size_t i = 0; i < arenas.size(); i++) {
+        const Arena& arena = arenas[i];
+        if (arena.vertexCapacity - arena.vertices >= vertices && arena.indexCapacity - arena.indices >= indices) {
+            return static_cast<int>(i);
+        }
+    }
+
+    Arena arena;
+    arena.vertexCapacity = std::max(ARENA_VERTICES, vertices);
+    arena.indexCapacity = std::max(ARENA_INDICES, indices);
+    createArena(arena);
+    arenas.push_back(std::move(arena));
+
+    stats.arenas = arenas.size();
+    return static_cast<int>(arenas.size() - 1);
+}
+
+void IndirectRenderer::createArena(Arena& arena) {
+    const size_t positionBytes = arena.vertexCapacity * POSITION_BYTES;
+    const size_t texCoordBytes = arena.vertexCapacity * TEXCOORD_BYTES;
+    const size_t indexBytes = arena.indexCapacity * INDEX_BYTES;
+
+    glGenVertexArrays(1, &arena.vao);
+    glGenBuffers(3, arena.buffers);
+    glBindVertexArray(arena.vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, arena.buffers[0]);
+    glBufferData(GL_ARRAY_BUFFER, positionBytes, nullptr, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(RenderPipeline::POSITION_ATTRIBUTE);
+    glVertexAttribPointer(RenderPipeline::POSITION_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+    glBindBuffer(GL_ARRAY_BUFFER, arena.buffers[1]);
+    glBufferData(GL_ARRAY_BUFFER, texCoordBytes, nullptr, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(RenderPipeline::TEXCOORD_ATTRIBUTE);
+    glVertexAttribPointer(RenderPipeline::TEXCOORD_ATTRIBUTE, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+    // One value per instance, starting at the command's base instance
+    glBindBuffer(GL_ARRAY_BUFFER, recordBuffer);
+    glEnableVertexAttribArray(RenderPipeline::DRAW_RECORD_ATTRIBUTE);
+    glVertexAttribPointer(RenderPipeline::DRAW_RECORD_ATTRIBUTE, 1, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glVertexAttribDivisor(RenderPipeline::DRAW_RECORD_ATTRIBUTE, 1);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, arena.buffers[2]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, nullptr, GL_STATIC_DRAW);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    stats.residentBytes += positionBytes + texCoordBytes + indexBytes;
+}
+
+void IndirectRenderer::reserveCommands(size_t commands) {
+    if (commands <= regionCommands) return;
+    const size_t capacity = std::max({ regionCommands * 2, commands, MIN_REGION_COMMANDS });
+
+    // Storage is immutable, a bigger one replaces it once the GPU is done with every region
+    for (int i = 0; i < FRAMES_IN_FLIGHT; i++) {
+        waitForRegion(i);
+    }
+    if (commandBuffer != 0) {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+        glUnmapBuffer(GL_DRAW_INDIRECT_BUFFER);
+        glDeleteBuffers(1, &commandBuffer);
+    }
+
+    const GLsizeiptr bytes = capacity * FRAMES_IN_FLIGHT * sizeof(DrawCommand);
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &commandBuffer);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    glBufferStorage(GL_DRAW_INDIRECT_BUFFER, bytes, nullptr, flags);
+    mappedCommands = static_cast<DrawCommand*>(glMapBufferRange(GL_DRAW_INDIRECT_BUFFER, 0, bytes, flags));
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    regionCommands = capacity;
+}
+
+void IndirectRenderer::reserveRecords(size_t records) {
+    if (records <= static_cast<size_t>(recordCapacity)) return;
+    const size_t capacity = std::max({ static_cast<size_t>(recordCapacity) * 2, records, MIN_RECORDS });
+
+    // Same buffer name, so the arenas' vertex arrays keep pointing at it
+    std::vector<GLfloat> numbers(capacity);
+    std::iota(numbers.begin(), numbers.end(), 0.0f);
+    if (recordBuffer == 0) {
+        glGenBuffers(1, &recordBuffer);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, recordBuffer);
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(GLfloat), numbers.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    recordCapacity = static_cast<GLsizei>(capacity);
+}
+
+void IndirectRenderer::waitForRegion(int index) {
+    if (!fences[index]) return;
+
+    if (glClientWaitSync(fences[index], 0, 0) == GL_TIMEOUT_EXPIRED) {
+        stats.fenceWaits++;
+        while (glClientWaitSync(fences[index], GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS) == GL_TIMEOUT_EXPIRED) {
+        }
+    }
+    glDeleteSync(fences[index]);
+    fences[index] = nullptr;
+}
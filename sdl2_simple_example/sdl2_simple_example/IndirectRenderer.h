@@ -0,0 +1,110 @@
+#ifndef INDIRECTRENDERER_H
+#define INDIRECTRENDERER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <GL/glew.h>
+
+class GpuMesh;
+class RenderQueue;
+
+struct IndirectStats {
+    size_t arenas = 0;              // Shared geometry buffers
+    size_t meshes = 0;              // Meshes copied into them
+    size_t residentBytes = 0;       // Arena capacity on the GPU
+    size_t deadBytes = 0;           // Space of released meshes, reclaimed once their arena empties
+    size_t commands = 0;            // Indirect commands written this frame
+    size_t multiDraws = 0;          // glMultiDrawElementsIndirect calls this frame
+    size_t fenceWaits = 0;          // Frames that found their command region still in use
+    double submitMs = 0.0;          // CPU time of the last indirect submission
+    double classicSubmitMs = 0.0;   // CPU time of the last per-draw submission, to compare
+};
+
+// Draws the render queue with a handful of glMultiDrawElementsIndirect calls instead of one call per mesh.
+// Meshes are copied, on the GPU, from their own buffers into a few large arenas sharing one vertex array,
+// on their first indirect draw. Each frame the commands go into a persistently mapped buffer split in
+// three regions, one per frame in flight, each guarded by a fence so the CPU never overwrites commands
+// the GPU hasn't read yet. A command's base instance is the record of its first object, the shaders read it
+// back through an instanced attribute, so every draw of a call still finds its own matrix, tint and ID.
+// Needs GL 4.3 and persistent buffers (4.4 or ARB_buffer_storage), below that the queue is drawn draw by draw.
+class IndirectRenderer {
+public:
+    static IndirectRenderer indirectRenderer;
+
+    static const int FRAMES_IN_FLIGHT = 3;
+    // Capacity of a new arena, larger meshes get an arena of their own size
+    static const GLint ARENA_VERTICES = 1 << 19;
+    static const GLint ARENA_INDICES = 1 << 21;
+
+    void init();
+    // Deletes arenas and the command buffer, after GpuMesh::releaseAll(), the GL context must still be current
+    void release();
+    bool isActive() const { return enabled && available; }
+
+    // Draws the sorted queue, whose objects already have their records in the pipeline
+    void submit(const RenderQueue& queue);
+    // Timing of the other submission path, for the stats
+    void recordClassicSubmit(double milliseconds) { stats.classicSubmitMs = milliseconds; }
+    // A GpuMesh was released, its arena space is dead
+    void forget(int entry);
+
+    const IndirectStats& getStats() const { return stats; }
+
+    bool enabled = true;
+
+private:
+    struct DrawCommand {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    struct Arena {
+        GLuint vao = 0;
+        GLuint buffers[3] = {};     // Positions, texture coordinates, indices
+        GLint vertexCapacity = 0;
+        GLint indexCapacity = 0;
+        GLint vertices = 0;
+        GLint indices = 0;
+        size_t liveMeshes = 0;
+        size_t deadBytes = 0;
+        std::vector<DrawCommand> pending;       // This texture's commands, before they're copied out
+        size_t pendingObjects = 0;
+    };
+
+    struct Entry {
+        int arena = -1;
+        GLint baseVertex = 0;
+        GLuint firstIndex = 0;
+        size_t bytes = 0;
+    };
+
+    std::vector<Arena> arenas;
+    std::vector<Entry> entries;
+    std::vector<int> freeEntries;
+
+    // Record numbers 0..n-1, read once per instance from the base instance on
+    GLuint recordBuffer = 0;
+    GLsizei recordCapacity = 0;
+
+    GLuint commandBuffer = 0;
+    DrawCommand* mappedCommands = nullptr;
+    size_t regionCommands = 0;
+    GLsync fences[FRAMES_IN_FLIGHT] = {};
+    int region = 0;
+
+    bool available = false;
+    IndirectStats stats;
+
+    int entryOf(const GpuMesh& mesh);
+    int arenaFor(GLint vertices, GLint indices);
+    void createArena(Arena& arena);
+    void reserveCommands(size_t commands);
+    void reserveRecords(size_t records);
+    void waitForRegion(int index);
+};
+
+#endif // INDIRECTRENDERER_H
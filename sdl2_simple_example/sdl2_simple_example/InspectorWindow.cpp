@@ -20,13 +20,14 @@ void InspectorWindow::render(GameObject* selectedObject) {
     ImGui::Begin("Inspector", nullptr);
     if (selectedObject) {
         if (ImGui::CollapsingHeader("Object Info")) {
-            if (ImGui::Checkbox("Is Dynamic", &selectedObject->dynamic)) {
-                if (selectedObject->dynamic) {
-                    selectedObject->movementState = MovementState::Stopped;
-                    selectedObject->speed = 3.0f;
-                    selectedObject->movementRange = std::make_pair(-5.0f, 5.0f);
-                    selectedObject->movementDirection = 1.0f;
-                }
+            bool isDynamic = selectedObject->isDynamic();
+            if (ImGui::Checkbox("Is Dynamic", &isDynamic)) {
+                selectedObject->setDynamic(isDynamic);
+            }
+
+            bool isOccluder = selectedObject->isOccluder();
+            if (ImGui::Checkbox("Occluder", &isOccluder)) {
+                selectedObject->setOccluder(isOccluder);
             }
 
             bool isActive = selectedObject->getActive();
@@ -50,26 +51,15 @@ void InspectorWindow::render(GameObject* selectedObject) {
             glm::vec3 scale = selectedObject->getScale();
 
             if (selectedObject && selectedObject->getActive()) {
+                // Children follow their parent through the transform store, no propagation needed here
                 if (ImGui::DragFloat3("Position", glm::value_ptr(position), 0.1f)) {
                     selectedObject->setPosition(position);
-
-                    if (!selectedObject->children.empty()) {
-                        selectedObject->updateChildTransforms();
-                    }
                 }
                 if (ImGui::DragFloat3("Rotation", glm::value_ptr(rotation), 0.1f)) {
                     selectedObject->setRotation(rotation);
-
-                    if (!selectedObject->children.empty()) {
-                        selectedObject->updateChildTransforms();
-                    }
                 }
                 if (ImGui::DragFloat3("Scale", glm::value_ptr(scale), 0.1f, 0.1f, 10.0f)) {
                     selectedObject->setScale(scale);
-
-                    if (!selectedObject->children.empty()) {
-                        selectedObject->updateChildTransforms();
-                    }
                 }
 
                 if (ImGui::Button("Reset")) {
@@ -80,7 +70,7 @@ void InspectorWindow::render(GameObject* selectedObject) {
                 ImGui::Text("Object is deactivated and cannot be modified");
             }
         }
-        if (!selectedObject->isCamera) {
+        if (!selectedObject->isCamera()) {
             MeshData* meshData = selectedObject->getMeshData();
             if (meshData) {
                 if (ImGui::CollapsingHeader("Mesh Information")) {
@@ -134,14 +124,15 @@ void InspectorWindow::render(GameObject* selectedObject) {
         if (ImGui::CollapsingHeader("Texture Information")) {
             ImGui::TextWrapped("Object Path: %s", selectedObject->texturePath.c_str());
 
-                importer.getTextureDimensions(selectedObject->textureID, variables->texturewidth, variables->textureheight);
+                GLuint objectTextureID = selectedObject->getTextureID();
+                importer.getTextureDimensions(objectTextureID, variables->texturewidth, variables->textureheight);
                 ImGui::Text("Texture Dimensions: %d x %d", variables->texturewidth, variables->textureheight);
 
-                if (selectedObject->textureID != 0) {
+                if (objectTextureID != 0) {
                     ImGui::Separator();
                     ImGui::Text("Object Texture:");
                     ImVec2 textureSize(variables->texturewidth, variables->textureheight);
-                    ImGui::Image((void*)(intptr_t)selectedObject->textureID, ImVec2(150, 150), ImVec2(0, 1), ImVec2(1, 0));
+                    ImGui::Image((void*)(intptr_t)objectTextureID, ImVec2(150, 150), ImVec2(0, 1), ImVec2(1, 0));
                 }
                 else {
                     ImGui::Text("No texture assigned");
@@ -149,7 +140,7 @@ void InspectorWindow::render(GameObject* selectedObject) {
 
                 if (ImGui::Button("Checker Texture")) {
                     GLuint newTextureID = importer.loadTexture(variables->checkerTexture);
-                    variables->window->selectedObject->textureID = newTextureID;
+                    variables->window->selectedObject->setTexture(variables->window->selectedObject->texturePath, newTextureID);
 
                     variables->textureFilePath = variables->checkerTexture;
                 }
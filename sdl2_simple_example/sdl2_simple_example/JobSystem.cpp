@@ -0,0 +1,241 @@
+#include "JobSystem.h"
+#include "ConsoleWindow.h"
+#include <algorithm>
+#include <exception>
+
+JobSystem JobSystem::jobSystem;
+
+namespace {
+    // Index of the queue owned by the current thread, the main thread and foreign threads use 0
+    thread_local unsigned currentWorker = 0;
+}
+
+JobSystem::~JobSystem() {
+    shutdown();
+}
+
+void JobSystem::init(unsigned threadCount) {
+    if (!queues.empty()) return;
+
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    mainThreadId = std::this_thread::get_id();
+    currentWorker = 0;
+    stopping = false;
+
+    for (unsigned i = 0; i < threadCount; ++i) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (unsigned i = 1; i < threadCount; ++i) {
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+void JobSystem::shutdown() {
+    if (queues.empty()) return;
+
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+
+    // Nobody waited on what is left, finish it here so no counter stays pending
+    while (tryRunJob() || runMainThreadJob()) {}
+    queues.clear();
+}
+
+void JobSystem::run(std::function<void()> function, JobCounter* counter) {
+    if (counter) {
+        counter->pending.fetch_add(1, std::memory_order_relaxed);
+    }
+    schedule(Job{ std::move(function), counter, false });
+}
+
+void JobSystem::runAfter(JobCounter& dependency, std::function<void()> function, JobCounter* counter) {
+    if (counter) {
+        counter->pending.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Job job{ std::move(function), counter, false };
+    {
+        std::lock_guard<std::mutex> guard(dependency.lock);
+        if (!dependency.isDone()) {
+            dependency.continuations.push_back(std::move(job));
+            return;
+        }
+    }
+    schedule(std::move(job));
+}
+
+void JobSystem::runOnMainThread(std::function<void()> function, JobCounter* counter) {
+    if (counter) {
+        counter->pending.fetch_add(1, std::memory_order_relaxed);
+    }
+    schedule(Job{ std::move(function), counter, true });
+}
+
+void JobSystem::pumpMainThread() {
+    while (runMainThreadJob()) {}
+
+    // Without workers nothing else would pick up fire-and-forget jobs
+    if (workers.empty()) {
+        while (tryRunJob()) {}
+    }
+}
+
+void JobSystem::wait(JobCounter& counter) {
+    while (!counter.isDone()) {
+        if (tryRunJob()) continue;
+        if (isMainThread() && runMainThreadJob()) continue;
+        std::this_thread::yield();
+    }
+
+    // The thread finishing the last job may still be holding the lock
+    std::lock_guard<std::mutex> sync(counter.lock);
+}
+
+void JobSystem::parallelFor(size_t count, size_t minBatch, const std::function<void(size_t begin, size_t end)>& body) {
+    if (count == 0) return;
+
+    // A few batches per thread so threads finishing early can steal the rest
+    const size_t maxBatches = static_cast<size_t>(getThreadCount()) * 4;
+    const size_t batches = std::min(maxBatches, (count + std::max<size_t>(minBatch, 1) - 1) / std::max<size_t>(minBatch, 1));
+    if (batches <= 1 || workers.empty()) {
+        body(0, count);
+        return;
+    }
+
+    const size_t batchSize = (count + batches - 1) / batches;
+    JobCounter counter;
+    for (size_t begin = batchSize; begin < count; begin += batchSize) {
+        const size_t end = std::min(count, begin + batchSize);
+        run([&body, begin, end]() { body(begin, end); }, &counter);
+    }
+
+    // The calling thread takes the first batch itself
+    body(0, batchSize);
+    wait(counter);
+}
+
+void JobSystem::schedule(Job job) {
+    if (queues.empty()) {
+        execute(job);
+        return;
+    }
+
+    if (job.mainThreadOnly) {
+        std::lock_guard<std::mutex> guard(mainThreadLock);
+        mainThreadJobs.push_back(std::move(job));
+        return;
+    }
+
+    {
+        WorkerQueue& queue = *queues[currentWorker < queues.size() ? currentWorker : 0];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        queue.jobs.push_back(std::move(job));
+    }
+    queuedJobs.fetch_add(1, std::memory_order_release);
+
+    // Taking the lock orders this with a worker checking queuedJobs right before sleeping
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+    }
+    wakeUp.notify_one();
+}
+
+void JobSystem::execute(Job& job) {
+    try {
+        job.function();
+    }
+    catch (const std::exception& e) {
+        console.addLog("Job failed: " + std::string(e.what()));
+    }
+
+    if (job.counter) {
+        finish(*job.counter);
+    }
+}
+
+void JobSystem::finish(JobCounter& counter) {
+    std::vector<Job> ready;
+    {
+        std::lock_guard<std::mutex> guard(counter.lock);
+        if (counter.pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            ready.swap(counter.continuations);
+        }
+    }
+
+    // The counter may be gone from here on
+    for (Job& job : ready) {
+        schedule(std::move(job));
+    }
+}
+
+bool JobSystem::tryRunJob() {
+    if (queues.empty() || queuedJobs.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+
+    const size_t queueCount = queues.size();
+    const unsigned self = currentWorker < queueCount ? currentWorker : 0;
+    Job job;
+    bool found = false;
+
+    // Own queue from the back (most recent, still in cache), then steal the oldest job from the others
+    {
+        WorkerQueue& own = *queues[self];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.jobs.empty()) {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            found = true;
+        }
+    }
+    for (size_t offset = 1; !found && offset < queueCount; ++offset) {
+        WorkerQueue& victim = *queues[(self + offset) % queueCount];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.jobs.empty()) {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            found = true;
+        }
+    }
+
+    if (!found) return false;
+
+    queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    execute(job);
+    return true;
+}
+
+bool JobSystem::runMainThreadJob() {
+    Job job;
+    {
+        std::lock_guard<std::mutex> guard(mainThreadLock);
+        if (mainThreadJobs.empty()) return false;
+        job = std::move(mainThreadJobs.front());
+        mainThreadJobs.pop_front();
+    }
+    execute(job);
+    return true;
+}
+
+void JobSystem::workerLoop(unsigned index) {
+    currentWorker = index;
+
+    while (true) {
+        if (tryRunJob()) continue;
+
+        std::unique_lock<std::mutex> guard(sleepLock);
+        wakeUp.wait(guard, [this]() { return stopping || queuedJobs.load(std::memory_order_acquire) > 0; });
+        if (stopping) return;
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobCounter;
+
+struct Job {
+    std::function<void()> function;
+    JobCounter* counter = nullptr;
+    bool mainThreadOnly = false;
+};
+
+// Number of unfinished jobs in a group. It is incremented when a job is scheduled with it and
+// decremented when the job ends, JobSystem::wait() joins the group and runAfter() chains on it.
+// Must outlive the jobs using it.
+class JobCounter {
+public:
+    JobCounter() = default;
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+
+    std::atomic<int> pending{ 0 };
+    std::mutex lock;
+    std::vector<Job> continuations;    // Jobs waiting for this counter to reach zero
+};
+
+// Work-stealing job scheduler shared by the whole engine.
+// Every thread owns a deque: it pushes and pops its own jobs at the back, idle threads steal from
+// the front of the others. The main thread is worker 0 and only runs jobs while it waits on a counter.
+// GL calls must go through runOnMainThread(), those jobs run in pumpMainThread() once per frame.
+class JobSystem {
+public:
+    static JobSystem jobSystem;
+
+    ~JobSystem();
+
+    // threadCount includes the main thread, 0 uses every hardware thread.
+    // Before init() jobs run inline on the calling thread.
+    void init(unsigned threadCount = 0);
+    void shutdown();
+
+    unsigned getThreadCount() const { return static_cast<unsigned>(workers.size()) + 1; }
+    bool isMainThread() const { return std::this_thread::get_id() == mainThreadId; }
+
+    void run(std::function<void()> function, JobCounter* counter = nullptr);
+    // The job is only queued once 'dependency' reaches zero
+    void runAfter(JobCounter& dependency, std::function<void()> function, JobCounter* counter = nullptr);
+    void runOnMainThread(std::function<void()> function, JobCounter* counter = nullptr);
+    void pumpMainThread();
+
+    // Runs other jobs on this thread until the counter reaches zero
+    void wait(JobCounter& counter);
+
+    // Calls body(begin, end) over [0, count) in batches of at least minBatch items, blocks until done
+    void parallelFor(size_t count, size_t minBatch, const std::function<void(size_t begin, size_t end)>& body);
+
+private:
+    struct WorkerQueue {
+        std::mutex lock;
+        std::deque<Job> jobs;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<int> queuedJobs{ 0 };
+    std::thread::id mainThreadId = std::this_thread::get_id();
+
+    std::mutex sleepLock;
+    std::condition_variable wakeUp;
+    bool stopping = false;
+
+    std::mutex mainThreadLock;
+    std::deque<Job> mainThreadJobs;
+
+    void schedule(Job job);
+    void execute(Job& job);
+    void finish(JobCounter& counter);
+    bool tryRunJob();
+    bool runMainThreadJob();
+    void workerLoop(unsigned index);
+};
+
+#endif // JOBSYSTEM_H
@@ -0,0 +1,186 @@
+#include "LooseOctree.h"
+#include <cmath>
+
+namespace {
+    // Cell bounds are this many times their nominal size
+    const float LOOSENESS = 2.0f;
+    // Small objects stop descending once cells would average fewer items than this, levels are
+    // mostly flat so each level is counted as 4 times more cells, not 8
+    const float TARGET_ITEMS_PER_CELL = 8.0f;
+
+    AABB looseBounds(const glm::vec3& center, float halfSize) {
+        return AABB::fromCenterExtents(center, glm::vec3(halfSize * LOOSENESS));
+    }
+}
+
+void LooseOctree::clear() {
+    nodes.clear();
+    items.clear();
+    depth = 0;
+}
+
+void LooseOctree::build(std::vector<Item> newItems) {
+    clear();
+    if (newItems.empty()) return;
+
+    // Cubic root cell around every box
+    AABB bounds = newItems[0].box;
+    for (const Item& item : newItems) {
+        bounds = AABB::merge(bounds, item.box);
+    }
+    const glm::vec3 rootExtents = bounds.extents();
+    const float rootHalf = std::max(std::max(std::max(rootExtents.x, rootExtents.y), rootExtents.z), 0.5f) * 1.001f;
+
+    // Cells are created along the path of each item, in insertion order for now
+    std::vector<Node> built(1);
+    built[0].center = bounds.center();
+    built[0].halfSize = rootHalf;
+
+    const float levelsNeeded = std::log2(std::max(1.0f, newItems.size() / TARGET_ITEMS_PER_CELL)) * 0.5f;
+    const int depthLimit = std::min(maxDepth, static_cast<int>(std::ceil(levelsNeeded)));
+
+    std::vector<int> itemNodes(newItems.size());
+    for (size_t i = 0; i < newItems.size(); ++i) {
+        const glm::vec3 center = newItems[i].box.center();
+        const glm::vec3 extents = newItems[i].box.extents();
+        const float radius = std::max(std::max(extents.x, extents.y), extents.z);
+
+        // Deepest level whose cells are still at least as large as the object
+        int targetDepth = depthLimit;
+        if (radius > 0.0f) {
+            targetDepth = std::min(depthLimit, std::max(0, static_cast<int>(std::floor(std::log2(rootHalf / radius)))));
+        }
+
+        int node = 0;
+        for (int level = 0; level < targetDepth; ++level) {
+            const glm::vec3 nodeCenter = built[node].center;
+            const int octant = (center.x >= nodeCenter.x ? 1 : 0) | (center.y >= nodeCenter.y ? 2 : 0) | (center.z >= nodeCenter.z ? 4 : 0);
+
+            if (built[node].children[octant] < 0) {
+                const float childHalf = built[node].halfSize * 0.5f;
+                Node child;
+                child.halfSize = childHalf;
+                child.center = nodeCenter + glm::vec3((octant & 1) ? childHalf : -childHalf,
+                    (octant & 2) ? childHalf : -childHalf, (octant & 4) ? childHalf : -childHalf);
+                built[node].children[octant] = static_cast<int>(built.size());
+                built.push_back(child);
+            }
+            node = built[node].children[octant];
+        }
+        itemNodes[i] = node;
+    }
+
+    // Depth first layout: every subtree becomes a contiguous range of cells
+    std::vector<int> order(built.size());
+    std::vector<int> levels(built.size(), 0);
+    nodes.resize(built.size());
+    int next = 0;
+    std::vector<int> pending = { 0 };
+    while (!pending.empty()) {
+        const int old = pending.back();
+        pending.pop_back();
+        order[old] = next++;
+
+        // Reversed so the children come out in octant order
+        for (int octant = 7; octant >= 0; --octant) {
+            const int child = built[old].children[octant];
+            if (child >= 0) {
+                levels[child] = levels[old] + 1;
+                pending.push_back(child);
+            }
+        }
+    }
+
+    for (size_t old = 0; old < built.size(); ++old) {
+        Node& node = nodes[order[old]];
+        node = built[old];
+        node.looseBox = looseBounds(node.center, node.halfSize);
+        for (int& child : node.children) {
+            if (child >= 0) {
+                child = order[child];
+            }
+        }
+        depth = std::max(depth, levels[old]);
+    }
+
+    // Items sorted by cell with a counting sort, which keeps the insertion order inside each cell
+    std::vector<uint32_t> counts(nodes.size() + 1, 0);
+    for (int node : itemNodes) {
+        counts[order[node] + 1]++;
+    }
+    for (size_t i = 1; i < counts.size(); ++i) {
+        counts[i] += counts[i - 1];
+    }
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        nodes[i].itemBegin = counts[i];
+        nodes[i].itemEnd = counts[i + 1];
+    }
+
+    items.resize(newItems.size());
+    for (size_t i = 0; i < newItems.size(); ++i) {
+        items[counts[order[itemNodes[i]]]++] = newItems[i];
+    }
+
+    // Subtree ends, children always come after their parent so a reverse sweep sees them first
+    for (size_t i = nodes.size(); i-- > 0;) {
+        Node& node = nodes[i];
+        node.subtreeNodeEnd = static_cast<uint32_t>(i + 1);
+        node.subtreeItemEnd = node.itemEnd;
+        for (int child : node.children) {
+            if (child >= 0) {
+                node.subtreeNodeEnd = std::max(node.subtreeNodeEnd, nodes[child].subtreeNodeEnd);
+                node.subtreeItemEnd = std::max(node.subtreeItemEnd, nodes[child].subtreeItemEnd);
+            }
+        }
+    }
+}
+
+size_t LooseOctree::queryFrustum(const Frustum& frustum, std::vector<uint32_t>& outIds) const {
+    if (nodes.empty()) return 0;
+
+    size_t visibleCells = 0;
+    struct Entry { int node; uint32_t planeMask; };
+    std::vector<Entry> entries;
+    entries.reserve(64);
+    entries.push_back({ 0, Frustum::ALL_PLANES });
+
+    while (!entries.empty()) {
+        const Entry entry = entries.back();
+        entries.pop_back();
+        const Node& node = nodes[entry.node];
+
+        uint32_t planeMask = entry.planeMask;
+        const Frustum::Result result = frustum.classify(node.looseBox, planeMask);
+        if (result == Frustum::Result::Outside) continue;
+
+        if (result == Frustum::Result::Inside) {
+            // The whole subtree is visible and already contiguous
+            for (uint32_t i = node.itemBegin; i < node.subtreeItemEnd; ++i) {
+                outIds.push_back(items[i].id);
+            }
+            for (uint32_t i = static_cast<uint32_t>(entry.node); i < node.subtreeNodeEnd; ++i) {
+                visibleCells += nodes[i].itemBegin != nodes[i].itemEnd;
+            }
+            continue;
+        }
+
+        // Only the planes the cell straddles can reject its items
+        bool anyVisible = false;
+        for (uint32_t i = node.itemBegin; i < node.itemEnd; ++i) {
+            uint32_t itemMask = planeMask;
+            if (frustum.classify(items[i].box, itemMask) != Frustum::Result::Outside) {
+                outIds.push_back(items[i].id);
+                anyVisible = true;
+            }
+        }
+        visibleCells += anyVisible;
+
+        // Reversed so the cells are visited in layout order
+        for (int octant = 7; octant >= 0; --octant) {
+            if (node.children[octant] >= 0) {
+                entries.push_back({ node.children[octant], planeMask });
+            }
+        }
+    }
+    return visibleCells;
+}
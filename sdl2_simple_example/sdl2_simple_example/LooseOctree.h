@@ -0,0 +1,134 @@
+#ifndef LOOSEOCTREE_H
+#define LOOSEOCTREE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "Bounds.h"
+
+// Loose octree over boxes that don't move, built in one pass.
+// Each cell's bounds are twice its nominal size, so an object is stored in the deepest cell at least as
+// large as itself that contains its center, and never has to straddle two cells. After the build, cells
+// are laid out depth first and items sorted by cell: a cell's own items and those of its whole subtree
+// are contiguous ranges, which is also the order queries report them in.
+class LooseOctree {
+public:
+    struct Item {
+        AABB box;
+        uint32_t id = 0;
+    };
+
+    // Replaces the whole octree
+    void build(std::vector<Item> newItems);
+    void clear();
+
+    // Appends the id of every item intersecting the frustum, cell by cell.
+    // Returns the number of cells that had at least one visible item.
+    size_t queryFrustum(const Frustum& frustum, std::vector<uint32_t>& outIds) const;
+
+    // visit(item) for every item overlapping the box
+    template <typename Function>
+    void queryBox(const AABB& box, Function&& visit) const;
+
+    // visit(item, entry) for every item the ray crosses, returns the distance to keep searching within
+    template <typename Function>
+    void raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Function&& visit) const;
+
+    const std::vector<Item>& getItems() const { return items; }
+    size_t getNodeCount() const { return nodes.size(); }
+    int getDepth() const { return depth; }
+
+    // Cells below this depth are never created, small objects share the deepest cells.
+    // Sparse sets stop earlier, see build().
+    int maxDepth = 8;
+
+private:
+    struct Node {
+        glm::vec3 center = glm::vec3(0.0f);
+        float halfSize = 0.0f;
+        AABB looseBox;
+        int children[8] = { -1, -1, -1, -1, -1, -1, -1, -1 };
+        uint32_t itemBegin = 0;     // Items stored in this cell
+        uint32_t itemEnd = 0;
+        uint32_t subtreeItemEnd = 0; // Items of the cell and all its descendants end here
+        uint32_t subtreeNodeEnd = 0; // Same for the descendant cells, which follow the cell
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Item> items;
+    int depth = 0;
+
+    // Scratch stack shared by the queries, the octree is only queried from one thread at a time
+    mutable std::vector<int> stack;
+};
+
+template <typename Function>
+void LooseOctree::queryBox(const AABB& box, Function&& visit) const {
+    if (nodes.empty()) return;
+
+    stack.clear();
+    stack.push_back(0);
+    while (!stack.empty()) {
+        const Node& node = nodes[stack.back()];
+        stack.pop_back();
+        if (!node.looseBox.overlaps(box)) continue;
+
+        for (uint32_t i = node.itemBegin; i < node.itemEnd; ++i) {
+            if (items[i].box.overlaps(box)) {
+                visit(items[i]);
+            }
+        }
+        for (int child : node.children) {
+            if (child >= 0) {
+                stack.push_back(child);
+            }
+        }
+    }
+}
+
+template <typename Function>
+void LooseOctree::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Function&& visit) const {
+    if (nodes.empty()) return;
+
+    const float infinity = std::numeric_limits<float>::infinity();
+    const glm::vec3 invDirection(direction.x != 0.0f ? 1.0f / direction.x : infinity,
+        direction.y != 0.0f ? 1.0f / direction.y : infinity,
+        direction.z != 0.0f ? 1.0f / direction.z : infinity);
+
+    struct Entry { int node; float entry; };
+    std::vector<Entry> entries;
+    entries.reserve(64);
+
+    float entry = 0.0f;
+    if (!nodes[0].looseBox.intersectsRay(origin, invDirection, maxDistance, entry)) return;
+    entries.push_back({ 0, entry });
+
+    while (!entries.empty()) {
+        const Entry current = entries.back();
+        entries.pop_back();
+        if (current.entry > maxDistance) continue;
+
+        const Node& node = nodes[current.node];
+        for (uint32_t i = node.itemBegin; i < node.itemEnd; ++i) {
+            float itemEntry = 0.0f;
+            if (items[i].box.intersectsRay(origin, invDirection, maxDistance, itemEntry)) {
+                maxDistance = visit(items[i], itemEntry);
+            }
+        }
+
+        // Children crossed by the ray, pushed farthest first so the nearest is visited next
+        Entry hits[8];
+        int hitCount = 0;
+        for (int child : node.children) {
+            float childEntry = 0.0f;
+            if (child >= 0 && nodes[child].looseBox.intersectsRay(origin, invDirection, maxDistance, childEntry)) {
+                hits[hitCount++] = { child, childEntry };
+            }
+        }
+        std::sort(hits, hits + hitCount, [](const Entry& a, const Entry& b) { return a.entry > b.entry; });
+        entries.insert(entries.end(), hits, hits + hitCount);
+    }
+}
+
+#endif // LOOSEOCTREE_H
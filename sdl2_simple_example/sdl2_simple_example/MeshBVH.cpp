@@ -0,0 +1,336 @@
+#include "MeshBVH.h"
+#include "GameObject.h"
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace {
+    const int BIN_COUNT = 12;
+
+    // Splits deeper than this fall back to the median, which keeps the traversal stack bounded
+    const int MAX_SAH_DEPTH = 48;
+    const int STACK_SIZE = 128;
+
+    // Leaves this large are split even when the heuristic prefers not to
+    const uint32_t MAX_LEAF_SIZE = 16;
+
+    AABB emptyBox() {
+        return AABB(glm::vec3(std::numeric_limits<float>::max()), glm::vec3(-std::numeric_limits<float>::max()));
+    }
+
+    struct Bin {
+        AABB box = emptyBox();
+        uint32_t count = 0;
+    };
+
+    // Clips the triangle against each plane in turn, something is left only when part of it is inside
+    bool triangleOverlapsFrustum(const Frustum& frustum, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2) {
+        // One plane adds at most one vertex
+        glm::vec3 polygon[3 + Frustum::PLANE_COUNT];
+        glm::vec3 clipped[3 + Frustum::PLANE_COUNT];
+        polygon[0] = v0;
+        polygon[1] = v1;
+        polygon[2] = v2;
+        int count = 3;
+
+        for (const glm::vec4& plane : frustum.planes) {
+            const glm::vec3 normal(plane);
+            int clippedCount = 0;
+            for (int i = 0; i < count; ++i) {
+                const glm::vec3& a = polygon[i];
+                const glm::vec3& b = polygon[(i + 1) % count];
+                const float da = glm::dot(normal, a) + plane.w;
+                const float db = glm::dot(normal, b) + plane.w;
+                if (da >= 0.0f) {
+                    clipped[clippedCount++] = a;
+                }
+                if ((da >= 0.0f) != (db >= 0.0f)) {
+                    clipped[clippedCount++] = a + (b - a) * (da / (da - db));
+                }
+            }
+            if (clippedCount == 0) return false;
+
+            std::copy(clipped, clipped + clippedCount, polygon);
+            count = clippedCount;
+        }
+        return true;
+    }
+
+    // Moved around during the build instead of indexed, so every pass over a node reads memory in order
+    struct BuildTriangle {
+        AABB box;
+        glm::vec3 centroid;
+        uint32_t id;
+    };
+
+    void growBox(AABB& box, const AABB& other) {
+        box.min = glm::min(box.min, other.min);
+        box.max = glm::max(box.max, other.max);
+    }
+}
+
+const MeshBVH& MeshBVH::of(const MeshData& mesh) {
+    if (!mesh.bvh) {
+        std::shared_ptr<MeshBVH> bvh = std::make_shared<MeshBVH>();
+        bvh->build(mesh.vertices, mesh.indices);
+        mesh.bvh = bvh;
+    }
+    return *mesh.bvh;
+}
+
+void MeshBVH::build(const std::vector<float>& vertices, const std::vector<uint32_t>& indices) {
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    nodes.clear();
+    triangles.clear();
+    triangleIds.clear();
+    depth = 0;
+
+    const uint32_t vertexCount = static_cast<uint32_t>(vertices.size() / 3);
+    auto vertexAt = [&](uint32_t index) {
+        return glm::vec3(vertices[index * 3], vertices[index * 3 + 1], vertices[index * 3 + 2]);
+    };
+
+    // Triangles with an index past the vertex array are left out, their ids are never reported
+    std::vector<BuildTriangle> order;
+    const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    order.reserve(triangleCount);
+    for (uint32_t t = 0; t < triangleCount; ++t) {
+        const uint32_t i0 = indices[t * 3], i1 = indices[t * 3 + 1], i2 = indices[t * 3 + 2];
+        if (i0 >= vertexCount || i1 >= vertexCount || i2 >= vertexCount) continue;
+
+        const glm::vec3 a = vertexAt(i0), b = vertexAt(i1), c = vertexAt(i2);
+        order.push_back({ AABB(glm::min(a, glm::min(b, c)), glm::max(a, glm::max(b, c))), (a + b + c) * (1.0f / 3.0f), t });
+    }
+    if (order.empty()) {
+        buildMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        return;
+    }
+
+    nodes.reserve(order.size() * 2 / MAX_LEAF_TRIANGLES + 1);
+    nodes.emplace_back();
+
+    struct Task { uint32_t node, begin, end; int depth; };
+    std::vector<Task> tasks;
+    tasks.push_back({ 0, 0, static_cast<uint32_t>(order.size()), 1 });
+
+    while (!tasks.empty()) {
+        const Task task = tasks.back();
+        tasks.pop_back();
+        depth = std::max(depth, task.depth);
+
+        AABB box = emptyBox();
+        AABB centroidBox = emptyBox();
+        for (uint32_t i = task.begin; i < task.end; ++i) {
+            growBox(box, order[i].box);
+            growBox(centroidBox, AABB(order[i].centroid, order[i].centroid));
+        }
+        nodes[task.node].box = box;
+
+        const uint32_t count = task.end - task.begin;
+        const glm::vec3 centroidSize = centroidBox.max - centroidBox.min;
+        const int longestAxis = centroidSize.x >= centroidSize.y ? (centroidSize.x >= centroidSize.z ? 0 : 2) : (centroidSize.y >= centroidSize.z ? 1 : 2);
+
+        // All centroids on one point: nothing to split on
+        bool makeLeaf = count <= static_cast<uint32_t>(MAX_LEAF_TRIANGLES) || centroidSize[longestAxis] <= 0.0f;
+        uint32_t middle = task.begin;
+
+        if (!makeLeaf && task.depth < MAX_SAH_DEPTH) {
+            // Binned SAH: cost of each of the BIN_COUNT - 1 planes on every axis, from prefix and suffix sweeps
+            float bestCost = std::numeric_limits<float>::max();
+            int bestAxis = -1;
+            int bestSplit = 0;
+
+            // One pass fills the bins of all three axes
+            Bin bins[3][BIN_COUNT];
+            glm::vec3 scale(0.0f);
+            for (int axis = 0; axis < 3; ++axis) {
+                scale[axis] = centroidSize[axis] > 0.0f ? BIN_COUNT / centroidSize[axis] : 0.0f;
+            }
+            for (uint32_t i = task.begin; i < task.end; ++i) {
+                const BuildTriangle& triangle = order[i];
+                for (int axis = 0; axis < 3; ++axis) {
+                    const int bin = std::min(BIN_COUNT - 1, static_cast<int>((triangle.centroid[axis] - centroidBox.min[axis]) * scale[axis]));
+                    bins[axis][bin].count++;
+                    growBox(bins[axis][bin].box, triangle.box);
+                }
+            }
+
+            for (int axis = 0; axis < 3; ++axis) {
+                if (centroidSize[axis] <= 0.0f) continue;
+
+                float leftArea[BIN_COUNT - 1];
+                uint32_t leftCount[BIN_COUNT - 1];
+                AABB leftBox = emptyBox();
+                uint32_t leftSum = 0;
+                for (int b = 0; b < BIN_COUNT - 1; ++b) {
+                    leftSum += bins[axis][b].count;
+                    if (bins[axis][b].count > 0) growBox(leftBox, bins[axis][b].box);
+                    leftCount[b] = leftSum;
+                    leftArea[b] = leftSum > 0 ? leftBox.area() : 0.0f;
+                }
+
+                AABB rightBox = emptyBox();
+                uint32_t rightSum = 0;
+                for (int b = BIN_COUNT - 1; b > 0; --b) {
+                    rightSum += bins[axis][b].count;
+                    if (bins[axis][b].count > 0) growBox(rightBox, bins[axis][b].box);
+                    if (leftCount[b - 1] == 0 || rightSum == 0) continue;
+
+                    const float cost = leftCount[b - 1] * leftArea[b - 1] + rightSum * rightBox.area();
+                    if (cost < bestCost) {
+                        bestCost = cost;
+                        bestAxis = axis;
+                        bestSplit = b;
+                    }
+                }
+            }
+
+            // Splitting only pays off when the children are cheaper than testing every triangle here
+            if (bestAxis < 0 || (bestCost >= count * box.area() && count <= MAX_LEAF_SIZE)) {
+                makeLeaf = count <= MAX_LEAF_SIZE;
+            }
+            else {
+                const float axisScale = scale[bestAxis];
+                const float minimum = centroidBox.min[bestAxis];
+                middle = static_cast<uint32_t>(std::partition(order.begin() + task.begin, order.begin() + task.end, [&](const BuildTriangle& triangle) {
+                    return std::min(BIN_COUNT - 1, static_cast<int>((triangle.centroid[bestAxis] - minimum) * axisScale)) < bestSplit;
+                }) - order.begin());
+            }
+        }
+
+        if (makeLeaf) {
+            nodes[task.node].first = task.begin;
+            nodes[task.node].count = count;
+            continue;
+        }
+
+        // Too deep for the heuristic, or it found no plane that separates anything: halve on the longest axis
+        if (middle == task.begin || middle == task.end) {
+            middle = task.begin + count / 2;
+            std::nth_element(order.begin() + task.begin, order.begin() + middle, order.begin() + task.end, [&](const BuildTriangle& a, const BuildTriangle& b) {
+                return a.centroid[longestAxis] < b.centroid[longestAxis];
+            });
+        }
+
+        const uint32_t left = static_cast<uint32_t>(nodes.size());
+        nodes.emplace_back();
+        nodes.emplace_back();
+        nodes[task.node].first = left;
+        nodes[task.node].count = 0;
+
+        tasks.push_back({ left + 1, middle, task.end, task.depth + 1 });
+        tasks.push_back({ left, task.begin, middle, task.depth + 1 });
+    }
+
+    triangles.reserve(order.size());
+    triangleIds.resize(order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        const uint32_t t = order[i].id;
+        triangleIds[i] = t;
+        triangles.add(vertexAt(indices[t * 3]), vertexAt(indices[t * 3 + 1]), vertexAt(indices[t * 3 + 2]));
+    }
+
+    buildMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+bool MeshBVH::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, MeshRayHit& hit) const {
+    if (nodes.empty()) return false;
+
+    const float infinity = std::numeric_limits<float>::infinity();
+    const glm::vec3 invDirection(direction.x != 0.0f ? 1.0f / direction.x : infinity,
+        direction.y != 0.0f ? 1.0f / direction.y : infinity,
+        direction.z != 0.0f ? 1.0f / direction.z : infinity);
+
+    float entry = 0.0f;
+    if (!nodes[0].box.intersectsRay(origin, invDirection, maxDistance, entry)) return false;
+
+    struct Entry { uint32_t node; float entry; };
+    Entry stack[STACK_SIZE];
+    int stackSize = 0;
+
+    bool found = false;
+    uint32_t current = 0;
+
+    while (true) {
+        const Node& node = nodes[current];
+
+        if (node.count > 0) {
+            TriangleHit triangleHit;
+            if (RayKernels::intersectClosest(triangles, node.first, node.first + node.count, origin, direction, maxDistance, triangleHit)) {
+                hit.distance = triangleHit.distance;
+                hit.triangle = triangleIds[triangleHit.index];
+                hit.u = triangleHit.u;
+                hit.v = triangleHit.v;
+                found = true;
+            }
+        }
+        else {
+            // Nearest child first, the other one waits on the stack with its entry distance
+            float leftEntry = 0.0f, rightEntry = 0.0f;
+            const bool leftHit = nodes[node.first].box.intersectsRay(origin, invDirection, maxDistance, leftEntry);
+            const bool rightHit = nodes[node.first + 1].box.intersectsRay(origin, invDirection, maxDistance, rightEntry);
+
+            if (leftHit && rightHit) {
+                const bool leftFirst = leftEntry <= rightEntry;
+                stack[stackSize++] = leftFirst ? Entry{ node.first + 1, rightEntry } : Entry{ node.first, leftEntry };
+                current = leftFirst ? node.first : node.first + 1;
+                continue;
+            }
+            if (leftHit || rightHit) {
+                current = leftHit ? node.first : node.first + 1;
+                continue;
+            }
+        }
+
+        // Entries farther than the closest hit found since they were pushed are dropped
+        bool next = false;
+        while (stackSize > 0) {
+            const Entry pending = stack[--stackSize];
+            if (pending.entry <= maxDistance) {
+                current = pending.node;
+                next = true;
+                break;
+            }
+        }
+        if (!next) break;
+    }
+    return found;
+}
+
+bool MeshBVH::overlapsFrustum(const Frustum& frustum) const {
+    if (nodes.empty()) return false;
+
+    // Planes a node is fully in front of are skipped for its whole subtree
+    struct Entry { uint32_t node; uint32_t planeMask; };
+    Entry stack[STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = { 0, Frustum::ALL_PLANES };
+
+    while (stackSize > 0) {
+        const Entry entry = stack[--stackSize];
+        const Node& node = nodes[entry.node];
+
+        uint32_t planeMask = entry.planeMask;
+        const Frustum::Result result = frustum.classify(node.box, planeMask);
+        if (result == Frustum::Result::Outside) continue;
+        // Every node holds at least one triangle
+        if (result == Frustum::Result::Inside) return true;
+
+        if (node.count == 0) {
+            stack[stackSize++] = { node.first, planeMask };
+            stack[stackSize++] = { node.first + 1, planeMask };
+            continue;
+        }
+
+        for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+            const glm::vec3 v0(triangles.v0x[i], triangles.v0y[i], triangles.v0z[i]);
+            const glm::vec3 v1 = v0 + glm::vec3(triangles.e1x[i], triangles.e1y[i], triangles.e1z[i]);
+            const glm::vec3 v2 = v0 + glm::vec3(triangles.e2x[i], triangles.e2y[i], triangles.e2z[i]);
+            if (triangleOverlapsFrustum(frustum, v0, v1, v2)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,60 @@
+#ifndef MESHBVH_H
+#define MESHBVH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Bounds.h"
+#include "RayKernels.h"
+
+struct MeshData;
+
+// Closest triangle along a ray, in the mesh's own space
+struct MeshRayHit {
+    float distance = 0.0f;      // Ray parameter, in units of the direction's length
+    uint32_t triangle = 0;      // Index of the triangle in MeshData::indices / 3
+    float u = 0.0f;             // Barycentrics of the hit: point = (1 - u - v) * v0 + u * v1 + v * v2
+    float v = 0.0f;
+};
+
+// Bounding volume hierarchy over the triangles of one mesh, for picking.
+// Built top-down with a binned surface area heuristic on the triangle centroids. Nodes are stored flat,
+// the two children of a node next to each other, and triangles are packed in leaf order so a leaf is
+// tested with one call to the SIMD ray kernels.
+class MeshBVH {
+public:
+    void build(const std::vector<float>& vertices, const std::vector<uint32_t>& indices);
+
+    // Closest hit nearer than maxDistance. The direction doesn't need to be normalized.
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, MeshRayHit& hit) const;
+
+    // True when some part of a triangle is inside the frustum, given in the mesh's own space.
+    // Triangles crossing a frustum edge are clipped, so only what's actually inside counts.
+    bool overlapsFrustum(const Frustum& frustum) const;
+
+    size_t getNodeCount() const { return nodes.size(); }
+    size_t getTriangleCount() const { return triangles.size(); }
+    int getDepth() const { return depth; }
+    double getBuildMs() const { return buildMs; }
+
+    // The mesh's tree, built on first use and shared by every copy of the MeshData
+    static const MeshBVH& of(const MeshData& mesh);
+
+    static const int MAX_LEAF_TRIANGLES = 4;
+
+private:
+    struct Node {
+        AABB box;
+        uint32_t first = 0;     // First child for inner nodes, first triangle for leaves
+        uint32_t count = 0;     // Triangles in a leaf, 0 for inner nodes
+    };
+
+    std::vector<Node> nodes;
+    PackedTriangles triangles;
+    std::vector<uint32_t> triangleIds;  // Original index of each triangle in leaf order
+    int depth = 0;
+    double buildMs = 0.0;
+};
+
+#endif // MESHBVH_H
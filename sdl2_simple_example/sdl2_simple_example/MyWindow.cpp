@@ -21,6 +21,18 @@
 #include "SceneWindow.h"
 #include "SceneManager.h"
 #include "SimulationManager.h"
+#include "Benchmark.h"
+#include "CullingSystem.h"
+#include "OcclusionCuller.h"
+#include "OcclusionQueries.h"
+#include "PickingBuffer.h"
+#include "GpuMesh.h"
+#include "RenderPipeline.h"
+#include "RenderQueue.h"
+#include "StaticBatcher.h"
+#include "IndirectRenderer.h"
+#include "DebugDraw.h"
+#include "RenderTargetPool.h"
 
 #include <IL/il.h>
 #include <IL/ilu.h>
@@ -104,9 +116,10 @@ MyWindow::MyWindow(const std::string& title, int w, int h) : _width(w), _height(
 // Destructor that frees memory and closes ImGui and SDL
 MyWindow::~MyWindow() {
     for (GameObject* obj : gameObjects) {
-        delete obj;
+        GameObjectPool::pool.destroy(obj);
     }
     gameObjects.clear();
+    GameObjectPool::pool.flush();
 
 
     SDL_GL_DeleteContext(_ctx);
@@ -258,24 +271,17 @@ void MyWindow::selectObject(GameObject* obj) {
     const Uint8* keyboardState = SDL_GetKeyboardState(nullptr);
 
     if (keyboardState[SDL_SCANCODE_LCTRL] || keyboardState[SDL_SCANCODE_RCTRL]) {
-        auto it = std::find(selectedObjects.begin(), selectedObjects.end(), obj);
-        if (it != selectedObjects.end()) {
-            selectedObjects.erase(it);
-        }
-        else {
-            selectedObjects.push_back(obj);
-        }
+        selectedObjects.toggle(obj);
     }
     else {
-        selectedObjects.clear();
-        selectedObjects.push_back(obj);
+        selectedObjects.set(obj);
     }
 
     console.addLog("Selected objects:");
     for (GameObject* newselectedObject : selectedObjects) {  
         console.addLog(("  - " + newselectedObject->getName()).c_str()); 
-        selectedObject = newselectedObject;  
     }
+    selectedObject = selectedObjects.empty() ? nullptr : selectedObjects.back();
 }
 
 void MyWindow::createMainMenu() {
@@ -299,6 +305,8 @@ void MyWindow::createMainMenu() {
             if (ImGui::MenuItem("Cone")) { GameObject::createPrimitive("Cone", gameObjects); }
             if (ImGui::MenuItem("Torus")) { GameObject::createPrimitive("Torus", gameObjects); }
             if (ImGui::MenuItem("Plane")) { GameObject::createPrimitive("Plane", gameObjects); }
+            ImGui::Separator();
+            if (ImGui::MenuItem("Stress Scene (10k Cubes)")) { GameObject::createStressScene("Cube", 10000, gameObjects); }
             
             ImGui::EndMenu();
         }
@@ -411,6 +419,115 @@ void MyWindow::createMainMenu() {
 
             ImGui::Separator();
 
+            if (ImGui::CollapsingHeader("Render Stats")) {
+                const CullStats& cullStats = CullingSystem::cullingSystem.getStats();
+                ImGui::Checkbox("Cull with AABB tree", &CullingSystem::cullingSystem.useTree);
+                ImGui::Text("Objects tested: %zu", cullStats.tested);
+                ImGui::Text("Visible: %zu", cullStats.visible);
+                ImGui::Text("Frustum culled: %zu", cullStats.culled);
+                ImGui::Text("Bounds update: %.3f ms", cullStats.gatherMs);
+                ImGui::Text("Frustum test: %.3f ms", cullStats.testMs);
+                ImGui::Text("Dynamic objects: %zu, tree height: %d, area ratio %.1f, reinserted %zu", cullStats.dynamicObjects, cullStats.treeHeight, cullStats.treeAreaRatio, cullStats.treeReinserts);
+                ImGui::Text("Static objects: %zu, octree depth %d, %zu nodes, built in %.2f ms", cullStats.staticObjects, cullStats.octreeDepth, cullStats.octreeNodes, cullStats.octreeBuildMs);
+                ImGui::Text("Visible cells: %zu, %.1f objects per cell", cullStats.visibleCells,
+                    cullStats.visibleCells > 0 ? static_cast<float>(cullStats.staticVisible) / cullStats.visibleCells : 0.0f);
+
+                OcclusionCuller& occlusion = OcclusionCuller::occlusionCuller;
+                const OcclusionStats& occlusionStats = occlusion.getStats();
+                ImGui::Checkbox("Software occlusion culling", &occlusion.enabled);
+                ImGui::Text("Occluders: %zu (%zu triangles)", occlusionStats.occluders, occlusionStats.occluderTriangles);
+                ImGui::Text("Occluded objects: %zu of %zu tested", occlusionStats.occluded, occlusionStats.tested);
+                ImGui::Text("Occluder raster: %.3f ms, occlusion test: %.3f ms", occlusionStats.rasterMs, occlusionStats.testMs);
+                ImGui::Checkbox("Show occlusion buffer", &occlusion.showDebugView);
+                if (occlusion.showDebugView && occlusion.getDebugTexture() != 0) {
+                    ImGui::Image((void*)(intptr_t)occlusion.getDebugTexture(), ImVec2(OcclusionCuller::WIDTH * 1.5f, OcclusionCuller::HEIGHT * 1.5f));
+                }
+
+                OcclusionQueries& queries = OcclusionQueries::occlusionQueries;
+                const QueryStats& queryStats = queries.getStats();
+                ImGui::Checkbox("Hardware occlusion queries", &queries.enabled);
+                const char* queryModes[] = { "Previous frame results", "Conditional render" };
+                int queryMode = static_cast<int>(queries.mode);
+                if (ImGui::Combo("Query mode", &queryMode, queryModes, IM_ARRAYSIZE(queryModes))) {
+                    queries.mode = static_cast<OcclusionQueries::Mode>(queryMode);
+                }
+                ImGui::Text("Queries: %zu issued (%zu box proxies), %zu results read", queryStats.issued, queryStats.proxies, queryStats.resultsRead);
+                ImGui::Text("Query latency: %.1f frames, %.2f ms", queryStats.latencyFrames, queryStats.latencyMs);
+                ImGui::Text("Hit rate: %.0f%% occluded, %zu skipped, %zu conditional draws",
+                    queryStats.resultsRead > 0 ? 100.0f * queryStats.resultsOccluded / queryStats.resultsRead : 0.0f, queryStats.skipped, queryStats.conditional);
+
+                PickingBuffer& picking = PickingBuffer::pickingBuffer;
+                const PickingStats& pickingStats = picking.getStats();
+                ImGui::Checkbox("ID buffer picking", &picking.enabled);
+                ImGui::SameLine();
+                ImGui::Checkbox("Highlight hovered object", &picking.hoverHighlight);
+                ImGui::Text("Pixel reads: %zu issued, %zu completed, latency %.0f frames", pickingStats.readsIssued, pickingStats.readsCompleted, pickingStats.latencyFrames);
+                ImGui::Checkbox("Exact box selection", &sceneWindow.exactBoxSelection);
+
+                const GpuMeshStats& meshStats = GpuMesh::getStats();
+                ImGui::Text("GPU meshes: %zu, %.2f MB resident", meshStats.meshes, meshStats.residentBytes / (1024.0f * 1024.0f));
+                ImGui::Text("Geometry uploaded this frame: %.1f KB (%zu meshes)", meshStats.uploadedBytes / 1024.0f, meshStats.uploads);
+
+                RenderQueue& queue = RenderQueue::renderQueue;
+                const RenderQueueStats& queueStats = queue.getStats();
+                ImGui::Checkbox("Sort render queue", &queue.enabled);
+                ImGui::Text("Draw packets: %zu, sorted in %.3f ms", queueStats.packets, queueStats.sortMs);
+                ImGui::Text("Binds: %zu texture, %zu mesh, %zu avoided", queueStats.textureBinds, queueStats.meshBinds, queueStats.bindsAvoided);
+
+                RenderPipeline& pipeline = RenderPipeline::renderPipeline;
+                const RenderPipelineStats& pipelineStats = pipeline.getStats();
+                ImGui::Checkbox("Shader pipeline", &pipeline.enabled);
+                ImGui::SameLine();
+                ImGui::Checkbox("Instancing", &pipeline.instancing);
+                ImGui::SameLine();
+                IndirectRenderer& indirect = IndirectRenderer::indirectRenderer;
+                ImGui::Checkbox("Multi-draw indirect", &indirect.enabled);
+                if (pipeline.isActive()) {
+                    ImGui::Text("Shader draws: %zu, %zu object records, %.1f KB uploaded", pipelineStats.drawCalls, pipelineStats.objects, pipelineStats.uploadedBytes / 1024.0f);
+                    ImGui::Text("Objects drawn: %zu, %zu instanced draws", pipelineStats.meshes, pipelineStats.instancedDraws);
+                }
+                else {
+                    ImGui::Text("Drawing with the fixed pipeline");
+                }
+
+                const IndirectStats& indirectStats = indirect.getStats();
+                ImGui::Text("Indirect: %zu commands in %zu multi-draws, %zu fence waits", indirectStats.commands, indirectStats.multiDraws, indirectStats.fenceWaits);
+                ImGui::Text("Arenas: %zu, %zu meshes, %.2f MB (%.2f MB dead)", indirectStats.arenas, indirectStats.meshes,
+                    indirectStats.residentBytes / (1024.0f * 1024.0f), indirectStats.deadBytes / (1024.0f * 1024.0f));
+                ImGui::Text("Submit CPU time: %.3f ms indirect, %.3f ms draw by draw", indirectStats.submitMs, indirectStats.classicSubmitMs);
+
+                StaticBatcher& batcher = StaticBatcher::staticBatcher;
+                const StaticBatchStats& batchStats = batcher.getStats();
+                ImGui::Checkbox("Static batching", &batcher.enabled);
+                ImGui::Text("Static batches: %zu, %zu objects, %.2f MB", batchStats.batches, batchStats.objects, batchStats.residentBytes / (1024.0f * 1024.0f));
+                ImGui::Text("Batches drawn: %zu, %zu objects in %zu ranges", batchStats.drawnBatches, batchStats.drawnObjects, batchStats.ranges);
+                ImGui::Text("Rebuilt: %zu batches, last build %.2f ms%s", batchStats.rebuilds, batchStats.lastBuildMs, batchStats.building ? ", building" : "");
+
+                DebugDraw& debugDraw = DebugDraw::debugDraw;
+                const DebugDrawStats& debugStats = debugDraw.getStats();
+                ImGui::Checkbox("Debug shapes", &debugDraw.enabled);
+                ImGui::SameLine();
+                ImGui::Checkbox("Show bounds", &debugDraw.showBounds);
+                ImGui::Text("Debug lines: %zu, %zu points in %zu draws, %.1f KB uploaded", debugStats.lines, debugStats.points, debugStats.drawCalls, debugStats.uploadedBytes / 1024.0f);
+                ImGui::Text("Debug ring buffer: %.2f MB, %zu reallocations", debugStats.ringBytes / (1024.0f * 1024.0f), debugStats.orphans);
+
+                const RenderTargetPool& targets = RenderTargetPool::renderTargetPool;
+                const RenderTargetStats& targetStats = targets.getStats();
+                const RenderTarget& sceneTarget = targets.getSceneTarget();
+                ImGui::Text("Scene target: %dx%d drawn in %dx%d, %zu frames scaled while resizing", sceneTarget.width, sceneTarget.height,
+                    targets.getViewportWidth(), targets.getViewportHeight(), targetStats.deferredFrames);
+                ImGui::Text("Render targets: %zu allocated, %zu pooled (%zu in use), %.2f MB", targetStats.allocations, targetStats.pooled, targetStats.inUse,
+                    targetStats.residentBytes / (1024.0f * 1024.0f));
+            }
+
+            ImGui::Separator();
+
+            if (ImGui::CollapsingHeader("Benchmarks")) {
+                Benchmark::benchmark.renderPanel();
+            }
+
+            ImGui::Separator();
+
             if (ImGui::Button("Close")) {
                 showConfig = false;
             }
@@ -538,6 +655,14 @@ void MyWindow::createMainMenu() {
     }
 }
 
+// Drops selected objects the pool has destroyed
+void MyWindow::pruneSelection() {
+    if (selectedObject && !GameObjectPool::pool.isAlive(selectedObject)) {
+        selectedObject = nullptr;
+    }
+    selectedObjects.removeIf([](GameObject* obj) { return !GameObjectPool::pool.isAlive(obj); });
+}
+
 // Updated interface and rendering of ImGui content
 void MyWindow::swapBuffers() {
     _currentTime = SDL_GetTicks();
@@ -5,6 +5,7 @@
 #include <vector>
 #include "GameObject.h"
 #include "ConsoleWindow.h"
+#include "Selection.h"
 
 struct SDL_Window;
 
@@ -18,7 +19,7 @@ public:
 
 	SDL_Window* _window = nullptr;
 	std::vector<GameObject*> gameObjects;
-	std::vector<GameObject*> selectedObjects;
+	Selection selectedObjects;
 	GameObject* selectedObject;
 
 public:
@@ -35,6 +36,8 @@ public:
 	std::vector<GameObject*> getGameObjects() { return gameObjects; }
 
 	void selectObject(GameObject* obj);
+	// Drops selected objects whose memory was released by the pool this frame
+	void pruneSelection();
 
 	void configMyWindow();
 
@@ -0,0 +1,107 @@
+#include "ObjectID.h"
+#include <chrono>
+#include <random>
+#include <thread>
+
+namespace {
+    uint64_t splitMix64(uint64_t& state) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    uint64_t rotateLeft(uint64_t value, int bits) {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    // xoshiro256** generator, seeded once per thread
+    struct IDGenerator {
+        uint64_t state[4];
+
+        IDGenerator() {
+            std::random_device device;
+            uint64_t seed = (static_cast<uint64_t>(device()) << 32) ^ device();
+            seed ^= static_cast<uint64_t>(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+            seed ^= static_cast<uint64_t>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+            for (uint64_t& word : state) {
+                word = splitMix64(seed);
+            }
+        }
+
+        uint64_t next() {
+            const uint64_t result = rotateLeft(state[1] * 5, 7) * 9;
+            const uint64_t t = state[1] << 17;
+
+            state[2] ^= state[0];
+            state[3] ^= state[1];
+            state[1] ^= state[2];
+            state[0] ^= state[3];
+            state[2] ^= t;
+            state[3] = rotateLeft(state[3], 45);
+
+            return result;
+        }
+    };
+
+    int hexValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+}
+
+ObjectID ObjectID::generate() {
+    thread_local IDGenerator generator;
+
+    ObjectID id;
+    id.high = generator.next();
+    id.low = generator.next();
+
+    // Version 4 and RFC 4122 variant bits, so the text form stays a valid UUID
+    id.high = (id.high & 0xFFFFFFFFFFFF0FFFull) | 0x0000000000004000ull;
+    id.low = (id.low & 0x3FFFFFFFFFFFFFFFull) | 0x8000000000000000ull;
+    return id;
+}
+
+bool ObjectID::fromString(const std::string& text, ObjectID& outID) {
+    uint64_t words[2] = { 0, 0 };
+    int digits = 0;
+
+    for (char c : text) {
+        if (c == '-') continue;
+
+        int value = hexValue(c);
+        if (value < 0 || digits >= 32) {
+            return false;
+        }
+        words[digits / 16] = (words[digits / 16] << 4) | static_cast<uint64_t>(value);
+        digits++;
+    }
+
+    if (digits != 32) {
+        return false;
+    }
+    outID.high = words[0];
+    outID.low = words[1];
+    return true;
+}
+
+std::string ObjectID::toString() const {
+    static const char hexDigits[] = "0123456789abcdef";
+
+    std::string text(36, '-');
+    int position = 0;
+    for (int digit = 0; digit < 32; ++digit) {
+        if (position == 8 || position == 13 || position == 18 || position == 23) {
+            position++;
+        }
+
+        const uint64_t word = digit < 16 ? high : low;
+        const int shift = 60 - (digit % 16) * 4;
+        text[position++] = hexDigits[(word >> shift) & 0xF];
+    }
+    return text;
+}
@@ -0,0 +1,38 @@
+#ifndef OBJECTID_H
+#define OBJECTID_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <functional>
+
+// 128-bit random identifier laid out like a version 4 UUID.
+// It's compared and hashed as two integers, the text form is only built for scene files and the UI.
+struct ObjectID {
+    uint64_t high = 0;
+    uint64_t low = 0;
+
+    static ObjectID generate();
+
+    // Accepts the canonical 8-4-4-4-12 form (dashes are optional), returns false on malformed input
+    static bool fromString(const std::string& text, ObjectID& outID);
+    std::string toString() const;
+
+    bool isNull() const { return high == 0 && low == 0; }
+
+    bool operator==(const ObjectID& other) const { return high == other.high && low == other.low; }
+    bool operator!=(const ObjectID& other) const { return !(*this == other); }
+    bool operator<(const ObjectID& other) const { return high < other.high || (high == other.high && low < other.low); }
+};
+
+namespace std {
+    template <>
+    struct hash<ObjectID> {
+        size_t operator()(const ObjectID& id) const {
+            // The bits are already random, folding both halves is enough
+            return static_cast<size_t>(id.high ^ (id.low * 0x9E3779B97F4A7C15ull));
+        }
+    };
+}
+
+#endif // OBJECTID_H
@@ -0,0 +1,385 @@
+#include "OcclusionCuller.h"
+#include "Components.h"
+#include "TransformStore.h"
+#include "JobSystem.h"
+#include "GameObject.h"
+#include "Bounds.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define OCCLUSION_SSE 1
+#include <immintrin.h>
+#endif
+
+OcclusionCuller OcclusionCuller::occlusionCuller;
+
+namespace {
+    using occlusionClock = std::chrono::high_resolution_clock;
+
+    // Clip space to buffer pixels, row 0 is NDC y = -1
+    glm::vec2 toScreen(const glm::vec4& clip) {
+        const float invW = 1.0f / clip.w;
+        return glm::vec2((clip.x * invW * 0.5f + 0.5f) * OcclusionCuller::WIDTH, (clip.y * invW * 0.5f + 0.5f) * OcclusionCuller::HEIGHT);
+    }
+
+    bool behindNearPlane(const glm::vec4& clip) {
+        return clip.z < -clip.w;
+    }
+}
+
+OcclusionCuller::OcclusionCuller()
+    : depth(WIDTH * HEIGHT, 0.0f)
+    , tileMinDepth(TILES_X * TILES_Y, 0.0f)
+    , tileBins(TILES_X * TILES_Y) {
+}
+
+const std::vector<Entity>& OcclusionCuller::cull(const glm::mat4& viewProjection, const std::vector<Entity>& candidates) {
+    stats = OcclusionStats();
+    if (!enabled) {
+        return candidates;
+    }
+
+    const auto start = occlusionClock::now();
+    const size_t count = candidates.size();
+    candidateInfo.assign(count, Candidate());
+
+    // Screen rectangle of every candidate, from the eight corners of its world box
+    const std::vector<glm::mat4>& worldMatrices = TransformStore::transformStore.worldMatrices;
+    JobSystem::jobSystem.parallelFor(count, 256, [&](size_t begin, size_t end) {
+        World& world = World::world;
+        for (size_t i = begin; i < end; ++i) {
+            const BoundsComponent& bounds = world.get<BoundsComponent>(candidates[i]);
+            const glm::mat4& model = worldMatrices[world.get<TransformComponent>(candidates[i]).transformIndex];
+            const AABB box = AABB(bounds.localMin, bounds.localMax).transformed(model);
+
+            Candidate& info = candidateInfo[i];
+            glm::vec2 screenMin(static_cast<float>(WIDTH), static_cast<float>(HEIGHT));
+            glm::vec2 screenMax(0.0f);
+            for (int corner = 0; corner < 8; ++corner) {
+                const glm::vec3 point((corner & 1) ? box.max.x : box.min.x, (corner & 2) ? box.max.y : box.min.y, (corner & 4) ? box.max.z : box.min.z);
+                const glm::vec4 clip = viewProjection * glm::vec4(point, 1.0f);
+                if (behindNearPlane(clip)) {
+                    info.clipsNear = true;
+                    break;
+                }
+                const glm::vec2 screen = toScreen(clip);
+                screenMin = glm::min(screenMin, screen);
+                screenMax = glm::max(screenMax, screen);
+                info.nearestDepth = std::max(info.nearestDepth, 1.0f / clip.w);
+            }
+            if (info.clipsNear) continue;
+
+            screenMin = glm::max(screenMin, glm::vec2(0.0f));
+            screenMax = glm::min(screenMax, glm::vec2(static_cast<float>(WIDTH), static_cast<float>(HEIGHT)));
+            info.minX = static_cast<int>(screenMin.x);
+            info.minY = static_cast<int>(screenMin.y);
+            info.maxX = std::min(static_cast<int>(screenMax.x), WIDTH - 1);
+            info.maxY = std::min(static_cast<int>(screenMax.y), HEIGHT - 1);
+            info.screenArea = std::max(0.0f, screenMax.x - screenMin.x) * std::max(0.0f, screenMax.y - screenMin.y) / (WIDTH * HEIGHT);
+        }
+    });
+
+    selectOccluders(candidates);
+
+    if (occluderIndices.empty()) {
+        std::fill(depth.begin(), depth.end(), 0.0f);
+        std::fill(tileMinDepth.begin(), tileMinDepth.end(), 0.0f);
+        stats.rasterMs = std::chrono::duration<double, std::milli>(occlusionClock::now() - start).count();
+        if (showDebugView) {
+            updateDebugTexture();
+        }
+        return candidates;
+    }
+
+    // Triangle setup per occluder, then binning into the tiles each triangle touches
+    occluderTriangles.resize(occluderIndices.size());
+    JobSystem::jobSystem.parallelFor(occluderIndices.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            setupOccluder(i, candidates[occluderIndices[i]], viewProjection);
+        }
+    });
+
+    triangles.clear();
+    for (std::vector<uint32_t>& bin : tileBins) {
+        bin.clear();
+    }
+    for (size_t i = 0; i < occluderIndices.size(); ++i) {
+        for (const Triangle& triangle : occluderTriangles[i]) {
+            const uint32_t index = static_cast<uint32_t>(triangles.size());
+            triangles.push_back(triangle);
+
+            for (int tileY = triangle.minY / TILE_HEIGHT; tileY <= triangle.maxY / TILE_HEIGHT; ++tileY) {
+                for (int tileX = triangle.minX / TILE_WIDTH; tileX <= triangle.maxX / TILE_WIDTH; ++tileX) {
+                    tileBins[tileY * TILES_X + tileX].push_back(index);
+                }
+            }
+        }
+    }
+    stats.occluders = occluderIndices.size();
+    stats.occluderTriangles = triangles.size();
+
+    // Tiles don't share pixels, so each job owns its part of the buffer
+    JobSystem::jobSystem.parallelFor(tileBins.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t tile = begin; tile < end; ++tile) {
+            rasterizeTile(static_cast<int>(tile));
+        }
+    });
+
+    const auto testStart = occlusionClock::now();
+    stats.rasterMs = std::chrono::duration<double, std::milli>(testStart - start).count();
+
+    hidden.assign(count, 0);
+    JobSystem::jobSystem.parallelFor(count, 256, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const Candidate& info = candidateInfo[i];
+            if (!info.occluder && !info.clipsNear) {
+                hidden[i] = isHidden(info);
+            }
+        }
+    });
+
+    visible.clear();
+    visible.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const Candidate& info = candidateInfo[i];
+        stats.tested += !info.occluder && !info.clipsNear;
+        if (hidden[i]) {
+            stats.occluded++;
+        }
+        else {
+            visible.push_back(candidates[i]);
+        }
+    }
+    stats.testMs = std::chrono::duration<double, std::milli>(occlusionClock::now() - testStart).count();
+
+    if (showDebugView) {
+        updateDebugTexture();
+    }
+    return visible;
+}
+
+// Flagged occluders first, then the meshes covering the most screen
+void OcclusionCuller::selectOccluders(const std::vector<Entity>& candidates) {
+    World& world = World::world;
+    std::vector<std::pair<float, uint32_t>> ranked;
+
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        const Candidate& info = candidateInfo[i];
+        if (info.maxX < info.minX && !info.clipsNear) continue;
+
+        const MeshData* mesh = world.get<MeshRendererComponent>(candidates[i]).mesh;
+        if (!mesh || mesh->indices.empty()) continue;
+
+        if (world.has<OccluderTag>(candidates[i])) {
+            // Ranked above any automatic occluder, whose area is at most 1
+            ranked.push_back({ 2.0f + info.screenArea, static_cast<uint32_t>(i) });
+        }
+        else if (info.screenArea >= minOccluderArea && mesh->indices.size() / 3 <= maxOccluderTriangles) {
+            ranked.push_back({ info.screenArea, static_cast<uint32_t>(i) });
+        }
+    }
+
+    const size_t kept = std::min(ranked.size(), maxOccluders);
+    std::partial_sort(ranked.begin(), ranked.begin() + kept, ranked.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    occluderIndices.clear();
+    for (size_t i = 0; i < kept; ++i) {
+        occluderIndices.push_back(ranked[i].second);
+        candidateInfo[ranked[i].second].occluder = true;
+    }
+}
+
+void OcclusionCuller::setupOccluder(size_t occluder, Entity entity, const glm::mat4& viewProjection) {
+    World& world = World::world;
+    const MeshData& mesh = *world.get<MeshRendererComponent>(entity).mesh;
+    const glm::mat4 modelViewProjection = viewProjection * TransformStore::transformStore.worldMatrices[world.get<TransformComponent>(entity).transformIndex];
+
+    std::vector<glm::vec4> clip(mesh.vertices.size() / 3);
+    for (size_t i = 0; i < clip.size(); ++i) {
+        clip[i] = modelViewProjection * glm::vec4(mesh.vertices[i * 3], mesh.vertices[i * 3 + 1], mesh.vertices[i * 3 + 2], 1.0f);
+    }
+
+    std::vector<Triangle>& out = occluderTriangles[occluder];
+    out.clear();
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+        uint32_t indices[3] = { mesh.indices[i], mesh.indices[i + 1], mesh.indices[i + 2] };
+        if (indices[0] >= clip.size() || indices[1] >= clip.size() || indices[2] >= clip.size()) continue;
+
+        // Triangles crossing the near plane are left out, occluding less is always safe
+        if (behindNearPlane(clip[indices[0]]) || behindNearPlane(clip[indices[1]]) || behindNearPlane(clip[indices[2]])) continue;
+
+        glm::vec2 screen[3];
+        float z[3];
+        for (int v = 0; v < 3; ++v) {
+            screen[v] = toScreen(clip[indices[v]]);
+            z[v] = 1.0f / clip[indices[v]].w;
+        }
+
+        // Both windings are rasterized, counter-clockwise from here on
+        float area = (screen[1].x - screen[0].x) * (screen[2].y - screen[0].y) - (screen[2].x - screen[0].x) * (screen[1].y - screen[0].y);
+        if (std::fabs(area) < 1e-6f) continue;
+        if (area < 0.0f) {
+            std::swap(screen[1], screen[2]);
+            std::swap(z[1], z[2]);
+            area = -area;
+        }
+
+        Triangle triangle;
+        const glm::vec2 screenMin = glm::min(glm::min(screen[0], screen[1]), screen[2]);
+        const glm::vec2 screenMax = glm::max(glm::max(screen[0], screen[1]), screen[2]);
+        if (screenMax.x < 0.0f || screenMax.y < 0.0f || screenMin.x >= WIDTH || screenMin.y >= HEIGHT) continue;
+        triangle.minX = std::max(0, static_cast<int>(std::floor(screenMin.x)));
+        triangle.minY = std::max(0, static_cast<int>(std::floor(screenMin.y)));
+        triangle.maxX = std::min(WIDTH - 1, static_cast<int>(std::floor(screenMax.x)));
+        triangle.maxY = std::min(HEIGHT - 1, static_cast<int>(std::floor(screenMax.y)));
+
+        // Edge i is opposite vertex i, positive inside. Divided by the area they are the barycentrics,
+        // which interpolate 1/w linearly across the screen.
+        triangle.depthA = triangle.depthB = triangle.depthC = 0.0f;
+        for (int edge = 0; edge < 3; ++edge) {
+            const glm::vec2& a = screen[(edge + 1) % 3];
+            const glm::vec2& b = screen[(edge + 2) % 3];
+            triangle.edgeA[edge] = a.y - b.y;
+            triangle.edgeB[edge] = b.x - a.x;
+            triangle.edgeC[edge] = a.x * b.y - a.y * b.x;
+
+            triangle.depthA += triangle.edgeA[edge] * z[edge] / area;
+            triangle.depthB += triangle.edgeB[edge] * z[edge] / area;
+            triangle.depthC += triangle.edgeC[edge] * z[edge] / area;
+        }
+        out.push_back(triangle);
+    }
+}
+
+void OcclusionCuller::rasterizeTile(int tile) {
+    const int tileX = (tile % TILES_X) * TILE_WIDTH;
+    const int tileY = (tile / TILES_X) * TILE_HEIGHT;
+
+    for (int y = tileY; y < tileY + TILE_HEIGHT; ++y) {
+        std::fill_n(&depth[y * WIDTH + tileX], TILE_WIDTH, 0.0f);
+    }
+
+    for (uint32_t index : tileBins[tile]) {
+        const Triangle& t = triangles[index];
+        // Spans start on a multiple of 4 and stay inside the tile, the edge tests mask the extra pixels
+        const int startX = std::max(t.minX, tileX) & ~3;
+        const int endX = std::min(t.maxX, tileX + TILE_WIDTH - 1);
+        const int startY = std::max(t.minY, tileY);
+        const int endY = std::min(t.maxY, tileY + TILE_HEIGHT - 1);
+
+        for (int y = startY; y <= endY; ++y) {
+            const float py = y + 0.5f;
+            float* row = &depth[y * WIDTH];
+
+#ifdef OCCLUSION_SSE
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 rowEdge0 = _mm_set1_ps(t.edgeB[0] * py + t.edgeC[0]);
+            const __m128 rowEdge1 = _mm_set1_ps(t.edgeB[1] * py + t.edgeC[1]);
+            const __m128 rowEdge2 = _mm_set1_ps(t.edgeB[2] * py + t.edgeC[2]);
+            const __m128 rowDepth = _mm_set1_ps(t.depthB * py + t.depthC);
+            const __m128 a0 = _mm_set1_ps(t.edgeA[0]);
+            const __m128 a1 = _mm_set1_ps(t.edgeA[1]);
+            const __m128 a2 = _mm_set1_ps(t.edgeA[2]);
+            const __m128 depthA = _mm_set1_ps(t.depthA);
+
+            for (int x = startX; x <= endX; x += 4) {
+                const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f));
+                const __m128 e0 = _mm_add_ps(_mm_mul_ps(a0, px), rowEdge0);
+                const __m128 e1 = _mm_add_ps(_mm_mul_ps(a1, px), rowEdge1);
+                const __m128 e2 = _mm_add_ps(_mm_mul_ps(a2, px), rowEdge2);
+                const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+                if (_mm_movemask_ps(inside) == 0) continue;
+
+                const __m128 z = _mm_add_ps(_mm_mul_ps(depthA, px), rowDepth);
+                const __m128 old = _mm_loadu_ps(row + x);
+                const __m128 nearest = _mm_max_ps(old, z);
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, old)));
+            }
+#else
+            for (int x = startX; x <= endX; ++x) {
+                const float px = x + 0.5f;
+                const float e0 = t.edgeA[0] * px + t.edgeB[0] * py + t.edgeC[0];
+                const float e1 = t.edgeA[1] * px + t.edgeB[1] * py + t.edgeC[1];
+                const float e2 = t.edgeA[2] * px + t.edgeB[2] * py + t.edgeC[2];
+                if (e0 >= 0.0f && e1 >= 0.0f && e2 >= 0.0f) {
+                    row[x] = std::max(row[x], t.depthA * px + t.depthB * py + t.depthC);
+                }
+            }
+#endif
+        }
+    }
+
+    // Farthest occluder depth in the tile, anything farther than it is hidden on the whole tile
+    float tileMin = depth[tileY * WIDTH + tileX];
+    for (int y = tileY; y < tileY + TILE_HEIGHT; ++y) {
+        const float* row = &depth[y * WIDTH + tileX];
+        tileMin = std::min(tileMin, *std::min_element(row, row + TILE_WIDTH));
+    }
+    tileMinDepth[tile] = tileMin;
+}
+
+// Visible as soon as one covered pixel has no occluder in front of the candidate's nearest point
+bool OcclusionCuller::isHidden(const Candidate& candidate) const {
+    if (candidate.maxX < candidate.minX || candidate.maxY < candidate.minY) {
+        return false;
+    }
+
+    for (int tileY = candidate.minY / TILE_HEIGHT; tileY <= candidate.maxY / TILE_HEIGHT; ++tileY) {
+        for (int tileX = candidate.minX / TILE_WIDTH; tileX <= candidate.maxX / TILE_WIDTH; ++tileX) {
+            if (candidate.nearestDepth < tileMinDepth[tileY * TILES_X + tileX]) continue;
+
+            const int startX = std::max(candidate.minX, tileX * TILE_WIDTH);
+            const int endX = std::min(candidate.maxX, tileX * TILE_WIDTH + TILE_WIDTH - 1);
+            const int startY = std::max(candidate.minY, tileY * TILE_HEIGHT);
+            const int endY = std::min(candidate.maxY, tileY * TILE_HEIGHT + TILE_HEIGHT - 1);
+
+            for (int y = startY; y <= endY; ++y) {
+                const float* row = &depth[y * WIDTH];
+                int x = startX;
+#ifdef OCCLUSION_SSE
+                const __m128 nearest = _mm_set1_ps(candidate.nearestDepth);
+                for (; x + 3 <= endX; x += 4) {
+                    if (_mm_movemask_ps(_mm_cmple_ps(_mm_loadu_ps(row + x), nearest)) != 0) {
+                        return false;
+                    }
+                }
+#endif
+                for (; x <= endX; ++x) {
+                    if (row[x] <= candidate.nearestDepth) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Nearer is brighter, scaled to the nearest occluder of the frame
+void OcclusionCuller::updateDebugTexture() {
+    const float nearest = *std::max_element(depth.begin(), depth.end());
+    const float scale = nearest > 0.0f ? 255.0f / nearest : 0.0f;
+
+    debugPixels.resize(depth.size() * 3);
+    for (size_t i = 0; i < depth.size(); ++i) {
+        const uint8_t value = static_cast<uint8_t>(std::min(255.0f, depth[i] * scale));
+        debugPixels[i * 3] = value;
+        debugPixels[i * 3 + 1] = value;
+        debugPixels[i * 3 + 2] = value;
+    }
+
+    if (debugTexture == 0) {
+        glGenTextures(1, &debugTexture);
+        glBindTexture(GL_TEXTURE_2D, debugTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, WIDTH, HEIGHT, 0, GL_RGB, GL_UNSIGNED_BYTE, debugPixels.data());
+    }
+    else {
+        glBindTexture(GL_TEXTURE_2D, debugTexture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, WIDTH, HEIGHT, GL_RGB, GL_UNSIGNED_BYTE, debugPixels.data());
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
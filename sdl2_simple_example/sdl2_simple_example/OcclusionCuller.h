@@ -0,0 +1,92 @@
+#ifndef OCCLUSIONCULLER_H
+#define OCCLUSIONCULLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "ECS.h"
+
+struct OcclusionStats {
+    size_t occluders = 0;
+    size_t occluderTriangles = 0;
+    size_t tested = 0;
+    size_t occluded = 0;
+    double rasterMs = 0.0;   // Occluder selection, setup and rasterization
+    double testMs = 0.0;     // Bounds tests against the buffer
+};
+
+// Software occlusion culling on a small depth buffer.
+// The largest visible meshes on screen, and the ones flagged with OccluderTag, are rasterized on the
+// job system, one job per tile of the buffer, 4 pixels at a time with SSE. Every other candidate's
+// screen rectangle is then tested against the buffer at its nearest depth: a candidate behind the
+// occluders on every pixel it covers is dropped. The buffer stores 1/w, so bigger means nearer.
+class OcclusionCuller {
+public:
+    static OcclusionCuller occlusionCuller;
+
+    static const int WIDTH = 256;
+    static const int HEIGHT = 128;
+    static const int TILE_WIDTH = 32;
+    static const int TILE_HEIGHT = 16;
+    static const int TILES_X = WIDTH / TILE_WIDTH;
+    static const int TILES_Y = HEIGHT / TILE_HEIGHT;
+
+    OcclusionCuller();
+
+    // Returns the candidates that may be visible, in their original order. Candidates need a mesh,
+    // bounds and a transform, such as the visible list of the CullingSystem.
+    const std::vector<Entity>& cull(const glm::mat4& viewProjection, const std::vector<Entity>& candidates);
+
+    const OcclusionStats& getStats() const { return stats; }
+    const std::vector<float>& getDepthBuffer() const { return depth; }
+
+    // Grayscale copy of the buffer, only refreshed while showDebugView is set
+    GLuint getDebugTexture() const { return debugTexture; }
+
+    bool enabled = true;
+    bool showDebugView = false;
+    float minOccluderArea = 0.02f;          // Fraction of the screen an automatic occluder must cover
+    size_t maxOccluders = 24;
+    size_t maxOccluderTriangles = 4096;     // Heavier meshes are only used when flagged
+
+private:
+    // Edge functions and depth plane of a screen-space triangle, E(x, y) = a * x + b * y + c
+    struct Triangle {
+        float edgeA[3], edgeB[3], edgeC[3];
+        float depthA, depthB, depthC;
+        int minX, minY, maxX, maxY;
+    };
+
+    // Screen rectangle and nearest depth of a candidate's world box
+    struct Candidate {
+        int minX = 0, minY = 0, maxX = -1, maxY = -1;
+        float nearestDepth = 0.0f;
+        float screenArea = 0.0f;
+        bool clipsNear = false;     // Crosses the near plane, always visible
+        bool occluder = false;
+    };
+
+    std::vector<float> depth;
+    std::vector<float> tileMinDepth;
+    std::vector<Candidate> candidateInfo;
+    std::vector<uint32_t> occluderIndices;
+    std::vector<std::vector<Triangle>> occluderTriangles;
+    std::vector<std::vector<uint32_t>> tileBins;   // Indices into the flattened triangle list
+    std::vector<Triangle> triangles;
+    std::vector<uint8_t> hidden;
+    std::vector<Entity> visible;
+    OcclusionStats stats;
+
+    GLuint debugTexture = 0;
+    std::vector<uint8_t> debugPixels;
+
+    void selectOccluders(const std::vector<Entity>& candidates);
+    void setupOccluder(size_t occluder, Entity entity, const glm::mat4& viewProjection);
+    void rasterizeTile(int tile);
+    bool isHidden(const Candidate& candidate) const;
+    void updateDebugTexture();
+};
+
+#endif // OCCLUSIONCULLER_H
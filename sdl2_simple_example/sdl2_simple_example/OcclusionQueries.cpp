@@ -0,0 +1,206 @@
+#include "OcclusionQueries.h"
+#include "Components.h"
+#include "TransformStore.h"
+#include "Bounds.h"
+
+OcclusionQueries OcclusionQueries::occlusionQueries;
+
+namespace {
+    // Objects out of the draw list for this long give their query object back
+    const uint32_t FORGET_AFTER_FRAMES = 120;
+
+    // A camera this close to a hidden object's box could have the proxy clipped by the near plane
+    const float CAMERA_MARGIN = 0.5f;
+
+    AABB worldBoxOf(Entity entity) {
+        World& world = World::world;
+        const BoundsComponent& bounds = world.get<BoundsComponent>(entity);
+        const glm::mat4& model = TransformStore::transformStore.worldMatrices[world.get<TransformComponent>(entity).transformIndex];
+        return AABB(bounds.localMin, bounds.localMax).transformed(model);
+    }
+
+    void drawBox(const AABB& box) {
+        const glm::vec3& a = box.min;
+        const glm::vec3& b = box.max;
+        glBegin(GL_QUADS);
+        glVertex3f(a.x, a.y, a.z); glVertex3f(b.x, a.y, a.z); glVertex3f(b.x, b.y, a.z); glVertex3f(a.x, b.y, a.z);
+        glVertex3f(a.x, a.y, b.z); glVertex3f(a.x, b.y, b.z); glVertex3f(b.x, b.y, b.z); glVertex3f(b.x, a.y, b.z);
+        glVertex3f(a.x, a.y, a.z); glVertex3f(a.x, b.y, a.z); glVertex3f(a.x, b.y, b.z); glVertex3f(a.x, a.y, b.z);
+        glVertex3f(b.x, a.y, a.z); glVertex3f(b.x, a.y, b.z); glVertex3f(b.x, b.y, b.z); glVertex3f(b.x, b.y, a.z);
+        glVertex3f(a.x, a.y, a.z); glVertex3f(a.x, a.y, b.z); glVertex3f(b.x, a.y, b.z); glVertex3f(b.x, a.y, a.z);
+        glVertex3f(a.x, b.y, a.z); glVertex3f(b.x, b.y, a.z); glVertex3f(b.x, b.y, b.z); glVertex3f(a.x, b.y, b.z);
+        glEnd();
+    }
+}
+
+OcclusionQueries::ObjectQuery& OcclusionQueries::stateOf(Entity entity) {
+    if (entity.index >= objects.size()) {
+        objects.resize(entity.index + 1);
+    }
+
+    ObjectQuery& object = objects[entity.index];
+    if (object.owner != entity) {
+        // A new entity on this index keeps the query object but none of the old results
+        object.owner = entity;
+        object.pending = false;
+        object.visible = true;
+    }
+    return object;
+}
+
+void OcclusionQueries::startQuery(ObjectQuery& object) {
+    if (object.query == 0) {
+        glGenQueries(1, &object.query);
+        trackedEntities.push_back(object.owner.index);
+    }
+
+    glBeginQuery(queryTarget, object.query);
+    object.pending = true;
+    object.issueFrame = frame;
+    object.issueTime = queryClock::now();
+    stats.issued++;
+}
+
+void OcclusionQueries::beginFrame() {
+    // Counted even while disabled, so results older than the last frame are never trusted
+    frame++;
+    stats = QueryStats();
+    hiddenThisFrame.clear();
+    if (!enabled) return;
+
+    if (queryTarget == 0) {
+        // Any-samples queries can stop counting at the first sample, plain sample counts work everywhere
+        queryTarget = (GLEW_VERSION_3_3 || GLEW_ARB_occlusion_query2) ? GL_ANY_SAMPLES_PASSED : GL_SAMPLES_PASSED;
+    }
+
+    const queryClock::time_point now = queryClock::now();
+    uint32_t latencyFrames = 0;
+    double latencyMs = 0.0;
+
+    for (size_t i = 0; i < trackedEntities.size();) {
+        ObjectQuery& object = objects[trackedEntities[i]];
+
+        if (object.pending) {
+            GLuint available = 0;
+            glGetQueryObjectuiv(object.query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available) {
+                GLuint samples = 0;
+                glGetQueryObjectuiv(object.query, GL_QUERY_RESULT, &samples);
+                object.visible = samples > 0;
+                object.pending = false;
+
+                stats.resultsRead++;
+                stats.resultsOccluded += !object.visible;
+                latencyFrames += frame - object.issueFrame;
+                latencyMs += std::chrono::duration<double, std::milli>(now - object.issueTime).count();
+            }
+        }
+
+        if (!object.pending && frame - object.lastSeenFrame > FORGET_AFTER_FRAMES) {
+            glDeleteQueries(1, &object.query);
+            object = ObjectQuery();
+            trackedEntities[i] = trackedEntities.back();
+            trackedEntities.pop_back();
+            continue;
+        }
+        ++i;
+    }
+
+    if (stats.resultsRead > 0) {
+        stats.latencyFrames = static_cast<float>(latencyFrames) / stats.resultsRead;
+        stats.latencyMs = latencyMs / stats.resultsRead;
+    }
+}
+
+bool OcclusionQueries::beginObject(Entity entity) {
+    if (!enabled) return true;
+
+    ObjectQuery& object = stateOf(entity);
+    // Not in the draw list last frame, so its result says nothing about the current view
+    if (object.lastSeenFrame + 1 < frame) {
+        object.visible = true;
+    }
+    object.lastSeenFrame = frame;
+
+    if (!object.visible) {
+        hiddenThisFrame.push_back(entity);
+        stats.skipped++;
+        return false;
+    }
+
+    if (!object.pending) {
+        startQuery(object);
+        queryActive = true;
+    }
+    return true;
+}
+
+void OcclusionQueries::endObject(Entity) {
+    if (queryActive) {
+        glEndQuery(queryTarget);
+        queryActive = false;
+    }
+}
+
+void OcclusionQueries::testHiddenObjects(const glm::vec3& cameraPosition, const std::function<void(Entity)>& draw,
+    const std::function<void(const AABB&)>& drawProxy) {
+    if (!enabled || hiddenThisFrame.empty()) return;
+
+    std::vector<Entity> conditional;
+    std::vector<Entity> drawNow;
+
+    // Proxies only test against the depth buffer, nothing they draw may stay on screen
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+    glDisable(GL_TEXTURE_2D);
+
+    for (Entity entity : hiddenThisFrame) {
+        ObjectQuery& object = objects[entity.index];
+        const AABB box = worldBoxOf(entity);
+
+        if (AABB(box.min - glm::vec3(CAMERA_MARGIN), box.max + glm::vec3(CAMERA_MARGIN)).contains(AABB(cameraPosition, cameraPosition))) {
+            object.visible = true;
+            drawNow.push_back(entity);
+            continue;
+        }
+        // The proxy of an earlier frame is still in flight
+        if (object.pending) continue;
+
+        startQuery(object);
+        if (drawProxy) {
+            drawProxy(box);
+        }
+        else {
+            drawBox(box);
+        }
+        glEndQuery(queryTarget);
+        stats.proxies++;
+
+        if (mode == Mode::ConditionalRender) {
+            conditional.push_back(entity);
+        }
+    }
+
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDepthMask(GL_TRUE);
+
+    // The GPU waits for the proxy result, the CPU does not
+    for (Entity entity : conditional) {
+        glBeginConditionalRender(objects[entity.index].query, GL_QUERY_WAIT);
+        draw(entity);
+        glEndConditionalRender();
+        stats.conditional++;
+    }
+    for (Entity entity : drawNow) {
+        draw(entity);
+    }
+}
+
+void OcclusionQueries::releaseQueries() {
+    for (uint32_t index : trackedEntities) {
+        glDeleteQueries(1, &objects[index].query);
+    }
+    objects.clear();
+    trackedEntities.clear();
+    hiddenThisFrame.clear();
+}
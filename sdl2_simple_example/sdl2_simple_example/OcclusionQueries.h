@@ -0,0 +1,84 @@
+#ifndef OCCLUSIONQUERIES_H
+#define OCCLUSIONQUERIES_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "ECS.h"
+#include "Bounds.h"
+
+struct QueryStats {
+    size_t issued = 0;          // Queries started this frame
+    size_t proxies = 0;         // Of which bounding box proxies
+    size_t resultsRead = 0;     // Results that became available this frame
+    size_t resultsOccluded = 0; // Of which reported no visible samples
+    size_t skipped = 0;         // Objects not drawn because they were hidden last time they were tested
+    size_t conditional = 0;     // Hidden objects drawn under conditional render
+    float latencyFrames = 0.0f; // Average age of the results read this frame
+    double latencyMs = 0.0;
+};
+
+// Hardware occlusion queries with temporal coherence, on top of the frustum culled draw list.
+// The CPU never waits for a result: each frame only reads the queries that are already done.
+// Objects visible at their last test are drawn and re-queried with their own geometry. Hidden ones are
+// skipped and only their world box is drawn inside a query, without writing color or depth, after
+// everything else so the depth buffer is complete. With ConditionalRender they are also drawn under
+// glBeginConditionalRender on that query, the GPU then decides without a frame of popping.
+class OcclusionQueries {
+public:
+    enum class Mode { PreviousFrame, ConditionalRender };
+
+    static OcclusionQueries occlusionQueries;
+
+    // Collects the finished queries, call once per frame before drawing
+    void beginFrame();
+
+    // Returns false when the object was hidden last time and must not be drawn now,
+    // otherwise starts a query around the draw when the object has none in flight
+    bool beginObject(Entity entity);
+    void endObject(Entity entity);
+
+    // Box proxies for the objects skipped this frame, and their conditional draws. Objects whose box
+    // holds the camera are drawn right away, their proxy could be clipped by the near plane.
+    // Proxies go through 'drawProxy' when given, in immediate mode otherwise.
+    void testHiddenObjects(const glm::vec3& cameraPosition, const std::function<void(Entity)>& draw,
+        const std::function<void(const AABB&)>& drawProxy = nullptr);
+
+    // Deletes every query object, the GL context must still be current
+    void releaseQueries();
+
+    const QueryStats& getStats() const { return stats; }
+
+    bool enabled = false;
+    Mode mode = Mode::PreviousFrame;
+
+private:
+    using queryClock = std::chrono::high_resolution_clock;
+
+    struct ObjectQuery {
+        Entity owner;
+        GLuint query = 0;
+        bool pending = false;
+        bool visible = true;
+        uint32_t lastSeenFrame = 0;
+        uint32_t issueFrame = 0;
+        queryClock::time_point issueTime;
+    };
+
+    std::vector<ObjectQuery> objects;   // Indexed by entity index
+    std::vector<uint32_t> trackedEntities;
+    std::vector<Entity> hiddenThisFrame;
+    uint32_t frame = 0;
+    bool queryActive = false;
+    GLenum queryTarget = 0;
+    QueryStats stats;
+
+    ObjectQuery& stateOf(Entity entity);
+    void startQuery(ObjectQuery& object);
+};
+
+#endif // OCCLUSIONQUERIES_H
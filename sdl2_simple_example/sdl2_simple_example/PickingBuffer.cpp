@@ -0,0 +1,275 @@
+#include "PickingBuffer.h"
+#include "ConsoleWindow.h"
+#include <string>
+
+PickingBuffer PickingBuffer::pickingBuffer;
+
+namespace {
+    // Same shading as the fixed pipeline with GL_MODULATE, plus the ID output.
+    // GLSL 1.30 still has the compatibility built-ins, so the glMatrixMode/glColor state is used as is.
+    const char* VERTEX_SHADER = R"(#version 130
+out vec2 texCoord;
+out vec4 color;
+void main() {
+    gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;
+    texCoord = gl_MultiTexCoord0.xy;
+    color = gl_Color;
+}
+)";
+
+    const char* FRAGMENT_SHADER = R"(#version 130
+uniform sampler2D diffuse;
+uniform bool textured;
+uniform uvec2 objectId;
+in vec2 texCoord;
+in vec4 color;
+out vec4 fragColor;
+out uvec2 fragObject;
+void main() {
+    fragColor = textured ? texture(diffuse, texCoord) * color : color;
+    fragObject = objectId;
+}
+)";
+
+    // Without fences a read is trusted once the GPU had this many frames to finish it
+    const uint32_t FALLBACK_READ_DELAY = 2;
+}
+
+bool PickingBuffer::createProgram() {
+    if (!program.build("Picking", VERTEX_SHADER, FRAGMENT_SHADER, {}, { { 0, "fragColor" }, { 1, "fragObject" } })) {
+        return false;
+    }
+
+    objectIdLocation = program.uniform("objectId");
+    texturedLocation = program.uniform("textured");
+    program.use();
+    glUniform1i(program.uniform("diffuse"), 0);
+    glUseProgram(0);
+    return true;
+}
+
+void PickingBuffer::attach(GLuint scene, GLuint colorTexture, GLuint depthBuffer, int newWidth, int newHeight) {
+    sceneFramebuffer = scene;
+    width = newWidth;
+    height = newHeight;
+
+    glGenTextures(1, &idTexture);
+    glBindTexture(GL_TEXTURE_2D, idTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32UI, width, height, 0, GL_RG_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &idFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, idFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, idTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+
+    const GLenum buffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, buffers);
+    glReadBuffer(GL_COLOR_ATTACHMENT1);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        console.addLog("ERROR::FRAMEBUFFER:: ID buffer is not complete, picking uses raycasts");
+        detach();
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, sceneFramebuffer);
+}
+
+void PickingBuffer::detach() {
+    glDeleteFramebuffers(1, &idFramebuffer);
+    glDeleteTextures(1, &idTexture);
+    idFramebuffer = 0;
+    idTexture = 0;
+}
+
+void PickingBuffer::release() {
+    for (Readback& readback : readbacks) {
+        if (readback.fence) {
+            glDeleteSync(readback.fence);
+        }
+        glDeleteBuffers(1, &readback.pbo);
+        readback = Readback();
+    }
+    program.release();
+    detach();
+}
+
+void PickingBuffer::beginPass(bool useOwnShader) {
+    if (!enabled || idFramebuffer == 0) return;
+
+    if (useOwnShader && !program.isValid() && !programFailed && !createProgram()) {
+        programFailed = true;
+        enabled = false;
+        console.addLog("ID buffer picking is not available, clicks use raycasts");
+        return;
+    }
+    if (useOwnShader && !program.isValid()) return;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, idFramebuffer);
+
+    // glClear is undefined on integer buffers
+    const GLuint background[4] = { 0, 0, 0, 0 };
+    glClearBufferuiv(GL_COLOR, 1, background);
+
+    ownShader = useOwnShader;
+    if (ownShader) {
+        program.use();
+    }
+    inPass = true;
+}
+
+void PickingBuffer::setObject(Entity entity, bool textured) {
+    if (!inPass || !ownShader) return;
+
+    // Index + 1 so that 0 means background, the generation tells apart entities reusing a slot
+    glUniform2ui(objectIdLocation, entity.index + 1, entity.generation);
+    glUniform1i(texturedLocation, textured ? 1 : 0);
+}
+
+void PickingBuffer::suspend() {
+    if (!inPass) return;
+    if (ownShader) {
+        glUseProgram(0);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, sceneFramebuffer);
+}
+
+void PickingBuffer::resume() {
+    if (!inPass) return;
+    glBindFramebuffer(GL_FRAMEBUFFER, idFramebuffer);
+    if (ownShader) {
+        program.use();
+    }
+}
+
+void PickingBuffer::endPass() {
+    // The latency is kept until the next result arrives
+    stats.readsIssued = 0;
+    stats.readsCompleted = 0;
+    frame++;
+
+    collectReadbacks();
+    if (!inPass) return;
+
+    // Reads of this frame's IDs, the ID framebuffer is still bound
+    glUseProgram(0);
+    if (click.requested) {
+        issueRead(click, true);
+    }
+    if (hover.requested && hoverHighlight) {
+        issueRead(hover, false);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, sceneFramebuffer);
+    inPass = false;
+}
+
+void PickingBuffer::requestClick(int x, int y) {
+    click = { x, y, true };
+}
+
+void PickingBuffer::requestHover(int x, int y) {
+    hover = { x, y, true };
+}
+
+void PickingBuffer::clearHover() {
+    hover.requested = false;
+    hovered = Entity();
+}
+
+bool PickingBuffer::takeClick(Entity& entity) {
+    if (!clickReady) return false;
+    entity = clickResult;
+    clickReady = false;
+    return true;
+}
+
+void PickingBuffer::issueRead(const Request& request, bool isClick) {
+    if (request.x < 0 || request.y < 0 || request.x >= width || request.y >= height) {
+        if (isClick) click.requested = false;
+        return;
+    }
+
+    Readback* slot = nullptr;
+    for (Readback& readback : readbacks) {
+        if (!readback.pending) {
+            slot = &readback;
+            break;
+        }
+    }
+    // Every slot is in flight: a click waits for the next frame, a hover is simply dropped
+    if (!slot) return;
+
+    if (slot->pbo == 0) {
+        glGenBuffers(1, &slot->pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, 2 * sizeof(GLuint), nullptr, GL_STREAM_READ);
+    }
+
+    // The projection flips y, so the image's top row is row 0 of the framebuffer
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+    glReadPixels(request.x, request.y, 1, 1, GL_RG_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot->fence = GLEW_ARB_sync ? glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) : nullptr;
+    slot->issueFrame = frame;
+    slot->pending = true;
+    slot->click = isClick;
+    stats.readsIssued++;
+
+    if (isClick) {
+        click.requested = false;
+    }
+}
+
+void PickingBuffer::collectReadbacks() {
+    uint32_t newestHover = 0;
+    bool hoverRead = false;
+
+    for (Readback& readback : readbacks) {
+        if (!readback.pending) continue;
+
+        bool ready = false;
+        if (readback.fence) {
+            const GLenum status = glClientWaitSync(readback.fence, 0, 0);
+            ready = status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+        }
+        else {
+            ready = frame - readback.issueFrame >= FALLBACK_READ_DELAY;
+        }
+        if (!ready) continue;
+
+        GLuint values[2] = { 0, 0 };
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+        glGetBufferSubData(GL_PIXEL_PACK_BUFFER, 0, sizeof(values), values);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        if (readback.fence) {
+            glDeleteSync(readback.fence);
+            readback.fence = nullptr;
+        }
+        readback.pending = false;
+
+        Entity entity;
+        if (values[0] != 0) {
+            entity.index = values[0] - 1;
+            entity.generation = values[1];
+        }
+
+        stats.readsCompleted++;
+        stats.latencyFrames = static_cast<float>(frame - readback.issueFrame);
+
+        if (readback.click) {
+            clickResult = entity;
+            clickReady = true;
+        }
+        else if (hover.requested && (!hoverRead || readback.issueFrame >= newestHover)) {
+            // Only the newest hover result counts, and none once the cursor left the scene
+            hovered = entity;
+            newestHover = readback.issueFrame;
+            hoverRead = true;
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#ifndef PICKINGBUFFER_H
+#define PICKINGBUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <GL/glew.h>
+#include "ECS.h"
+#include "ShaderProgram.h"
+
+struct PickingStats {
+    size_t readsIssued = 0;         // Pixel reads started this frame
+    size_t readsCompleted = 0;      // Reads whose result arrived this frame
+    float latencyFrames = 0.0f;     // Age of the last result read, in frames
+};
+
+// Object IDs written next to the scene's colors during the normal pass.
+// Every drawn entity writes its index and generation, through the scene's unlit material or, under the
+// fixed pipeline, a small shader that also does the regular textured shading, so picking costs the same
+// whatever the triangle count. The pass draws into a second
+// framebuffer sharing the scene's color and depth buffers plus an integer ID texture: drivers refuse
+// fixed pipeline draws into a framebuffer with an integer attachment, so the grid and gizmos keep
+// using the scene framebuffer.
+// A pick reads the pixel under the cursor into a pixel buffer object, the result is collected on a later
+// frame once its fence has passed, so the CPU never waits for the GPU. Clicks and hover share the same
+// few read slots.
+class PickingBuffer {
+public:
+    static PickingBuffer pickingBuffer;
+
+    static const int READ_SLOTS = 3;
+
+    // Builds the ID framebuffer around the scene's color texture and depth buffer
+    void attach(GLuint sceneFramebuffer, GLuint colorTexture, GLuint depthBuffer, int width, int height);
+    void detach();
+    // Deletes the shader and pixel buffers, the GL context must still be current
+    void release();
+
+    // Scene pass: between these two every draw writes the current object's ID. Without its own shader
+    // the scene's shaders write the IDs themselves, and setObject has nothing to do.
+    void beginPass(bool useOwnShader = true);
+    void setObject(Entity entity, bool textured);
+    void endPass();
+
+    // Draws that mustn't write IDs inside the pass, such as gizmos, go between these two
+    void suspend();
+    void resume();
+
+    // Pixel coordinates in the framebuffer, row 0 at the top of the displayed image
+    void requestClick(int x, int y);
+    void requestHover(int x, int y);
+    void clearHover();
+
+    // The entity under the last click, invalid when it landed on the background. Each result is returned once.
+    bool takeClick(Entity& entity);
+    Entity getHovered() const { return hovered; }
+
+    const PickingStats& getStats() const { return stats; }
+    bool isActive() const { return enabled && !programFailed && idFramebuffer != 0; }
+
+    bool enabled = false;
+    bool hoverHighlight = true;
+
+private:
+    struct Readback {
+        GLuint pbo = 0;
+        GLsync fence = nullptr;
+        uint32_t issueFrame = 0;
+        bool pending = false;
+        bool click = false;
+    };
+
+    struct Request {
+        int x = 0, y = 0;
+        bool requested = false;
+    };
+
+    ShaderProgram program;
+    GLint objectIdLocation = -1;
+    GLint texturedLocation = -1;
+    bool programFailed = false;
+
+    GLuint sceneFramebuffer = 0;
+    GLuint idFramebuffer = 0;
+    GLuint idTexture = 0;
+    int width = 0;
+    int height = 0;
+    bool inPass = false;
+    bool ownShader = true;
+
+    Readback readbacks[READ_SLOTS];
+    Request click;
+    Request hover;
+    bool clickReady = false;
+    Entity clickResult;
+    Entity hovered;
+    uint32_t frame = 0;
+    PickingStats stats;
+
+    bool createProgram();
+    void collectReadbacks();
+    void issueRead(const Request& request, bool isClick);
+};
+
+#endif // PICKINGBUFFER_H
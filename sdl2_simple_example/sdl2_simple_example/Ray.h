@@ -8,13 +8,13 @@ public:
     glm::vec3 origin;
     glm::vec3 direction;
 
-    const float EPSILON = 1e-6f; 
+    static constexpr float EPSILON = 1e-6f;
 
     Ray(const glm::vec3& origin, const glm::vec3& direction)
         : origin(origin), direction(direction) {}
 
     // Calculate the intersection of the ray with a plane.
-    bool intersects(const glm::vec3& planePoint, const glm::vec3& planeNormal, float& t) {
+    bool intersects(const glm::vec3& planePoint, const glm::vec3& planeNormal, float& t) const {
         float denom = glm::dot(planeNormal, direction);
         if (abs(denom) > 1e-6) {
             glm::vec3 p0l0 = planePoint - origin;
@@ -24,7 +24,13 @@ public:
         return false;
     }
 
-    bool intersectsTriangle(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, float& t) {
+    bool intersectsTriangle(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, float& t) const {
+        float u = 0.0f, v = 0.0f;
+        return intersectsTriangle(v0, v1, v2, t, u, v);
+    }
+
+    // Same test, also giving the barycentrics of the hit: point = (1 - u - v) * v0 + u * v1 + v * v2
+    bool intersectsTriangle(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, float& t, float& u, float& v) const {
         glm::vec3 e1 = v1 - v0;
         glm::vec3 e2 = v2 - v0;
         glm::vec3 h = glm::cross(direction, e2);
@@ -39,14 +45,14 @@ public:
         // Calculate the intersection parameter (barycentric)
         float f = 1.0f / a;
         glm::vec3 s = origin - v0;
-        float u = f * glm::dot(s, h);
+        u = f * glm::dot(s, h);
 
         if (u < 0.0f || u > 1.0f) {
             return false;
         }
 
         glm::vec3 q = glm::cross(s, e1);
-        float v = f * glm::dot(direction, q);
+        v = f * glm::dot(direction, q);
 
         if (v < 0.0f || u + v > 1.0f) {
             return false;
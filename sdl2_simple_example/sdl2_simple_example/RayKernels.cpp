@@ -0,0 +1,326 @@
+#include "RayKernels.h"
+#include <cmath>
+
+RayKernels::Backend RayKernels::activeBackend = CpuFeatures::bestBackend();
+
+void PackedTriangles::clear() {
+    count = 0;
+    for (std::vector<float>* component : { &v0x, &v0y, &v0z, &e1x, &e1y, &e1z, &e2x, &e2y, &e2z }) {
+        component->clear();
+    }
+}
+
+void PackedTriangles::reserve(size_t triangleCount) {
+    for (std::vector<float>* component : { &v0x, &v0y, &v0z, &e1x, &e1y, &e1z, &e2x, &e2y, &e2z }) {
+        component->reserve(triangleCount + PADDING);
+    }
+}
+
+void PackedTriangles::add(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2) {
+    const glm::vec3 e1 = v1 - v0;
+    const glm::vec3 e2 = v2 - v0;
+    const float values[9] = { v0.x, v0.y, v0.z, e1.x, e1.y, e1.z, e2.x, e2.y, e2.z };
+
+    // The new triangle takes the place of the first padding entry, a new one goes at the end
+    std::vector<float>* components[9] = { &v0x, &v0y, &v0z, &e1x, &e1y, &e1z, &e2x, &e2y, &e2z };
+    for (int c = 0; c < 9; ++c) {
+        components[c]->resize(count + PADDING + 1, 0.0f);
+        (*components[c])[count] = values[c];
+    }
+    count++;
+}
+
+void RayPacket::clear() {
+    count = 0;
+    for (std::vector<float>* component : { &ox, &oy, &oz, &dx, &dy, &dz, &tMax, &u, &v }) {
+        component->clear();
+    }
+    triangle.clear();
+}
+
+void RayPacket::add(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) {
+    const float values[9] = { origin.x, origin.y, origin.z, direction.x, direction.y, direction.z, maxDistance, 0.0f, 0.0f };
+
+    // Padding rays have no direction, so they can't hit anything either
+    std::vector<float>* components[9] = { &ox, &oy, &oz, &dx, &dy, &dz, &tMax, &u, &v };
+    for (int c = 0; c < 9; ++c) {
+        components[c]->resize(count + PackedTriangles::PADDING + 1, 0.0f);
+        (*components[c])[count] = values[c];
+    }
+    triangle.resize(count + PackedTriangles::PADDING + 1, NO_HIT);
+    triangle[count] = NO_HIT;
+    count++;
+}
+
+namespace {
+    // The reference test, the SIMD paths do the same operations in the same order
+    inline bool intersectScalar(const PackedTriangles& tr, size_t i, float ox, float oy, float oz, float dx, float dy, float dz,
+        float& t, float& u, float& v) {
+        const float hx = dy * tr.e2z[i] - dz * tr.e2y[i];
+        const float hy = dz * tr.e2x[i] - dx * tr.e2z[i];
+        const float hz = dx * tr.e2y[i] - dy * tr.e2x[i];
+        const float a = tr.e1x[i] * hx + tr.e1y[i] * hy + tr.e1z[i] * hz;
+        if (std::fabs(a) < RayKernels::PARALLEL_EPSILON) return false;
+
+        const float f = 1.0f / a;
+        const float sx = ox - tr.v0x[i], sy = oy - tr.v0y[i], sz = oz - tr.v0z[i];
+        u = f * (sx * hx + sy * hy + sz * hz);
+        if (u < 0.0f || u > 1.0f) return false;
+
+        const float qx = sy * tr.e1z[i] - sz * tr.e1y[i];
+        const float qy = sz * tr.e1x[i] - sx * tr.e1z[i];
+        const float qz = sx * tr.e1y[i] - sy * tr.e1x[i];
+        v = f * (dx * qx + dy * qy + dz * qz);
+        if (v < 0.0f || u + v > 1.0f) return false;
+
+        t = f * (tr.e2x[i] * qx + tr.e2y[i] * qy + tr.e2z[i] * qz);
+        return t > 0.0f;
+    }
+
+    bool closestScalar(const PackedTriangles& triangles, size_t begin, size_t end, const glm::vec3& o, const glm::vec3& d,
+        float& maxDistance, TriangleHit& hit) {
+        bool found = false;
+        for (size_t i = begin; i < end; ++i) {
+            float t, u, v;
+            if (intersectScalar(triangles, i, o.x, o.y, o.z, d.x, d.y, d.z, t, u, v) && t < maxDistance) {
+                maxDistance = t;
+                hit = { t, static_cast<uint32_t>(i), u, v };
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    void packetScalar(RayPacket& rays, const PackedTriangles& triangles, size_t triangle) {
+        for (size_t r = 0; r < rays.size(); ++r) {
+            float t, u, v;
+            if (intersectScalar(triangles, triangle, rays.ox[r], rays.oy[r], rays.oz[r], rays.dx[r], rays.dy[r], rays.dz[r], t, u, v) && t < rays.tMax[r]) {
+                rays.tMax[r] = t;
+                rays.u[r] = u;
+                rays.v[r] = v;
+                rays.triangle[r] = static_cast<uint32_t>(triangle);
+            }
+        }
+    }
+
+#ifdef CPU_FEATURES_X86
+    // Lanes of one Möller-Trumbore test, inputs and outputs one register per component
+    struct Lanes4 { __m128 t, u, v, hit; };
+
+    inline Lanes4 intersect4(__m128 ox, __m128 oy, __m128 oz, __m128 dx, __m128 dy, __m128 dz,
+        __m128 v0x, __m128 v0y, __m128 v0z, __m128 e1x, __m128 e1y, __m128 e1z, __m128 e2x, __m128 e2y, __m128 e2z) {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+        const __m128 hx = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+        const __m128 hy = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+        const __m128 hz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+        const __m128 a = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, hx), _mm_mul_ps(e1y, hy)), _mm_mul_ps(e1z, hz));
+
+        const __m128 f = _mm_div_ps(one, a);
+        const __m128 sx = _mm_sub_ps(ox, v0x), sy = _mm_sub_ps(oy, v0y), sz = _mm_sub_ps(oz, v0z);
+        const __m128 u = _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, hx), _mm_mul_ps(sy, hy)), _mm_mul_ps(sz, hz)));
+
+        const __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+        const __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+        const __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+        const __m128 v = _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)));
+        const __m128 t = _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)));
+
+        // Comparisons with the NaNs of a zero determinant are false, those lanes drop out with the epsilon test
+        __m128 hit = _mm_cmpge_ps(_mm_and_ps(a, absMask), _mm_set1_ps(RayKernels::PARALLEL_EPSILON));
+        hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmple_ps(u, one)));
+        hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpge_ps(v, zero), _mm_cmple_ps(_mm_add_ps(u, v), one)));
+        hit = _mm_and_ps(hit, _mm_cmpgt_ps(t, zero));
+        return { t, u, v, hit };
+    }
+
+    bool closestSSE(const PackedTriangles& tr, size_t begin, size_t end, const glm::vec3& o, const glm::vec3& d,
+        float& maxDistance, TriangleHit& hit) {
+        const __m128 ox = _mm_set1_ps(o.x), oy = _mm_set1_ps(o.y), oz = _mm_set1_ps(o.z);
+        const __m128 dx = _mm_set1_ps(d.x), dy = _mm_set1_ps(d.y), dz = _mm_set1_ps(d.z);
+
+        bool found = false;
+        for (size_t i = begin; i < end; i += 4) {
+            const Lanes4 lanes = intersect4(ox, oy, oz, dx, dy, dz,
+                _mm_loadu_ps(&tr.v0x[i]), _mm_loadu_ps(&tr.v0y[i]), _mm_loadu_ps(&tr.v0z[i]),
+                _mm_loadu_ps(&tr.e1x[i]), _mm_loadu_ps(&tr.e1y[i]), _mm_loadu_ps(&tr.e1z[i]),
+                _mm_loadu_ps(&tr.e2x[i]), _mm_loadu_ps(&tr.e2y[i]), _mm_loadu_ps(&tr.e2z[i]));
+
+            // Lanes past the end belong to the padding or to triangles outside the range
+            const size_t valid = end - i < 4 ? end - i : 4;
+            int bits = _mm_movemask_ps(_mm_and_ps(lanes.hit, _mm_cmplt_ps(lanes.t, _mm_set1_ps(maxDistance))));
+            bits &= (1 << valid) - 1;
+            if (bits == 0) continue;
+
+            float t[4], u[4], v[4];
+            _mm_storeu_ps(t, lanes.t);
+            _mm_storeu_ps(u, lanes.u);
+            _mm_storeu_ps(v, lanes.v);
+            for (int lane = 0; lane < 4; ++lane) {
+                if ((bits & (1 << lane)) && t[lane] < maxDistance) {
+                    maxDistance = t[lane];
+                    hit = { t[lane], static_cast<uint32_t>(i + lane), u[lane], v[lane] };
+                    found = true;
+                }
+            }
+        }
+        return found;
+    }
+
+    inline __m128 select4(__m128 mask, __m128 a, __m128 b) {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+
+    void packetSSE(RayPacket& rays, const PackedTriangles& tr, size_t triangle) {
+        const __m128 v0x = _mm_set1_ps(tr.v0x[triangle]), v0y = _mm_set1_ps(tr.v0y[triangle]), v0z = _mm_set1_ps(tr.v0z[triangle]);
+        const __m128 e1x = _mm_set1_ps(tr.e1x[triangle]), e1y = _mm_set1_ps(tr.e1y[triangle]), e1z = _mm_set1_ps(tr.e1z[triangle]);
+        const __m128 e2x = _mm_set1_ps(tr.e2x[triangle]), e2y = _mm_set1_ps(tr.e2y[triangle]), e2z = _mm_set1_ps(tr.e2z[triangle]);
+        const __m128 id = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(triangle)));
+
+        // Padding rays never hit, so whole registers can be written back
+        for (size_t r = 0; r < rays.size(); r += 4) {
+            const Lanes4 lanes = intersect4(_mm_loadu_ps(&rays.ox[r]), _mm_loadu_ps(&rays.oy[r]), _mm_loadu_ps(&rays.oz[r]),
+                _mm_loadu_ps(&rays.dx[r]), _mm_loadu_ps(&rays.dy[r]), _mm_loadu_ps(&rays.dz[r]),
+                v0x, v0y, v0z, e1x, e1y, e1z, e2x, e2y, e2z);
+
+            const __m128 tMax = _mm_loadu_ps(&rays.tMax[r]);
+            const __m128 nearer = _mm_and_ps(lanes.hit, _mm_cmplt_ps(lanes.t, tMax));
+            if (_mm_movemask_ps(nearer) == 0) continue;
+
+            float* triangleIds = reinterpret_cast<float*>(&rays.triangle[r]);
+            _mm_storeu_ps(&rays.tMax[r], select4(nearer, lanes.t, tMax));
+            _mm_storeu_ps(&rays.u[r], select4(nearer, lanes.u, _mm_loadu_ps(&rays.u[r])));
+            _mm_storeu_ps(&rays.v[r], select4(nearer, lanes.v, _mm_loadu_ps(&rays.v[r])));
+            _mm_storeu_ps(triangleIds, select4(nearer, id, _mm_loadu_ps(triangleIds)));
+        }
+    }
+
+    struct Lanes8 { __m256 t, u, v, hit; };
+
+    TARGET_AVX2 inline Lanes8 intersect8(__m256 ox, __m256 oy, __m256 oz, __m256 dx, __m256 dy, __m256 dz,
+        __m256 v0x, __m256 v0y, __m256 v0z, __m256 e1x, __m256 e1y, __m256 e1z, __m256 e2x, __m256 e2y, __m256 e2z) {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+
+        const __m256 hx = _mm256_sub_ps(_mm256_mul_ps(dy, e2z), _mm256_mul_ps(dz, e2y));
+        const __m256 hy = _mm256_sub_ps(_mm256_mul_ps(dz, e2x), _mm256_mul_ps(dx, e2z));
+        const __m256 hz = _mm256_sub_ps(_mm256_mul_ps(dx, e2y), _mm256_mul_ps(dy, e2x));
+        const __m256 a = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e1x, hx), _mm256_mul_ps(e1y, hy)), _mm256_mul_ps(e1z, hz));
+
+        const __m256 f = _mm256_div_ps(one, a);
+        const __m256 sx = _mm256_sub_ps(ox, v0x), sy = _mm256_sub_ps(oy, v0y), sz = _mm256_sub_ps(oz, v0z);
+        const __m256 u = _mm256_mul_ps(f, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(sx, hx), _mm256_mul_ps(sy, hy)), _mm256_mul_ps(sz, hz)));
+
+        const __m256 qx = _mm256_sub_ps(_mm256_mul_ps(sy, e1z), _mm256_mul_ps(sz, e1y));
+        const __m256 qy = _mm256_sub_ps(_mm256_mul_ps(sz, e1x), _mm256_mul_ps(sx, e1z));
+        const __m256 qz = _mm256_sub_ps(_mm256_mul_ps(sx, e1y), _mm256_mul_ps(sy, e1x));
+        const __m256 v = _mm256_mul_ps(f, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, qx), _mm256_mul_ps(dy, qy)), _mm256_mul_ps(dz, qz)));
+        const __m256 t = _mm256_mul_ps(f, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e2x, qx), _mm256_mul_ps(e2y, qy)), _mm256_mul_ps(e2z, qz)));
+
+        __m256 hit = _mm256_cmp_ps(_mm256_and_ps(a, absMask), _mm256_set1_ps(RayKernels::PARALLEL_EPSILON), _CMP_GE_OQ);
+        hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(u, zero, _CMP_GE_OQ), _mm256_cmp_ps(u, one, _CMP_LE_OQ)));
+        hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(v, zero, _CMP_GE_OQ), _mm256_cmp_ps(_mm256_add_ps(u, v), one, _CMP_LE_OQ)));
+        hit = _mm256_and_ps(hit, _mm256_cmp_ps(t, zero, _CMP_GT_OQ));
+        return { t, u, v, hit };
+    }
+
+    TARGET_AVX2 bool closestAVX2(const PackedTriangles& tr, size_t begin, size_t end, const glm::vec3& o, const glm::vec3& d,
+        float& maxDistance, TriangleHit& hit) {
+        const __m256 ox = _mm256_set1_ps(o.x), oy = _mm256_set1_ps(o.y), oz = _mm256_set1_ps(o.z);
+        const __m256 dx = _mm256_set1_ps(d.x), dy = _mm256_set1_ps(d.y), dz = _mm256_set1_ps(d.z);
+
+        bool found = false;
+        size_t i = begin;
+        for (; i + 4 < end; i += 8) {
+            const Lanes8 lanes = intersect8(ox, oy, oz, dx, dy, dz,
+                _mm256_loadu_ps(&tr.v0x[i]), _mm256_loadu_ps(&tr.v0y[i]), _mm256_loadu_ps(&tr.v0z[i]),
+                _mm256_loadu_ps(&tr.e1x[i]), _mm256_loadu_ps(&tr.e1y[i]), _mm256_loadu_ps(&tr.e1z[i]),
+                _mm256_loadu_ps(&tr.e2x[i]), _mm256_loadu_ps(&tr.e2y[i]), _mm256_loadu_ps(&tr.e2z[i]));
+
+            const size_t valid = end - i < 8 ? end - i : 8;
+            int bits = _mm256_movemask_ps(_mm256_and_ps(lanes.hit, _mm256_cmp_ps(lanes.t, _mm256_set1_ps(maxDistance), _CMP_LT_OQ)));
+            bits &= (1 << valid) - 1;
+            if (bits == 0) continue;
+
+            float t[8], u[8], v[8];
+            _mm256_storeu_ps(t, lanes.t);
+            _mm256_storeu_ps(u, lanes.u);
+            _mm256_storeu_ps(v, lanes.v);
+            for (int lane = 0; lane < 8; ++lane) {
+                if ((bits & (1 << lane)) && t[lane] < maxDistance) {
+                    maxDistance = t[lane];
+                    hit = { t[lane], static_cast<uint32_t>(i + lane), u[lane], v[lane] };
+                    found = true;
+                }
+            }
+        }
+
+        // Four or fewer left, the usual size of a BVH leaf: half a register is enough
+        if (i < end && closestSSE(tr, i, end, o, d, maxDistance, hit)) {
+            found = true;
+        }
+        return found;
+    }
+
+    TARGET_AVX2 void packetAVX2(RayPacket& rays, const PackedTriangles& tr, size_t triangle) {
+        const __m256 v0x = _mm256_set1_ps(tr.v0x[triangle]), v0y = _mm256_set1_ps(tr.v0y[triangle]), v0z = _mm256_set1_ps(tr.v0z[triangle]);
+        const __m256 e1x = _mm256_set1_ps(tr.e1x[triangle]), e1y = _mm256_set1_ps(tr.e1y[triangle]), e1z = _mm256_set1_ps(tr.e1z[triangle]);
+        const __m256 e2x = _mm256_set1_ps(tr.e2x[triangle]), e2y = _mm256_set1_ps(tr.e2y[triangle]), e2z = _mm256_set1_ps(tr.e2z[triangle]);
+        const __m256 id = _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int>(triangle)));
+
+        for (size_t r = 0; r < rays.size(); r += 8) {
+            const Lanes8 lanes = intersect8(_mm256_loadu_ps(&rays.ox[r]), _mm256_loadu_ps(&rays.oy[r]), _mm256_loadu_ps(&rays.oz[r]),
+                _mm256_loadu_ps(&rays.dx[r]), _mm256_loadu_ps(&rays.dy[r]), _mm256_loadu_ps(&rays.dz[r]),
+                v0x, v0y, v0z, e1x, e1y, e1z, e2x, e2y, e2z);
+
+            const __m256 tMax = _mm256_loadu_ps(&rays.tMax[r]);
+            const __m256 nearer = _mm256_and_ps(lanes.hit, _mm256_cmp_ps(lanes.t, tMax, _CMP_LT_OQ));
+            if (_mm256_movemask_ps(nearer) == 0) continue;
+
+            float* triangleIds = reinterpret_cast<float*>(&rays.triangle[r]);
+            _mm256_storeu_ps(&rays.tMax[r], _mm256_blendv_ps(tMax, lanes.t, nearer));
+            _mm256_storeu_ps(&rays.u[r], _mm256_blendv_ps(_mm256_loadu_ps(&rays.u[r]), lanes.u, nearer));
+            _mm256_storeu_ps(&rays.v[r], _mm256_blendv_ps(_mm256_loadu_ps(&rays.v[r]), lanes.v, nearer));
+            _mm256_storeu_ps(triangleIds, _mm256_blendv_ps(_mm256_loadu_ps(triangleIds), id, nearer));
+        }
+    }
+#endif
+}
+
+RayKernels::Backend RayKernels::getBackend() {
+    return activeBackend;
+}
+
+void RayKernels::setBackend(Backend backend) {
+    activeBackend = CpuFeatures::isSupported(backend) ? backend : CpuFeatures::bestBackend();
+}
+
+bool RayKernels::intersectClosest(const PackedTriangles& triangles, size_t begin, size_t end,
+    const glm::vec3& origin, const glm::vec3& direction, float& maxDistance, TriangleHit& hit) {
+#ifdef CPU_FEATURES_X86
+    if (activeBackend == Backend::AVX2) {
+        return closestAVX2(triangles, begin, end, origin, direction, maxDistance, hit);
+    }
+    if (activeBackend == Backend::SSE) {
+        return closestSSE(triangles, begin, end, origin, direction, maxDistance, hit);
+    }
+#endif
+    return closestScalar(triangles, begin, end, origin, direction, maxDistance, hit);
+}
+
+void RayKernels::intersectPacket(RayPacket& rays, const PackedTriangles& triangles, size_t triangle) {
+#ifdef CPU_FEATURES_X86
+    if (activeBackend == Backend::AVX2) {
+        packetAVX2(rays, triangles, triangle);
+        return;
+    }
+    if (activeBackend == Backend::SSE) {
+        packetSSE(rays, triangles, triangle);
+        return;
+    }
+#endif
+    packetScalar(rays, triangles, triangle);
+}
@@ -0,0 +1,81 @@
+#ifndef RAYKERNELS_H
+#define RAYKERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "CpuFeatures.h"
+
+// Triangles as one vertex and two edges, each component in its own array.
+// Every array is followed by PADDING zeroed entries so the kernels can load whole registers past the end,
+// a zero triangle is parallel to every ray and never hit.
+struct PackedTriangles {
+    static constexpr size_t PADDING = 8;
+
+    std::vector<float> v0x, v0y, v0z;
+    std::vector<float> e1x, e1y, e1z;
+    std::vector<float> e2x, e2y, e2z;
+
+    void clear();
+    void reserve(size_t count);
+    void add(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2);
+    size_t size() const { return count; }
+
+private:
+    size_t count = 0;
+};
+
+// Rays in the same layout, with the closest hit found so far for each one.
+// tMax starts as the search distance and shrinks to the hit distance.
+struct RayPacket {
+    std::vector<float> ox, oy, oz;
+    std::vector<float> dx, dy, dz;
+    std::vector<float> tMax;
+    std::vector<float> u, v;
+    std::vector<uint32_t> triangle;     // NO_HIT until something is found
+
+    static constexpr uint32_t NO_HIT = UINT32_MAX;
+
+    void clear();
+    void add(const glm::vec3& origin, const glm::vec3& direction, float maxDistance);
+    size_t size() const { return count; }
+
+private:
+    size_t count = 0;
+};
+
+struct TriangleHit {
+    float distance = 0.0f;
+    uint32_t index = 0;     // Position of the triangle in the PackedTriangles
+    float u = 0.0f;         // point = (1 - u - v) * v0 + u * v1 + v * v2
+    float v = 0.0f;
+};
+
+// Möller-Trumbore ray/triangle tests for picking and any other batched ray query.
+// One ray goes through 4 (SSE) or 8 (AVX2) triangles at a time, or a packet of rays through one triangle.
+// The best path is picked at startup, every path gives the same hits as the scalar one.
+class RayKernels {
+public:
+    using Backend = SimdBackend;
+
+    static Backend getBackend();
+    // Picking and mesh tests use this path from then on, the Benchmark compares each one against scalar
+    static void setBackend(Backend backend);
+
+    // Nearest of the triangles [begin, end) hit closer than maxDistance, which then becomes the hit distance.
+    // The direction doesn't need to be normalized.
+    static bool intersectClosest(const PackedTriangles& triangles, size_t begin, size_t end,
+        const glm::vec3& origin, const glm::vec3& direction, float& maxDistance, TriangleHit& hit);
+
+    // Every ray of the packet against one triangle, rays that hit it nearer than their tMax record the hit
+    static void intersectPacket(RayPacket& rays, const PackedTriangles& triangles, size_t triangle);
+
+    // Determinants below this mean the ray runs along the triangle
+    static constexpr float PARALLEL_EPSILON = 1e-12f;
+
+private:
+    static Backend activeBackend;
+};
+
+#endif // RAYKERNELS_H
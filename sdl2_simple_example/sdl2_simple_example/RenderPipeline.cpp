@@ -0,0 +1,455 @@
+#include "RenderPipeline.h"
+#include "GpuMesh.h"
+#include "ConsoleWindow.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+RenderPipeline RenderPipeline::renderPipeline;
+
+namespace {
+    const GLuint CAMERA_BINDING = 0;
+    const GLint OBJECT_TEXTURE_UNIT = 1;
+    const GLint ID_TEXTURE_UNIT = 2;
+
+    // The grid's spacing grows tenfold for every tenfold of camera height above this
+    const float GRID_LEVEL_HEIGHT = 10.0f;
+    const GLsizei CUBE_TRIANGLE_VERTICES = 36;
+
+    // std140 block, three column major mat4 in a row
+    struct CameraBlock {
+        glm::mat4 projection;
+        glm::mat4 view;
+        glm::mat4 viewProjection;
+    };
+
+    // GLSL 1.40 is the first with uniform blocks and texture buffers, and what Mesa offers on any 3.1 context
+    const char* UNLIT_VERTEX_SHADER = R"(#version 140
+layout(std140) uniform Camera {
+    mat4 projection;
+    mat4 view;
+    mat4 viewProjection;
+};
+uniform samplerBuffer objectRecords;
+uniform usamplerBuffer objectIds;
+uniform int objectIndex;
+uniform bool indirect;
+in vec3 position;
+in vec2 texCoord;
+in float batchSlot;
+in float drawRecord;
+out vec2 uv;
+out vec4 tint;
+flat out uvec2 objectId;
+void main() {
+    // Instances of a batch have consecutive records, and so do the objects of a static batch.
+    // An indirect draw's instanced attribute already counts from the command's first record.
+    int object = (indirect ? int(drawRecord) : objectIndex + gl_InstanceID) + int(batchSlot);
+    int base = object * 5;
+    mat4 world = mat4(texelFetch(objectRecords, base), texelFetch(objectRecords, base + 1),
+        texelFetch(objectRecords, base + 2), texelFetch(objectRecords, base + 3));
+    tint = texelFetch(objectRecords, base + 4);
+    objectId = texelFetch(objectIds, object).xy;
+    uv = texCoord;
+    gl_Position = viewProjection * world * vec4(position, 1.0);
+}
+)";
+
+    // Same result as the fixed pipeline's GL_MODULATE, plus the picking ID
+    const char* UNLIT_FRAGMENT_SHADER = R"(#version 140
+uniform sampler2D diffuse;
+uniform bool textured;
+in vec2 uv;
+in vec4 tint;
+flat in uvec2 objectId;
+out vec4 fragColor;
+out uvec2 fragObject;
+void main() {
+    fragColor = textured ? texture(diffuse, uv) * tint : tint;
+    fragObject = objectId;
+}
+)";
+
+    const char* FLAT_VERTEX_SHADER = R"(#version 140
+layout(std140) uniform Camera {
+    mat4 projection;
+    mat4 view;
+    mat4 viewProjection;
+};
+uniform mat4 model;
+in vec3 position;
+void main() {
+    gl_Position = viewProjection * model * vec4(position, 1.0);
+}
+)";
+
+    const char* FLAT_FRAGMENT_SHADER = R"(#version 140
+uniform vec3 color;
+out vec4 fragColor;
+void main() {
+    fragColor = vec4(color, 1.0);
+}
+)";
+
+    const char* GRID_VERTEX_SHADER = R"(#version 140
+out vec2 ndc;
+void main() {
+    // One triangle over the whole screen
+    ndc = vec2(gl_VertexID == 1 ? 3.0 : -1.0, gl_VertexID == 2 ? 3.0 : -1.0);
+    gl_Position = vec4(ndc, 0.0, 1.0);
+}
+)";
+
+    // Each pixel's view ray meets the y = 0 plane, lines are where the point is within a pixel of a multiple
+    // of the spacing, measured with screen space derivatives so they stay one pixel wide at any distance
+    const char* GRID_FRAGMENT_SHADER = R"(#version 140
+uniform mat4 inverseViewProjection;
+uniform mat4 viewProjection;
+uniform vec3 cameraPosition;
+uniform float spacing;
+uniform float blend;
+uniform vec3 color;
+in vec2 ndc;
+out vec4 fragColor;
+
+float lines(vec2 point, float cellSize) {
+    vec2 cell = point / cellSize;
+    vec2 width = fwidth(cell);
+    vec2 distance = abs(fract(cell - 0.5) - 0.5) / width;
+    // Cells under two pixels wide would be a solid moire, they fade out instead
+    float crowding = clamp(max(width.x, width.y) * 2.0 - 0.5, 0.0, 1.0);
+    return (1.0 - min(min(distance.x, distance.y), 1.0)) * (1.0 - crowding);
+}
+
+void main() {
+    vec4 nearPoint = inverseViewProjection * vec4(ndc, -1.0, 1.0);
+    vec4 farPoint = inverseViewProjection * vec4(ndc, 1.0, 1.0);
+    vec3 from = nearPoint.xyz / nearPoint.w;
+    vec3 to = farPoint.xyz / farPoint.w;
+    float t = -from.y / (to.y - from.y);
+    if (!(t > 0.0 && t < 1.0)) discard;
+
+    vec3 point = from + t * (to - from);
+    vec4 clip = viewProjection * vec4(point, 1.0);
+    gl_FragDepth = clip.z / clip.w * 0.5 + 0.5;
+
+    // The finer level fades out as the camera climbs towards the next one
+    float alpha = max(lines(point.xz, spacing) * (1.0 - blend), lines(point.xz, spacing * 10.0));
+    float fadeDistance = 80.0 * max(1.0, abs(cameraPosition.y) / 10.0);
+    alpha *= 1.0 - smoothstep(fadeDistance * 0.3, fadeDistance, length(point.xz - cameraPosition.xz));
+    if (alpha <= 0.0) discard;
+    fragColor = vec4(color, alpha);
+}
+)";
+
+    // Maps the unit cube onto a box
+    glm::mat4 boxMatrix(const AABB& box) {
+        const glm::vec3 size = box.max - box.min;
+        glm::mat4 matrix(1.0f);
+        matrix[0][0] = size.x;
+        matrix[1][1] = size.y;
+        matrix[2][2] = size.z;
+        matrix[3] = glm::vec4(box.min, 1.0f);
+        return matrix;
+    }
+
+    glm::vec3 cubeCorner(int bits) {
+        return glm::vec3(bits & 1 ? 1.0f : 0.0f, bits & 2 ? 1.0f : 0.0f, bits & 4 ? 1.0f : 0.0f);
+    }
+}
+
+void RenderPipeline::init() {
+    if (!GLEW_VERSION_3_1) {
+        console.addLog("OpenGL 3.1 is not available, drawing with the fixed pipeline");
+        return;
+    }
+    if (!createPrograms()) {
+        console.addLog("Scene shaders failed to build, drawing with the fixed pipeline");
+        release();
+        return;
+    }
+
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+
+    glGenBuffers(1, &cameraBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, cameraBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraBlock), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glGenBuffers(1, &objectBuffer);
+    glGenBuffers(1, &idBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, objectBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, TEXELS_PER_OBJECT * sizeof(glm::vec4), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, idBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, 2 * sizeof(GLuint), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glGenTextures(1, &objectTexture);
+    glBindTexture(GL_TEXTURE_BUFFER, objectTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, objectBuffer);
+    glGenTextures(1, &idTexture);
+    glBindTexture(GL_TEXTURE_BUFFER, idTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, idBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    createCube();
+    available = true;
+}
+
+bool RenderPipeline::createPrograms() {
+    if (!unlitProgram.build("Unlit", UNLIT_VERTEX_SHADER, UNLIT_FRAGMENT_SHADER,
+        { { POSITION_ATTRIBUTE, "position" }, { TEXCOORD_ATTRIBUTE, "texCoord" }, { BATCH_SLOT_ATTRIBUTE, "batchSlot" },
+            { DRAW_RECORD_ATTRIBUTE, "drawRecord" } },
+        { { 0, "fragColor" }, { 1, "fragObject" } })) {
+        return false;
+    }
+    if (!flatProgram.build("Flat", FLAT_VERTEX_SHADER, FLAT_FRAGMENT_SHADER,
+        { { POSITION_ATTRIBUTE, "position" } }, { { 0, "fragColor" } })) {
+        return false;
+    }
+    if (!gridProgram.build("Grid", GRID_VERTEX_SHADER, GRID_FRAGMENT_SHADER, {}, { { 0, "fragColor" } })) {
+        return false;
+    }
+
+    for (const ShaderProgram* program : { &unlitProgram, &flatProgram }) {
+        glUniformBlockBinding(program->getId(), glGetUniformBlockIndex(program->getId(), "Camera"), CAMERA_BINDING);
+    }
+
+    // Samplers never change unit, they're set once
+    unlitProgram.use();
+    glUniform1i(unlitProgram.uniform("diffuse"), 0);
+    glUniform1i(unlitProgram.uniform("objectRecords"), OBJECT_TEXTURE_UNIT);
+    glUniform1i(unlitProgram.uniform("objectIds"), ID_TEXTURE_UNIT);
+    objectIndexLocation = unlitProgram.uniform("objectIndex");
+    texturedLocation = unlitProgram.uniform("textured");
+    indirectLocation = unlitProgram.uniform("indirect");
+    indirectMode = false;
+
+    modelLocation = flatProgram.uniform("model");
+    colorLocation = flatProgram.uniform("color");
+
+    gridInverseLocation = gridProgram.uniform("inverseViewProjection");
+    gridViewProjectionLocation = gridProgram.uniform("viewProjection");
+    gridCameraLocation = gridProgram.uniform("cameraPosition");
+    gridSpacingLocation = gridProgram.uniform("spacing");
+    gridBlendLocation = gridProgram.uniform("blend");
+    gridColorLocation = gridProgram.uniform("color");
+    glGenVertexArrays(1, &gridArray);
+    glUseProgram(0);
+    return true;
+}
+
+void RenderPipeline::createCube() {
+    std::vector<glm::vec3> vertices;
+    vertices.reserve(CUBE_TRIANGLE_VERTICES);
+
+    // Two triangles per face, the corner's bit 'axis' fixed to the face's side
+    for (int axis = 0; axis < 3; axis++) {
+        const int u = 1 << ((axis + 1) % 3);
+        const int v = 1 << ((axis + 2) % 3);
+        for (int side = 0; side < 2; side++) {
+            const int base = side << axis;
+            const int quad[6] = { base, base | u, base | u | v, base, base | u | v, base | v };
+            for (int corner : quad) {
+                vertices.push_back(cubeCorner(corner));
+            }
+        }
+    }
+
+    glGenVertexArrays(1, &cubeArray);
+    glBindVertexArray(cubeArray);
+    glGenBuffers(1, &cubeBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, cubeBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(POSITION_ATTRIBUTE);
+    glVertexAttribPointer(POSITION_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void RenderPipeline::release() {
+    unlitProgram.release();
+    flatProgram.release();
+    gridProgram.release();
+
+    const GLuint buffers[4] = { cameraBuffer, objectBuffer, idBuffer, cubeBuffer };
+    glDeleteBuffers(4, buffers);
+    const GLuint textures[2] = { objectTexture, idTexture };
+    glDeleteTextures(2, textures);
+    const GLuint arrays[2] = { gridArray, cubeArray };
+    glDeleteVertexArrays(2, arrays);
+
+    cameraBuffer = objectBuffer = idBuffer = cubeBuffer = 0;
+    objectTexture = idTexture = 0;
+    gridArray = cubeArray = 0;
+    available = false;
+}
+
+void RenderPipeline::beginFrame(const glm::mat4& projection, const glm::mat4& view) {
+    stats = RenderPipelineStats();
+    currentProgram = 0;
+
+    const CameraBlock camera = { projection, view, projection * view };
+    glBindBuffer(GL_UNIFORM_BUFFER, cameraBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(camera), &camera, GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BINDING, cameraBuffer);
+    stats.uploadedBytes += sizeof(camera);
+
+    objectRecords.clear();
+    objectIds.clear();
+
+    // Mesh vertex arrays leave the slot disabled, it then reads this constant
+    glVertexAttrib1f(BATCH_SLOT_ATTRIBUTE, 0.0f);
+}
+
+GLint RenderPipeline::addObject(Entity entity, const glm::mat4& world, const glm::vec3& tint) {
+    if (entity.index >= recordOf.size()) {
+        recordOf.resize(entity.index + 1, 0);
+    }
+    const uint32_t record = static_cast<uint32_t>(objectIds.size() / 2);
+    recordOf[entity.index] = record;
+
+    for (int column = 0; column < 4; column++) {
+        objectRecords.push_back(world[column]);
+    }
+    objectRecords.push_back(glm::vec4(tint, 1.0f));
+
+    // Index + 1 so that 0 means background, as the picking buffer expects
+    objectIds.push_back(entity.index + 1);
+    objectIds.push_back(entity.generation);
+    return static_cast<GLint>(record);
+}
+
+bool RenderPipeline::uploadObjects() {
+    stats.objects = objectIds.size() / 2;
+    if (objectRecords.size() > static_cast<size_t>(maxTexels)) {
+        if (!overflowReported) {
+            console.addLog("Too many objects for the shader pipeline (" + std::to_string(stats.objects) + "), drawing with the fixed pipeline");
+            overflowReported = true;
+        }
+        return false;
+    }
+    overflowReported = false;
+
+    // Orphaned every frame so the driver never waits for last frame's draws to read the old records
+    if (!objectRecords.empty()) {
+        const size_t recordBytes = objectRecords.size() * sizeof(glm::vec4);
+        const size_t idBytes = objectIds.size() * sizeof(GLuint);
+        glBindBuffer(GL_TEXTURE_BUFFER, objectBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, recordBytes, nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, recordBytes, objectRecords.data());
+        glBindBuffer(GL_TEXTURE_BUFFER, idBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, idBytes, nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, idBytes, objectIds.data());
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        stats.uploadedBytes += recordBytes + idBytes;
+    }
+
+    glActiveTexture(GL_TEXTURE0 + OBJECT_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, objectTexture);
+    glActiveTexture(GL_TEXTURE0 + ID_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, idTexture);
+    glActiveTexture(GL_TEXTURE0);
+    return true;
+}
+
+void RenderPipeline::endFrame() {
+    glUseProgram(0);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    currentProgram = 0;
+}
+
+void RenderPipeline::useProgram(const ShaderProgram& program) {
+    if (currentProgram == program.getId()) return;
+    program.use();
+    currentProgram = program.getId();
+}
+
+void RenderPipeline::useUnlit(bool indirect) {
+    useProgram(unlitProgram);
+    if (indirect != indirectMode) {
+        glUniform1i(indirectLocation, indirect ? 1 : 0);
+        indirectMode = indirect;
+    }
+}
+
+void RenderPipeline::drawGrid(const glm::mat4& projection, const glm::mat4& view, float spacing, const glm::vec3& color) {
+    const glm::mat4 viewProjection = projection * view;
+    const glm::vec3 cameraPosition = glm::vec3(glm::inverse(view)[3]);
+
+    const float height = std::max(std::abs(cameraPosition.y), GRID_LEVEL_HEIGHT);
+    const float level = std::log10(height / GRID_LEVEL_HEIGHT);
+    const float levelSpacing = spacing * std::pow(10.0f, std::floor(level));
+
+    useProgram(gridProgram);
+    glUniformMatrix4fv(gridInverseLocation, 1, GL_FALSE, glm::value_ptr(glm::inverse(viewProjection)));
+    glUniformMatrix4fv(gridViewProjectionLocation, 1, GL_FALSE, glm::value_ptr(viewProjection));
+    glUniform3fv(gridCameraLocation, 1, glm::value_ptr(cameraPosition));
+    glUniform1f(gridSpacingLocation, levelSpacing);
+    glUniform1f(gridBlendLocation, level - std::floor(level));
+    glUniform3fv(gridColorLocation, 1, glm::value_ptr(color));
+
+    // Tested against the scene but never hiding it, faded lines blend over whatever is behind
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+    glBindVertexArray(gridArray);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+    stats.drawCalls++;
+}
+
+void RenderPipeline::setTexture(GLuint texture) {
+    useProgram(unlitProgram);
+    glUniform1i(texturedLocation, texture != 0 ? 1 : 0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void RenderPipeline::drawMesh(Entity entity, const GpuMesh& mesh, GLsizei instances) {
+    useUnlit(false);
+    glUniform1i(objectIndexLocation, static_cast<GLint>(recordOf[entity.index]));
+
+    mesh.drawTriangles(instances);
+    stats.drawCalls++;
+    stats.meshes += instances;
+    if (instances > 1) {
+        stats.instancedDraws++;
+    }
+}
+
+void RenderPipeline::drawRanges(GLint firstRecord, GLuint vertexArray, const GLsizei* counts, const void* const* offsets, GLsizei rangeCount, size_t objects) {
+    useUnlit(false);
+    glUniform1i(objectIndexLocation, firstRecord);
+
+    glBindVertexArray(vertexArray);
+    glMultiDrawElements(GL_TRIANGLES, counts, GL_UNSIGNED_INT, offsets, rangeCount);
+    stats.drawCalls++;
+    stats.meshes += objects;
+}
+
+void RenderPipeline::drawIndirect(GLuint vertexArray, size_t offset, GLsizei drawCount, size_t objects) {
+    useUnlit(true);
+    glBindVertexArray(vertexArray);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, reinterpret_cast<const void*>(offset), drawCount, 0);
+    stats.drawCalls++;
+    stats.meshes += objects;
+}
+
+void RenderPipeline::drawBox(const AABB& box) {
+    // Color writes are off for proxies, only the depth test matters
+    drawFlat(cubeArray, GL_TRIANGLES, 0, CUBE_TRIANGLE_VERTICES, boxMatrix(box), glm::vec3(1.0f));
+}
+
+void RenderPipeline::drawFlat(GLuint vertexArray, GLenum mode, GLint first, GLsizei count, const glm::mat4& model, const glm::vec3& color) {
+    useProgram(flatProgram);
+    glUniformMatrix4fv(modelLocation, 1, GL_FALSE, glm::value_ptr(model));
+    glUniform3fv(colorLocation, 1, glm::value_ptr(color));
+
+    glBindVertexArray(vertexArray);
+    glDrawArrays(mode, first, count);
+    stats.drawCalls++;
+}
@@ -0,0 +1,132 @@
+#ifndef RENDERPIPELINE_H
+#define RENDERPIPELINE_H
+
+#include <cstddef>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "ECS.h"
+#include "Bounds.h"
+#include "ShaderProgram.h"
+
+class GpuMesh;
+
+struct RenderPipelineStats {
+    size_t objects = 0;             // Object records uploaded this frame
+    size_t drawCalls = 0;           // Meshes, overlays and the grid drawn through the shaders
+    size_t meshes = 0;              // Objects drawn, instances included
+    size_t instancedDraws = 0;      // Draws covering more than one object
+    size_t uploadedBytes = 0;       // Camera block and object records sent this frame
+};
+
+// Scene drawing with GLSL instead of the fixed pipeline. The camera matrices come from a uniform block
+// filled once per frame, every object's world matrix, tint and picking ID from texture buffers filled
+// once per frame too, so a mesh draw only sets the object's index, and objects with consecutive records
+// sharing a mesh and texture are instances of one draw. Two programs, compiled at startup:
+// an unlit material, textured or not, that also writes the picking ID, and a flat color one for
+// occlusion proxies. The grid has a program of its own, selection overlays go through DebugDraw.
+// Needs GL 3.1 for the uniform block and texture buffers, below that the fixed pipeline keeps drawing.
+class RenderPipeline {
+public:
+    static RenderPipeline renderPipeline;
+
+    // Attribute locations of GpuMesh vertex arrays
+    static const GLuint POSITION_ATTRIBUTE = 0;
+    static const GLuint TEXCOORD_ATTRIBUTE = 1;
+    // Static batches: the object's slot in the batch, added to the batch's first record
+    static const GLuint BATCH_SLOT_ATTRIBUTE = 2;
+    // Indirect draws: the object's record, one value per instance from the base instance on
+    static const GLuint DRAW_RECORD_ATTRIBUTE = 3;
+
+    void init();
+    // Deletes programs and buffers, the GL context must still be current
+    void release();
+    bool isActive() const { return enabled && available; }
+    // The programs built, even if the scene is drawn with the fixed pipeline
+    bool isAvailable() const { return available; }
+
+    // Frame setup: camera block first, then every object to draw, then the upload
+    void beginFrame(const glm::mat4& projection, const glm::mat4& view);
+    // Returns the object's record, consecutive calls get consecutive records
+    GLint addObject(Entity entity, const glm::mat4& world, const glm::vec3& tint);
+    GLint getRecord(Entity entity) const { return static_cast<GLint>(recordOf[entity.index]); }
+    // False when the records don't fit in a texture buffer, this frame then uses the fixed pipeline
+    bool uploadObjects();
+    // Back to program 0, no vertex array and no texture, for fixed pipeline or ImGui drawing afterwards
+    void endFrame();
+
+    // Ground plane grid as one full screen triangle, lines computed per pixel, blended over what's drawn.
+    // Takes its own matrices so the fixed pipeline can use it too.
+    void drawGrid(const glm::mat4& projection, const glm::mat4& view, float spacing, const glm::vec3& color);
+    // Material texture, only set when it differs from the previous draw's
+    void setTexture(GLuint texture);
+    // Draws the bound mesh with the object's record. With several instances, the objects whose records
+    // follow the entity's are drawn in the same call.
+    void drawMesh(Entity entity, const GpuMesh& mesh, GLsizei instances = 1);
+    // Index ranges of a static batch, each vertex picks its record from firstRecord and its slot
+    void drawRanges(GLint firstRecord, GLuint vertexArray, const GLsizei* counts, const void* const* offsets, GLsizei rangeCount, size_t objects);
+    // Commands of the bound indirect buffer from 'offset' on, each with its first record as base instance
+    void drawIndirect(GLuint vertexArray, size_t offset, GLsizei drawCount, size_t objects);
+    // Occlusion proxy, a solid box in world space
+    void drawBox(const AABB& box);
+
+    const RenderPipelineStats& getStats() const { return stats; }
+
+    bool enabled = true;
+    // Objects sharing mesh and texture in the render queue are drawn with one instanced call
+    bool instancing = true;
+
+private:
+    // World matrix columns then the tint
+    static const int TEXELS_PER_OBJECT = 5;
+
+    ShaderProgram unlitProgram;
+    GLint objectIndexLocation = -1;
+    GLint texturedLocation = -1;
+    GLint indirectLocation = -1;
+    bool indirectMode = false;
+
+    ShaderProgram flatProgram;
+    GLint modelLocation = -1;
+    GLint colorLocation = -1;
+
+    GLuint cameraBuffer = 0;
+    GLuint objectBuffer = 0;
+    GLuint objectTexture = 0;
+    GLuint idBuffer = 0;
+    GLuint idTexture = 0;
+    GLint maxTexels = 0;
+
+    ShaderProgram gridProgram;
+    GLint gridInverseLocation = -1;
+    GLint gridViewProjectionLocation = -1;
+    GLint gridCameraLocation = -1;
+    GLint gridSpacingLocation = -1;
+    GLint gridBlendLocation = -1;
+    GLint gridColorLocation = -1;
+    // No attributes, the vertex shader places the triangle from gl_VertexID
+    GLuint gridArray = 0;
+
+    // Unit cube as triangles, for occlusion proxies
+    GLuint cubeArray = 0;
+    GLuint cubeBuffer = 0;
+
+    bool available = false;
+    bool overflowReported = false;
+    GLuint currentProgram = 0;
+
+    std::vector<glm::vec4> objectRecords;
+    std::vector<GLuint> objectIds;
+    // Record of each entity drawn this frame, by entity index
+    std::vector<uint32_t> recordOf;
+
+    RenderPipelineStats stats;
+
+    bool createPrograms();
+    void createCube();
+    void useProgram(const ShaderProgram& program);
+    void useUnlit(bool indirect);
+    void drawFlat(GLuint vertexArray, GLenum mode, GLint first, GLsizei count, const glm::mat4& model, const glm::vec3& color);
+};
+
+#endif // RENDERPIPELINE_H
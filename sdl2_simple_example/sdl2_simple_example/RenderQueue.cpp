@@ -0,0 +1,116 @@
+#include "RenderQueue.h"
+#include "GpuMesh.h"
+#include <algorithm>
+#include <chrono>
+
+RenderQueue RenderQueue::renderQueue;
+
+namespace {
+    using queueClock = std::chrono::high_resolution_clock;
+
+    const int PASS_SHIFT = 60;
+    const int TEXTURE_SHIFT = 44;
+    const int MESH_SHIFT = 24;
+
+    const uint64_t TEXTURE_MASK = (uint64_t(1) << 16) - 1;
+    const uint64_t MESH_MASK = (uint64_t(1) << 20) - 1;
+    const uint64_t DEPTH_MASK = (uint64_t(1) << 24) - 1;
+
+    const int RADIX_BITS = 8;
+    const size_t RADIX_BUCKETS = size_t(1) << RADIX_BITS;
+}
+
+void RenderQueue::clear() {
+    packets.clear();
+    stats = RenderQueueStats();
+    invalidate();
+}
+
+void RenderQueue::push(RenderPass pass, GLuint texture, const GpuMesh& mesh, float viewDepth, Entity entity) {
+    // GL names are small integers, masking them keeps equal ones together. Two names sharing their
+    // low bits only cost a redundant bind, setTexture/setMesh compare the full values.
+    const float depth = std::min(std::max(viewDepth, 0.0f), MAX_DEPTH) / MAX_DEPTH;
+
+    DrawPacket packet;
+    packet.key = (uint64_t(pass) << PASS_SHIFT)
+        | ((uint64_t(texture) & TEXTURE_MASK) << TEXTURE_SHIFT)
+        | ((uint64_t(mesh.getVertexArray()) & MESH_MASK) << MESH_SHIFT)
+        | static_cast<uint64_t>(depth * DEPTH_MASK);
+    packet.entity = entity;
+    packet.texture = texture;
+    packet.mesh = &mesh;
+    packets.push_back(packet);
+}
+
+void RenderQueue::sort() {
+    stats.packets = packets.size();
+    if (!enabled || packets.size() < 2) return;
+
+    const auto start = queueClock::now();
+
+    // Least significant digit first, each pass stable, so the last one leaves the keys fully ordered.
+    // Digits that every key shares, such as the unused pass bits, are skipped.
+    scratch.resize(packets.size());
+    std::vector<DrawPacket>* from = &packets;
+    std::vector<DrawPacket>* to = &scratch;
+
+    for (int shift = 0; shift < 64; shift += RADIX_BITS) {
+        size_t offsets[RADIX_BUCKETS] = {};
+        for (const DrawPacket& packet : *from) {
+            offsets[(packet.key >> shift) & (RADIX_BUCKETS - 1)]++;
+        }
+        if (offsets[(from->front().key >> shift) & (RADIX_BUCKETS - 1)] == from->size()) continue;
+
+        size_t offset = 0;
+        for (size_t& bucket : offsets) {
+            const size_t count = bucket;
+            bucket = offset;
+            offset += count;
+        }
+        for (const DrawPacket& packet : *from) {
+            (*to)[offsets[(packet.key >> shift) & (RADIX_BUCKETS - 1)]++] = packet;
+        }
+        std::swap(from, to);
+    }
+    if (from != &packets) {
+        packets.swap(scratch);
+    }
+
+    stats.sortMs = std::chrono::duration<double, std::milli>(queueClock::now() - start).count();
+}
+
+size_t RenderQueue::batchLength(size_t first) const {
+    const DrawPacket& head = packets[first];
+    size_t last = first + 1;
+    while (last < packets.size() && packets[last].texture == head.texture && packets[last].mesh == head.mesh
+        && (packets[last].key >> PASS_SHIFT) == (head.key >> PASS_SHIFT)) {
+        last++;
+    }
+    return last - first;
+}
+
+bool RenderQueue::setTexture(GLuint texture) {
+    if (textureKnown && texture == currentTexture) {
+        stats.bindsAvoided++;
+        return false;
+    }
+    currentTexture = texture;
+    textureKnown = true;
+    stats.textureBinds++;
+    return true;
+}
+
+bool RenderQueue::setMesh(const GpuMesh& mesh) {
+    if (&mesh == currentMesh) {
+        stats.bindsAvoided++;
+        return false;
+    }
+    currentMesh = &mesh;
+    stats.meshBinds++;
+    return true;
+}
+
+void RenderQueue::invalidate() {
+    currentMesh = nullptr;
+    textureKnown = false;
+}
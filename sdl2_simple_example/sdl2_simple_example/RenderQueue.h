@@ -0,0 +1,72 @@
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <GL/glew.h>
+#include "ECS.h"
+
+class GpuMesh;
+
+// Passes draw in this order, whatever their other key fields
+enum class RenderPass : uint8_t {
+    Opaque = 0,
+};
+
+struct DrawPacket {
+    uint64_t key = 0;
+    Entity entity;
+    GLuint texture = 0;
+    const GpuMesh* mesh = nullptr;
+};
+
+struct RenderQueueStats {
+    size_t packets = 0;             // Draws queued this frame
+    size_t textureBinds = 0;        // Texture changes during submission
+    size_t meshBinds = 0;           // Vertex array changes during submission
+    size_t bindsAvoided = 0;        // Binds skipped because the previous draw had them already
+    double sortMs = 0.0;
+};
+
+// This frame's draws as packets with a 64 bit sort key, high bits first:
+//   pass (4) | texture (16) | mesh vertex array (20) | view depth (24)
+// so a radix sort groups draws by texture, then by mesh, and orders each group front to back to cut overdraw.
+// Submission goes through setTexture/setMesh, which only ask for a GL bind when the value changed.
+class RenderQueue {
+public:
+    static RenderQueue renderQueue;
+
+    // Depths past this are all sorted as the farthest
+    static constexpr float MAX_DEPTH = 100.0f;
+
+    void clear();
+    void push(RenderPass pass, GLuint texture, const GpuMesh& mesh, float viewDepth, Entity entity);
+    // Radix sort on the keys, the queue keeps the push order when sorting is disabled
+    void sort();
+    const std::vector<DrawPacket>& getPackets() const { return packets; }
+    // Packets from 'first' on with the same pass, texture and mesh, which can share one instanced draw
+    size_t batchLength(size_t first) const;
+
+    // Submission state: true when the caller has to bind, false when the last draw left it bound
+    bool setTexture(GLuint texture);
+    bool setMesh(const GpuMesh& mesh);
+    // Something outside the queue changed the bindings, such as overlays or occlusion proxies
+    void invalidate();
+
+    const RenderQueueStats& getStats() const { return stats; }
+
+    bool enabled = true;
+
+private:
+    std::vector<DrawPacket> packets;
+    std::vector<DrawPacket> scratch;
+
+    GLuint currentTexture = 0;
+    const GpuMesh* currentMesh = nullptr;
+    bool textureKnown = false;
+
+    RenderQueueStats stats;
+};
+
+#endif // RENDERQUEUE_H
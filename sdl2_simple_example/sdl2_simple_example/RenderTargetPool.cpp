@@ -0,0 +1,217 @@
+#include "RenderTargetPool.h"
+#include "ConsoleWindow.h"
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+RenderTargetPool RenderTargetPool::renderTargetPool;
+
+namespace {
+    // Pixel transfer format matching an internal color format, nothing is uploaded but GL still checks it
+    void transferFormat(GLenum colorFormat, GLenum& format, GLenum& type) {
+        switch (colorFormat) {
+        case GL_RGB8:
+        case GL_RGB:
+            format = GL_RGB;
+            type = GL_UNSIGNED_BYTE;
+            break;
+        case GL_RGBA16F:
+        case GL_RGBA32F:
+        case GL_RGB16F:
+        case GL_R32F:
+            format = colorFormat == GL_RGB16F ? GL_RGB : colorFormat == GL_R32F ? GL_RED : GL_RGBA;
+            type = GL_FLOAT;
+            break;
+        case GL_R32UI:
+            format = GL_RED_INTEGER;
+            type = GL_UNSIGNED_INT;
+            break;
+        case GL_RG32UI:
+            format = GL_RG_INTEGER;
+            type = GL_UNSIGNED_INT;
+            break;
+        default:
+            format = GL_RGBA;
+            type = GL_UNSIGNED_BYTE;
+            break;
+        }
+    }
+
+    size_t bytesPerPixel(GLenum colorFormat) {
+        switch (colorFormat) {
+        case GL_RGBA16F:
+        case GL_RGB16F:
+        case GL_RG32UI:
+            return 8;
+        case GL_RGBA32F:
+            return 16;
+        default:
+            return 4;
+        }
+    }
+}
+
+// 25% over the size, then up to the next step
+int RenderTargetPool::bucket(int size) {
+    const int withSlack = static_cast<int>(std::ceil(std::max(size, 1) * 1.25f));
+    return (withSlack + SIZE_STEP - 1) / SIZE_STEP * SIZE_STEP;
+}
+
+bool RenderTargetPool::setSceneSize(int width, int height) {
+    width = std::max(width, 1);
+    height = std::max(height, 1);
+
+    if (width != requestedWidth || height != requestedHeight) {
+        requestedWidth = width;
+        requestedHeight = height;
+        settledFrames = 0;
+    }
+    else {
+        settledFrames++;
+    }
+
+    // Too small, or more than twice the area a fresh allocation would take
+    const bool fits = scene.framebuffer != 0 && width <= scene.width && height <= scene.height;
+    const bool oversized = fits && static_cast<size_t>(scene.width) * scene.height > 2 * static_cast<size_t>(bucket(width)) * bucket(height);
+
+    bool reallocated = false;
+    if (scene.framebuffer == 0 || ((!fits || oversized) && settledFrames >= SETTLE_FRAMES)) {
+        stats.residentBytes -= bytesOf(scene);
+        destroy(scene);
+        create(scene, bucket(width), bucket(height), GL_RGB8, true);
+        stats.residentBytes += bytesOf(scene);
+        reallocated = true;
+    }
+
+    // Uniformly scaled down while the target is too small, the image keeps the window's aspect
+    const float scale = std::min(1.0f, std::min(static_cast<float>(scene.width) / width, static_cast<float>(scene.height) / height));
+    if (scale < 1.0f) {
+        stats.deferredFrames++;
+    }
+    viewportWidth = std::max(1, static_cast<int>(width * scale));
+    viewportHeight = std::max(1, static_cast<int>(height * scale));
+    return reallocated;
+}
+
+const RenderTarget* RenderTargetPool::acquire(int width, int height, GLenum colorFormat, bool depth) {
+    // The smallest free target it fits in, as long as it isn't more than twice the area it needs
+    PooledTarget* best = nullptr;
+    const size_t maxArea = 2 * static_cast<size_t>(bucket(width)) * bucket(height);
+    for (const std::unique_ptr<PooledTarget>& pooled : pool) {
+        const RenderTarget& target = pooled->target;
+        if (pooled->inUse || target.colorFormat != colorFormat || target.depth != depth) continue;
+        if (target.width < width || target.height < height) continue;
+
+        const size_t area = static_cast<size_t>(target.width) * target.height;
+        if (area > maxArea) continue;
+        if (!best || area < static_cast<size_t>(best->target.width) * best->target.height) {
+            best = pooled.get();
+        }
+    }
+
+    if (!best) {
+        std::unique_ptr<PooledTarget> pooled = std::make_unique<PooledTarget>();
+        if (!create(pooled->target, bucket(width), bucket(height), colorFormat, depth)) {
+            destroy(pooled->target);
+            return nullptr;
+        }
+        stats.residentBytes += bytesOf(pooled->target);
+        best = pooled.get();
+        pool.push_back(std::move(pooled));
+    }
+
+    best->inUse = true;
+    best->lastUsedFrame = frame;
+    return &best->target;
+}
+
+void RenderTargetPool::release(const RenderTarget* target) {
+    for (const std::unique_ptr<PooledTarget>& pooled : pool) {
+        if (&pooled->target == target) {
+            pooled->inUse = false;
+            pooled->lastUsedFrame = frame;
+            return;
+        }
+    }
+}
+
+void RenderTargetPool::endFrame() {
+    frame++;
+
+    stats.inUse = 0;
+    for (size_t i = 0; i < pool.size();) {
+        PooledTarget& pooled = *pool[i];
+        if (!pooled.inUse && frame - pooled.lastUsedFrame > IDLE_FRAMES) {
+            stats.residentBytes -= bytesOf(pooled.target);
+            destroy(pooled.target);
+            pool[i] = std::move(pool.back());
+            pool.pop_back();
+            continue;
+        }
+        stats.inUse += pooled.inUse ? 1 : 0;
+        i++;
+    }
+    stats.pooled = pool.size();
+}
+
+void RenderTargetPool::releaseAll() {
+    destroy(scene);
+    for (const std::unique_ptr<PooledTarget>& pooled : pool) {
+        destroy(pooled->target);
+    }
+    pool.clear();
+    requestedWidth = requestedHeight = 0;
+    stats.pooled = stats.inUse = 0;
+    stats.residentBytes = 0;
+}
+
+bool RenderTargetPool::create(RenderTarget& target, int width, int height, GLenum colorFormat, bool depth) {
+    target.width = width;
+    target.height = height;
+    target.colorFormat = colorFormat;
+    target.depth = depth;
+
+    glGenFramebuffers(1, &target.framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+
+    GLenum format, type;
+    transferFormat(colorFormat, format, type);
+    glGenTextures(1, &target.colorTexture);
+    glBindTexture(GL_TEXTURE_2D, target.colorTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, colorFormat, width, height, 0, format, type, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.colorTexture, 0);
+
+    if (depth) {
+        glGenRenderbuffers(1, &target.depthBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, target.depthBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, target.depthBuffer);
+    }
+
+    const bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (!complete) {
+        console.addLog("ERROR::FRAMEBUFFER:: Render target " + std::to_string(width) + "x" + std::to_string(height) + " is not complete!");
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    stats.allocations++;
+    return complete;
+}
+
+void RenderTargetPool::destroy(RenderTarget& target) {
+    glDeleteFramebuffers(1, &target.framebuffer);
+    glDeleteTextures(1, &target.colorTexture);
+    glDeleteRenderbuffers(1, &target.depthBuffer);
+    target.framebuffer = target.colorTexture = target.depthBuffer = 0;
+    target.width = target.height = 0;
+}
+
+size_t RenderTargetPool::bytesOf(const RenderTarget& target) {
+    const size_t pixels = static_cast<size_t>(target.width) * target.height;
+    return pixels * (bytesPerPixel(target.colorFormat) + (target.depth ? 4 : 0));
+}
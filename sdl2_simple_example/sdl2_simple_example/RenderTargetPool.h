@@ -0,0 +1,88 @@
+#ifndef RENDERTARGETPOOL_H
+#define RENDERTARGETPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <GL/glew.h>
+
+// A framebuffer with a color texture and, optionally, a depth and stencil renderbuffer.
+// Passes draw into a viewport inside it, the allocation is usually larger than what they need.
+struct RenderTarget {
+    GLuint framebuffer = 0;
+    GLuint colorTexture = 0;
+    GLuint depthBuffer = 0;
+    int width = 0;
+    int height = 0;
+    GLenum colorFormat = GL_RGB8;
+    bool depth = true;
+};
+
+struct RenderTargetStats {
+    size_t allocations = 0;         // Targets created since startup, the scene's included
+    size_t deferredFrames = 0;      // Frames drawn scaled down while the scene's new size settles
+    size_t pooled = 0;              // Transient targets alive, in use or not
+    size_t inUse = 0;
+    size_t residentBytes = 0;       // Every target, the scene's included
+};
+
+// Owns the scene's render target and a pool of transient ones for other passes.
+// Sizes are rounded up with 25% slack to a multiple of 64 pixels, so small changes fit in what's already
+// allocated and only the viewport moves. When the scene window outgrows its target, or shrinks far below
+// it, the target is reallocated once the new size has held for a few frames; until then the scene is
+// drawn scaled down inside the old target, with the window's aspect, and stretched to the window.
+class RenderTargetPool {
+public:
+    static RenderTargetPool renderTargetPool;
+
+    static const int SIZE_STEP = 64;
+    static const int SETTLE_FRAMES = 10;    // Frames a new scene size must hold before reallocating
+    static const int IDLE_FRAMES = 120;     // Frames a released transient target is kept for reuse
+
+    // The scene window's size, every frame. True when the scene target was reallocated, its framebuffer,
+    // texture and depth buffer are then new.
+    bool setSceneSize(int width, int height);
+    const RenderTarget& getSceneTarget() const { return scene; }
+    // The part of the scene target drawn this frame, from its bottom left corner
+    int getViewportWidth() const { return viewportWidth; }
+    int getViewportHeight() const { return viewportHeight; }
+
+    // A free pooled target at least this large, or a new one. Released targets are reused by later
+    // acquires of the same formats, and deleted after IDLE_FRAMES without use.
+    const RenderTarget* acquire(int width, int height, GLenum colorFormat = GL_RGB8, bool depth = true);
+    void release(const RenderTarget* target);
+
+    // Ages the pool, once per frame
+    void endFrame();
+    // Deletes every target, the GL context must still be current
+    void releaseAll();
+
+    const RenderTargetStats& getStats() const { return stats; }
+
+private:
+    struct PooledTarget {
+        RenderTarget target;
+        bool inUse = false;
+        uint32_t lastUsedFrame = 0;
+    };
+
+    RenderTarget scene;
+    int requestedWidth = 0;
+    int requestedHeight = 0;
+    int settledFrames = 0;
+    int viewportWidth = 1;
+    int viewportHeight = 1;
+
+    std::vector<std::unique_ptr<PooledTarget>> pool;
+    uint32_t frame = 0;
+
+    RenderTargetStats stats;
+
+    static int bucket(int size);
+    bool create(RenderTarget& target, int width, int height, GLenum colorFormat, bool depth);
+    void destroy(RenderTarget& target);
+    static size_t bytesOf(const RenderTarget& target);
+};
+
+#endif // RENDERTARGETPOOL_H
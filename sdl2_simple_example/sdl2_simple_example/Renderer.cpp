@@ -1,6 +1,8 @@
 #include "Renderer.h"
 #include <iostream>
+#include <chrono>
 #include <filesystem>
+#include <stdexcept>
 #include <GL/glew.h>
 #include <SDL2/SDL_events.h>
 #include "imgui_impl_sdl2.h"
@@ -10,6 +12,17 @@
 #include "Variables.h"
 #include "ConsoleWindow.h"
 #include "SceneWindow.h"
+#include "CullingSystem.h"
+#include "OcclusionCuller.h"
+#include "OcclusionQueries.h"
+#include "PickingBuffer.h"
+#include "GpuMesh.h"
+#include "RenderPipeline.h"
+#include "RenderQueue.h"
+#include "StaticBatcher.h"
+#include "IndirectRenderer.h"
+#include "DebugDraw.h"
+#include "RenderTargetPool.h"
 
 extern Camera camera;
 extern Importer importer;
@@ -31,44 +44,46 @@ std::string Renderer::getFileName(const std::string& path) {
 
 //Initialises LWE and configures OpenGL for deep rendering
 void Renderer::initOpenGL() {
-    glewInit();
-    if (!GLEW_VERSION_3_0) throw std::exception("OpenGL 3.0 API is not available.");
+    // A GLEW built for GLX also wants a GLX display, which contexts made through EGL (SDL's offscreen driver)
+    // don't have. It has loaded the GL functions by then, so that error alone is let through.
+    const GLenum glewStatus = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    const bool glewLoaded = glewStatus == GLEW_OK || glewStatus == GLEW_ERROR_NO_GLX_DISPLAY;
+#else
+    const bool glewLoaded = glewStatus == GLEW_OK;
+#endif
+    if (!glewLoaded) throw std::runtime_error(std::string("GLEW could not be initialized: ") + reinterpret_cast<const char*>(glewGetErrorString(glewStatus)));
+    if (!GLEW_VERSION_3_0) throw std::runtime_error("OpenGL 3.0 API is not available.");
     glEnable(GL_DEPTH_TEST);
     glClearColor(0.5, 0.5, 0.5, 1.0);
-}
-
-void Renderer::createFrameBuffer(int width, int height) {
-    framebufferWidth = width;
-    framebufferHeight = height;
-
-    // Removy any previous framebuffers before creating a new one
-    if (framebuffer != 0) {
-        cleanupFrameBuffer();
-    }
-
-    glGenFramebuffers(1, &framebuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-
-    glGenTextures(1, &textureColorbuffer);
-    glBindTexture(GL_TEXTURE_2D, textureColorbuffer);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureColorbuffer, 0);
 
-    glGenRenderbuffers(1, &rbo);
-    glBindRenderbuffer(GL_RENDERBUFFER, rbo);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo);
+    // Shaders are built once here, the fixed pipeline stays as the fallback
+    RenderPipeline::renderPipeline.init();
+    IndirectRenderer::indirectRenderer.init();
+    DebugDraw::debugDraw.init();
+}
 
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
-        console.addLog("ERROR::FRAMEBUFFER:: Framebuffer is not complete!");
+// The scene target comes from the pool, which only reallocates it once a new size has settled.
+// framebufferWidth and framebufferHeight are the part of it drawn into.
+void Renderer::updateFrameBuffer(int width, int height) {
+    RenderTargetPool& targets = RenderTargetPool::renderTargetPool;
+    if (targets.setSceneSize(width, height)) {
+        const RenderTarget& scene = targets.getSceneTarget();
+        framebuffer = scene.framebuffer;
+        textureColorbuffer = scene.colorTexture;
+        rbo = scene.depthBuffer;
+
+        PickingBuffer& picking = PickingBuffer::pickingBuffer;
+        picking.detach();
+        picking.attach(framebuffer, textureColorbuffer, rbo, scene.width, scene.height);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    framebufferWidth = targets.getViewportWidth();
+    framebufferHeight = targets.getViewportHeight();
 }
 
 // Processes SDL events and user actions
-bool Renderer::processEvents(Camera& camera, std::vector<GameObject>& gameObjects, const char*& droppedFilePath) {
+bool Renderer::processEvents(Camera& camera, std::vector<GameObject*>& gameObjects, const char*& droppedFilePath) {
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
         ImGui_ImplSDL2_ProcessEvent(&event);
@@ -134,7 +149,7 @@ void Renderer::HandleDroppedFile(const char* droppedFile) {
 
             for (size_t i = 0; i < meshes.size(); ++i) {
                 const std::string objectName = getFileName(filePath.string()) + "_" + std::to_string(i);
-                GameObject* newObject = new GameObject(objectName, meshes[i], textureID, texturePathString);
+                GameObject* newObject = GameObjectPool::pool.create(objectName, meshes[i], textureID, texturePathString);
                 variables->window->gameObjects.push_back(newObject);
             }
 
@@ -150,7 +165,7 @@ void Renderer::HandleDroppedFile(const char* droppedFile) {
 
         for (size_t i = 0; i < meshes.size(); ++i) {
             const std::string objectName = getFileName(droppedFile) + "_" + std::to_string(i);
-            GameObject* newObject = new GameObject(objectName, meshes[i], textureID);
+            GameObject* newObject = GameObjectPool::pool.create(objectName, meshes[i], textureID);
             variables->window->gameObjects.push_back(newObject);
         }
 
@@ -174,12 +189,12 @@ void Renderer::HandleDroppedFile(const char* droppedFile) {
         std::string textureFilePath = filePath.string();
 
         if (variables->window->selectedObject) {
-            if (variables->window->selectedObject->textureID != 0) {
-                glDeleteTextures(1, &variables->window->selectedObject->textureID);
+            GLuint oldTextureID = variables->window->selectedObject->getTextureID();
+            if (oldTextureID != 0) {
+                glDeleteTextures(1, &oldTextureID);
             }
 
-            variables->window->selectedObject->textureID = newTextureID;
-            variables->window->selectedObject->texturePath = textureFilePath;
+            variables->window->selectedObject->setTexture(textureFilePath, newTextureID);
             console.addLog("Texture applied to selected object: " + textureFilePath);
         }
         else {
@@ -206,95 +221,343 @@ void Renderer::HandleDragDropTarget() {
     }
 }
 
+// Fallback for contexts without shaders, the lines are recorded once in a display list
 void Renderer::drawGrid(float spacing) {
     glDisable(GL_TEXTURE_2D);
     glColor3f(0.7f, 0.7f, 0.7f);
 
-    float gridRange = 1000.0f;
-    glBegin(GL_LINES);
+    if (gridList == 0 || spacing != gridListSpacing) {
+        if (gridList == 0) {
+            gridList = glGenLists(1);
+        }
+        glNewList(gridList, GL_COMPILE);
+
+        float gridRange = 1000.0f;
+        glBegin(GL_LINES);
 
-    for (float i = -gridRange; i <= gridRange; i += spacing) {
-        glVertex3f(i, 0, -gridRange);
-        glVertex3f(i, 0, gridRange);
-        glVertex3f(-gridRange, 0, i);
-        glVertex3f(gridRange, 0, i);
-    }
+        for (float i = -gridRange; i <= gridRange; i += spacing) {
+            glVertex3f(i, 0, -gridRange);
+            glVertex3f(i, 0, gridRange);
+            glVertex3f(-gridRange, 0, i);
+            glVertex3f(gridRange, 0, i);
+        }
 
-    glEnd();
+        glEnd();
+        glEndList();
+        gridListSpacing = spacing;
+    }
+    glCallList(gridList);
 }
 
-void Renderer::render(const std::vector<GameObject*>& gameObjects) {
+void Renderer::render() {
     glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
     glViewport(0, 0, framebufferWidth, framebufferHeight);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    gluPerspective(45.0f, static_cast<float>(framebufferWidth) / framebufferHeight, 0.1f, 100.0f);
-    glScalef(1.0f, -1.0f, 1.0f);
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
+    // Built with glm so the culling uses exactly the matrices GL draws with
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), static_cast<float>(framebufferWidth) / framebufferHeight, 0.1f, 100.0f);
+    projection = glm::scale(projection, glm::vec3(1.0f, -1.0f, 1.0f));
+    const glm::mat4 view = camera.getViewMatrix();
+    projectionMatrix = projection;
+    viewMatrix = view;
+    GpuMesh::beginFrame();
+    stats = RenderStats();
+    fixedDraws = 0;
+
+    // Resolve every world matrix in one sweep before drawing
+    TransformStore::transformStore.updateWorldMatrices();
+
+    // One frustum per frame, every world box tested in a single batch
+    const auto cullStart = std::chrono::high_resolution_clock::now();
+    CullingSystem& culling = CullingSystem::cullingSystem;
+    culling.gatherBounds();
+    culling.cull(Frustum::fromMatrix(projection * view));
+
+    // Then the objects hidden behind the biggest ones on screen
+    const std::vector<Entity>& drawList = OcclusionCuller::occlusionCuller.cull(projection * view, culling.getVisibleEntities());
+    const auto cullEnd = std::chrono::high_resolution_clock::now();
+    stats.cullMs = std::chrono::duration<double, std::milli>(cullEnd - cullStart).count();
+
+    // The headless benchmark has no editor window, and so nothing selected
+    static const Selection noSelection;
+    const Selection& selection = variables->window ? variables->window->selectedObjects : noSelection;
+    GameObject* selectedObject = variables->window ? variables->window->selectedObject : nullptr;
+
+    // Every visible object becomes a draw packet keyed on texture, mesh and depth. With shaders, their
+    // matrices, tints and IDs also go into the buffers the shaders read, filled once here.
+    RenderPipeline& pipeline = RenderPipeline::renderPipeline;
+    RenderQueue& queue = RenderQueue::renderQueue;
+    bool useShaders = pipeline.isActive();
+    if (useShaders) {
+        pipeline.beginFrame(projection, view);
+    }
+    queue.clear();
+
+    // Static objects merged into a batch skip the queue, their batch draws the visible ones in one call.
+    // Hardware queries need a draw per object, and only the shaders read the batches' slots.
+    StaticBatcher& batcher = StaticBatcher::staticBatcher;
+    batcher.update();
+    OcclusionQueries& queries = OcclusionQueries::occlusionQueries;
+    bool batching = useShaders && batcher.enabled && !queries.enabled;
+    bool selectedVisible = false;
+
+    const TransformStore& transforms = TransformStore::transformStore;
+    const auto queueEntity = [&](Entity entity) {
+        const glm::mat4& world = transforms.worldMatrices[World::world.get<TransformComponent>(entity).transformIndex];
+        const MeshRendererComponent& meshRenderer = World::world.get<MeshRendererComponent>(entity);
+
+        // Geometry stays on the GPU, only the first draw of a mesh uploads it
+        const GpuMesh& mesh = GpuMesh::of(*meshRenderer.mesh);
+        queue.push(RenderPass::Opaque, meshRenderer.textureID, mesh, -(view * world[3]).z, entity);
+    };
+    const auto trianglesOf = [](Entity entity) {
+        const MeshData& meshData = *World::world.get<MeshRendererComponent>(entity).mesh;
+        return (meshData.indices.empty() ? meshData.vertices.size() / 3 : meshData.indices.size()) / 3;
+    };
+    // Counted as submitted here, objects the hardware queries skip are taken back off below
+    stats.objectsDrawn = drawList.size();
+    for (Entity entity : drawList) {
+        stats.triangles += trianglesOf(entity);
+        selectedVisible = selectedVisible || (selectedObject && selectedObject->entity == entity);
+        if (batching && batcher.markVisible(entity)) {
+            continue;
+        }
+        queueEntity(entity);
+    }
+    queue.sort();
+
+    // Records in queue order, so a run of packets sharing mesh and texture has consecutive records.
+    // A static batch's objects follow, in slot order, with their vertices already in world space.
+    if (useShaders) {
+        for (const DrawPacket& packet : queue.getPackets()) {
+            const glm::mat4& world = transforms.worldMatrices[World::world.get<TransformComponent>(packet.entity).transformIndex];
+            pipeline.addObject(packet.entity, world, tintOf(packet.entity, selection));
+        }
+        for (StaticBatch* batch : batcher.getVisibleBatches()) {
+            for (size_t slot = 0; slot < batch->objects.size(); slot++) {
+                const GLint record = pipeline.addObject(batch->objects[slot], glm::mat4(1.0f), tintOf(batch->objects[slot], selection));
+                if (slot == 0) {
+                    batch->firstRecord = record;
+                }
+            }
+        }
+        useShaders = pipeline.uploadObjects();
+    }
 
-    camera.applyCameraTransformations();
+    // The fixed pipeline fallback draws the batched objects one by one again
+    if (batching && !useShaders) {
+        for (Entity entity : drawList) {
+            if (batcher.isBatched(entity)) {
+                queueEntity(entity);
+            }
+        }
+        queue.sort();
+        batching = false;
+    }
 
-    drawGrid(0.5f);
+    if (!useShaders) {
+        glMatrixMode(GL_PROJECTION);
+        glLoadMatrixf(glm::value_ptr(projection));
+        glMatrixMode(GL_MODELVIEW);
+        glLoadMatrixf(glm::value_ptr(view));
+    }
 
-    // Render every object in the scene
-    for (const auto& obj : gameObjects) {
-        if (!obj->getActive()) {
-            continue; 
-        }
-        if (!camera.isInFrustum(obj->corners)) {
-            continue;  // Skip objects outside the frustum
-        }
-        glPushMatrix();
+    // From here every object also writes its ID, for picking
+    PickingBuffer& picking = PickingBuffer::pickingBuffer;
+    picking.beginPass(!useShaders);
 
-        glm::mat4 transform = obj->getTransformMatrix();
-        glMultMatrixf(glm::value_ptr(transform));
+    // Draws go in queue order, grouped by texture and mesh and front to back inside each group.
+    // Hardware queries skip what was hidden at its last test, and test those objects with their box.
+    queries.beginFrame();
 
-        glColor3f(1.0f, 1.0f, 1.0f);
+    if (batching) {
+        for (const StaticBatch* batch : batcher.getVisibleBatches()) {
+            if (queue.setTexture(batch->texture)) {
+                pipeline.setTexture(batch->texture);
+            }
+            batcher.draw(*batch);
+        }
+        queue.invalidate();
+    }
 
-        if (obj->textureID) {
-            glEnable(GL_TEXTURE_2D);
-            glBindTexture(GL_TEXTURE_2D, obj->textureID);
+    const auto draw = [&](Entity entity) {
+        if (useShaders) {
+            drawEntityShaded(entity);
         }
         else {
-            glDisable(GL_TEXTURE_2D);
+            drawEntity(entity, selection);
         }
+    };
+
+    // Per-object queries need a draw per object, without them a batch of packets is a single instanced draw,
+    // or one command of a multi-draw when indirect drawing is available
+    const bool instancing = useShaders && pipeline.instancing && !queries.enabled;
+    IndirectRenderer& indirect = IndirectRenderer::indirectRenderer;
+    const std::vector<DrawPacket>& packets = queue.getPackets();
+    const auto submitStart = std::chrono::high_resolution_clock::now();
+
+    if (instancing && indirect.isActive()) {
+        indirect.submit(queue);
+        queue.invalidate();
+    }
+    else {
+        for (size_t i = 0; i < packets.size();) {
+            if (instancing) {
+                const size_t count = queue.batchLength(i);
+                drawBatchShaded(&packets[i], count);
+                i += count;
+                continue;
+            }
 
-        glEnableClientState(GL_VERTEX_ARRAY);
-        glVertexPointer(3, GL_FLOAT, 0, obj->meshData.vertices.data());
-
-        if (!obj->meshData.textCoords.empty()) {
-            glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-            glTexCoordPointer(2, GL_FLOAT, 0, obj->meshData.textCoords.data());
+            const Entity entity = packets[i++].entity;
+            if (!queries.beginObject(entity)) {
+                stats.objectsDrawn--;
+                stats.triangles -= trianglesOf(entity);
+                continue;
+            }
+            draw(entity);
+            queries.endObject(entity);
         }
+        indirect.recordClassicSubmit(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - submitStart).count());
+    }
 
-        glDrawElements(GL_TRIANGLES, obj->meshData.indices.size(), GL_UNSIGNED_INT, obj->meshData.indices.data());
-
-        glDisableClientState(GL_VERTEX_ARRAY);
-        if (!obj->meshData.textCoords.empty()) {
-            glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-        }
+    // Proxies change the bindings between the hidden objects' draws
+    const auto drawHidden = [&](Entity entity) {
+        queue.invalidate();
+        draw(entity);
+        stats.objectsDrawn++;
+        stats.triangles += trianglesOf(entity);
+    };
+
+    const glm::vec3 cameraPosition = glm::vec3(glm::inverse(view)[3]);
+    if (useShaders) {
+        queries.testHiddenObjects(cameraPosition, drawHidden, [&](const AABB& box) { pipeline.drawBox(box); });
+        pipeline.endFrame();
+    }
+    else {
+        queries.testHiddenObjects(cameraPosition, drawHidden);
+        glBindVertexArray(0);
         glBindTexture(GL_TEXTURE_2D, 0);
-        glDisable(GL_TEXTURE_2D); 
+        glDisable(GL_TEXTURE_2D);
+    }
+
+    // Starts this frame's pixel reads and collects the ones that finished
+    picking.endPass();
+    stats.submitMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - cullEnd).count();
+
+    // The grid goes last, behind the objects in front of it and blended over the ones under the floor,
+    // after the ID pass so it never hides an object from picking. It follows the objects' pipeline,
+    // so turning shaders off or falling back to the fixed pipeline switches it too
+    if (useShaders) {
+        pipeline.drawGrid(projection, view, 0.5f, glm::vec3(0.7f));
+        pipeline.endFrame();
+    }
+    else {
+        drawGrid(0.5f);
+    }
 
-        if (variables->window->selectedObject == obj) {
-            obj->RegenerateCorners();  
-            obj->DrawVertex(); 
+    // Debug shapes queued during the frame, from any thread, in one upload and a draw per primitive type
+    DebugDraw& debugDraw = DebugDraw::debugDraw;
+    // The selected object's bounds and wireframe, the same overlay through both pipelines
+    if (selectedVisible) {
+        selectedObject->DrawBoundingBox();
+        selectedObject->DrawVertex();
+    }
+    if (debugDraw.showBounds) {
+        for (Entity entity : drawList) {
+            const BoundsComponent& bounds = World::world.get<BoundsComponent>(entity);
+            const glm::mat4& world = transforms.worldMatrices[World::world.get<TransformComponent>(entity).transformIndex];
+            debugDraw.box(AABB(bounds.localMin, bounds.localMax).transformed(world), glm::vec3(0.3f, 0.9f, 0.3f));
         }
-        glPopMatrix();
     }
+    debugDraw.flush(projection, view);
+    stats.drawCalls = (useShaders ? pipeline.getStats().drawCalls : fixedDraws + 1) + debugDraw.getStats().drawCalls;
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     glViewport(0, 0, Variables::WINDOW_SIZE.x, Variables::WINDOW_SIZE.y);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+    RenderTargetPool::renderTargetPool.endFrame();
     glFlush();
 }
 
+// Draws one mesh with its world matrix, selected objects are tinted
+void Renderer::drawEntity(Entity entity, const Selection& selection) {
+    const TransformComponent& transform = World::world.get<TransformComponent>(entity);
+    const MeshRendererComponent& meshRenderer = World::world.get<MeshRendererComponent>(entity);
+
+    glPushMatrix();
+
+    const glm::mat4& transformMatrix = TransformStore::transformStore.worldMatrices[transform.transformIndex];
+    glMultMatrixf(glm::value_ptr(transformMatrix));
+
+    PickingBuffer& picking = PickingBuffer::pickingBuffer;
+    picking.setObject(entity, meshRenderer.textureID != 0);
+
+    glColor3fv(glm::value_ptr(tintOf(entity, selection)));
+
+    // Texture and vertex array stay bound for the next draw, the queue tells when they change
+    RenderQueue& queue = RenderQueue::renderQueue;
+    if (queue.setTexture(meshRenderer.textureID)) {
+        if (meshRenderer.textureID) {
+            glEnable(GL_TEXTURE_2D);
+        }
+        else {
+            glDisable(GL_TEXTURE_2D);
+        }
+        glBindTexture(GL_TEXTURE_2D, meshRenderer.textureID);
+    }
+
+    const GpuMesh& mesh = GpuMesh::of(*meshRenderer.mesh);
+    if (queue.setMesh(mesh)) {
+        mesh.bind();
+    }
+    mesh.drawTriangles();
+    fixedDraws++;
+    glPopMatrix();
+}
+
+// Same as drawEntity through the shader pipeline, the object's matrix and tint are already in its buffers
+void Renderer::drawEntityShaded(Entity entity) {
+    const MeshRendererComponent& meshRenderer = World::world.get<MeshRendererComponent>(entity);
+
+    DrawPacket packet;
+    packet.entity = entity;
+    packet.texture = meshRenderer.textureID;
+    packet.mesh = &GpuMesh::of(*meshRenderer.mesh);
+    drawBatchShaded(&packet, 1);
+}
+
+// Packets sharing mesh and texture, with consecutive records, as instances of one draw
+void Renderer::drawBatchShaded(const DrawPacket* packets, size_t count) {
+    RenderPipeline& pipeline = RenderPipeline::renderPipeline;
+    RenderQueue& queue = RenderQueue::renderQueue;
+    const DrawPacket& first = packets[0];
+    const GpuMesh& mesh = *first.mesh;
+
+    if (queue.setTexture(first.texture)) {
+        pipeline.setTexture(first.texture);
+    }
+    if (queue.setMesh(mesh)) {
+        mesh.bind();
+    }
+    pipeline.drawMesh(first.entity, mesh, static_cast<GLsizei>(count));
+}
+
+// Hovered objects first, then the selection, the rest keep their texture's colors
+glm::vec3 Renderer::tintOf(Entity entity, const Selection& selection) const {
+    const PickingBuffer& picking = PickingBuffer::pickingBuffer;
+    if (picking.hoverHighlight && picking.isActive() && picking.getHovered() == entity) {
+        return glm::vec3(1.0f, 0.8f, 0.5f);
+    }
+    if (selection.contains(entity)) {
+        return glm::vec3(0.6f, 0.85f, 1.0f);
+    }
+    return glm::vec3(1.0f);
+}
+
 void Renderer::cleanupFrameBuffer() {
-    glDeleteFramebuffers(1, &framebuffer);
-    glDeleteTextures(1, &textureColorbuffer);
-    glDeleteRenderbuffers(1, &rbo);
+    PickingBuffer::pickingBuffer.detach();
+    RenderTargetPool::renderTargetPool.releaseAll();
+    framebuffer = textureColorbuffer = rbo = 0;
 }
\ No newline at end of file
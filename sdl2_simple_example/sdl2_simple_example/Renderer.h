@@ -5,6 +5,10 @@
 #include <string>
 #include "GameObject.h"
 #include "Camera.h"
+#include "Selection.h"
+
+struct DrawPacket;
+class GpuMesh;
 
 extern GLuint framebuffer;
 extern GLuint textureColorbuffer;
@@ -13,19 +17,47 @@ extern GLuint rbo;
 extern int framebufferWidth;
 extern int framebufferHeight;
 
+// Last frame's totals, for the benchmarks
+struct RenderStats {
+	size_t objectsDrawn = 0;		// Submitted to GL, without those hardware queries skipped
+	size_t triangles = 0;
+	size_t drawCalls = 0;		// Scene, grid and debug shapes, through either pipeline
+	double cullMs = 0.0;		// Frustum and occlusion culling
+	double submitMs = 0.0;		// Queue, object records and scene draws, CPU side
+};
+
 class Renderer {
 public:
 	static Renderer renderer;
 
 	void initOpenGL();
-	bool processEvents(Camera& camera, std::vector<GameObject>& gameObjects, const char*& fbxFile);
+	bool processEvents(Camera& camera, std::vector<GameObject*>& gameObjects, const char*& fbxFile);
 	void HandleDroppedFile(const char* droppedFile);
 	void HandleDragDropTarget();
 	void drawGrid(float spacing);
-	void render(const std::vector<GameObject*>& gameObjects);
+	void render();
+	void drawEntity(Entity entity, const Selection& selection);
+	void drawEntityShaded(Entity entity);
+	void drawBatchShaded(const DrawPacket* packets, size_t count);
+	glm::vec3 tintOf(Entity entity, const Selection& selection) const;
 	std::string getFileName(const std::string& path);
-	void createFrameBuffer(int width, int height);
+	// Scene window size, every frame
+	void updateFrameBuffer(int width, int height);
 	void cleanupFrameBuffer();
+
+	// Matrices of the last frame drawn, for screen space queries such as box selection
+	glm::mat4 projectionMatrix = glm::mat4(1.0f);
+	glm::mat4 viewMatrix = glm::mat4(1.0f);
+
+	const RenderStats& getStats() const { return stats; }
+
+private:
+	RenderStats stats;
+	size_t fixedDraws = 0;
+
+	// Fixed pipeline grid, compiled once per spacing
+	GLuint gridList = 0;
+	float gridListSpacing = 0.0f;
 };
 
 #endif // RENDERER_H
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "SceneManager.h"
 #include "ConsoleWindow.h"
 #include "Importer.h"
+#include "JobSystem.h"
 #include <fstream>
 
 SceneManager sceneManager;
@@ -42,55 +43,72 @@ void SceneManager::loadScene(const std::string& inputPath, std::vector<GameObjec
         cereal::JSONInputArchive archive(inFile);
 
         for (auto obj : gameObjects) {
-            delete obj;
+            GameObjectPool::pool.destroy(obj);
         }
         gameObjects.clear();
 
         std::vector<GameObjectWrapper> wrappedObjects;
         archive(cereal::make_nvp("gameObjects", wrappedObjects));
 
-        std::unordered_map<std::string, GameObject*> uuidToGameObject;
         gameObjects.reserve(wrappedObjects.size());
 
+        // Each texture file is read once, in parallel, then uploaded here since GL is main-thread only
+        std::vector<std::string> texturePaths;
+        std::unordered_map<std::string, size_t> textureSlots;
+        for (auto& wrapper : wrappedObjects) {
+            const std::string& path = wrapper.ptr->texturePath;
+            if (!path.empty() && textureSlots.emplace(path, texturePaths.size()).second) {
+                texturePaths.push_back(path);
+            }
+        }
+
+        std::vector<TextureData> textureData(texturePaths.size());
+        JobSystem::jobSystem.parallelFor(texturePaths.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                textureData[i] = importer.readTextureFromCustomFormat(texturePaths[i]);
+            }
+        });
+
+        std::vector<GLuint> textureIDs(texturePaths.size(), 0);
+        for (size_t i = 0; i < textureData.size(); ++i) {
+            if (textureData[i].pixels) {
+                textureIDs[i] = importer.uploadTexture(textureData[i]);
+            }
+        }
+
         for (auto& wrapper : wrappedObjects) {
             GameObject* obj = wrapper.ptr;
             gameObjects.push_back(obj);
-            uuidToGameObject[obj->uuid] = obj;
 
-            obj->initialPosition = obj->position;
-            obj->initialRotation = obj->rotation;
-            obj->initialScale = obj->scale;
-
-            obj->globalTransform = obj->getTransformMatrix();
+            obj->initialPosition = obj->getPosition();
+            obj->initialRotation = obj->getRotation();
+            obj->initialScale = obj->getScale();
 
             if (!obj->texturePath.empty()) {
-                obj->textureID = importer.loadTextureFromCustomFormat(obj->texturePath);
-                console.addLog("Loaded texture for GameObject: " + obj->name + " with texture ID: " + std::to_string(obj->textureID));
+                obj->setTexture(obj->texturePath, textureIDs[textureSlots[obj->texturePath]]);
+                console.addLog("Loaded texture for GameObject: " + obj->name + " with texture ID: " + std::to_string(obj->getTextureID()));
             }
             else {
-                obj->textureID = 0;
+                obj->setTexture("", 0);
             }
 
-            console.addLog("Loaded GameObject: " + obj->name + " UUID: " + obj->uuid);
+            console.addLog("Loaded GameObject: " + obj->name + " UUID: " + obj->uuid.toString());
         }
 
         for (auto obj : gameObjects) {
-            for (const auto& childUUID : obj->pendingChildUUIDs) {
-                auto it = uuidToGameObject.find(childUUID);
-                if (it != uuidToGameObject.end()) {
-                    obj->addChild(it->second);
+            for (const ObjectID& childUUID : obj->pendingChildUUIDs) {
+                GameObject* child = GameObject::findByID(childUUID);
+                if (child) {
+                    obj->addChild(child);
                 }
                 else {
-                    console.addLog("Warning: Child UUID not found: " + childUUID);
+                    console.addLog("Warning: Child UUID not found: " + childUUID.toString());
                 }
             }
             obj->pendingChildUUIDs.clear();
         }
         for (auto obj : gameObjects) {
 			obj->fromScene = true; // Tell HierarchyWindow to don't apply child-parent transforms in scene objects.
-            if (obj->parent == nullptr) {
-                obj->updateChildTransforms();
-            }
         }
         console.addLog("Scene loaded successfully from: " + inputPath);
     }
@@ -121,15 +139,15 @@ void SceneManager::saveSceneState(std::vector<GameObject*>& gameObjects) {
     for (auto& gameObject : gameObjects) {
         GameObjectState state;
         state.uuid = gameObject->uuid;
-        state.position = gameObject->position;
-        state.rotation = gameObject->rotation;
-        state.scale = gameObject->scale;
-        state.parentUUID = gameObject->parent ? gameObject->parent->uuid : "";
-        state.textureID = gameObject->textureID; 
-        state.active = gameObject->active;
-        state.dynamic = gameObject->dynamic;
-
-        initialState.push_back(state);
+        state.position = gameObject->getPosition();
+        state.rotation = gameObject->getRotation();
+        state.scale = gameObject->getScale();
+        state.parentUUID = gameObject->parent ? gameObject->parent->uuid : ObjectID();
+        state.textureID = gameObject->getTextureID(); 
+        state.active = gameObject->getActive();
+        state.dynamic = gameObject->isDynamic();
+
+        initialState[state.uuid] = state;
     }
 
     console.addLog("Scene state saved.");
@@ -137,25 +155,25 @@ void SceneManager::saveSceneState(std::vector<GameObject*>& gameObjects) {
 
 void SceneManager::restoreSceneState(std::vector<GameObject*>& gameObjects) {
     for (auto& gameObject : gameObjects) {
-        auto it = std::find_if(initialState.begin(), initialState.end(),[&gameObject](const GameObjectState& state) { return state.uuid == gameObject->uuid;});
+        auto it = initialState.find(gameObject->uuid);
 
         if (it != initialState.end()) {
-            const GameObjectState& state = *it;
+            const GameObjectState& state = it->second;
 
             gameObject->setPosition(state.position);
             gameObject->setRotation(state.rotation);
             gameObject->setScale(state.scale);
 
-            if (!state.parentUUID.empty()) {
-                auto parentIt = std::find_if(gameObjects.begin(), gameObjects.end(),[&state](GameObject* obj) { return obj->uuid == state.parentUUID; });
-                if (parentIt != gameObjects.end()) {
-                    gameObject->parent = *parentIt;
+            if (!state.parentUUID.isNull()) {
+                GameObject* parent = GameObject::findByID(state.parentUUID);
+                if (parent) {
+                    gameObject->setParentLink(parent);
                 }
             }
 
-            gameObject->textureID = state.textureID;
-            gameObject->active = state.active;
-            gameObject->dynamic = state.dynamic;
+            gameObject->setTexture(gameObject->texturePath, state.textureID);
+            gameObject->setActive(state.active);
+            gameObject->setDynamic(state.dynamic);
         }
     }
 
@@ -9,11 +9,11 @@
 #include <vector>
 
 struct GameObjectState {
-    std::string uuid;
+    ObjectID uuid;
     glm::vec3 position;
     glm::vec3 rotation;
     glm::vec3 scale;
-    std::string parentUUID;
+    ObjectID parentUUID;    // Null when the object has no parent
     GLuint textureID;  
     bool active;  
     bool dynamic;
@@ -32,7 +32,7 @@ public:
 
     std::vector<std::string> availableScenes;
 private:
-    std::vector<GameObjectState> initialState;
+    std::unordered_map<ObjectID, GameObjectState> initialState;
 };
 
 
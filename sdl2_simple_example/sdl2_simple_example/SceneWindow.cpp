@@ -10,6 +10,15 @@
 #include "ConsoleWindow.h"
 #include "MyWindow.h"
 #include "SimulationManager.h"
+#include "CullingSystem.h"
+#include "MeshBVH.h"
+#include "PickingBuffer.h"
+#include "DebugDraw.h"
+#include "RenderTargetPool.h"
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+#include <limits>
 
 // Extern variables used in the main code
 extern Renderer renderer;
@@ -18,6 +27,9 @@ extern Camera camera;
 enum class ActiveButton { None, Start, Pause, Stop };
 ActiveButton activeButton = ActiveButton::None;
 
+// Pixels the mouse has to move before a click becomes a box selection
+const float BOX_DRAG_THRESHOLD = 4.0f;
+
 void SceneWindow::render() {
     ImGui::Begin("Scene", nullptr, ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoScrollbar);
 
@@ -64,16 +76,15 @@ void SceneWindow::render() {
     if (ImGui::Button("Start", ImVec2(buttonWidth, 0)) && activeButton != ActiveButton::Start) { 
         activeButton = ActiveButton::Start;
         SimulationManager::simulationManager.startSimulation(variables->window->gameObjects);
-        for (GameObject* obj : variables->window->gameObjects) {
-            if (obj->isCamera) {
-                camera.initPosition = camera.position;
-                camera.initAngleX = camera.angleX;
-                camera.initAngleY = camera.angleY;
-                camera.position = -obj->getPosition();
-                camera.angleX = -obj->getRotation().x;
-                camera.angleY = -obj->getRotation().y;
-            }
-        }
+        World::world.each<CameraComponent, EditorObjectComponent>([](Entity, CameraComponent&, EditorObjectComponent& editor) {
+            GameObject* obj = editor.object;
+            camera.initPosition = camera.position;
+            camera.initAngleX = camera.angleX;
+            camera.initAngleY = camera.angleY;
+            camera.position = -obj->getWorldPosition();
+            camera.angleX = -obj->getRotation().x;
+            camera.angleY = -obj->getRotation().y;
+        });
     }
     ImGui::SameLine();
 
@@ -101,21 +112,38 @@ void SceneWindow::render() {
     if (ImGui::Button("Stop", ImVec2(buttonWidth, 0))) {
         activeButton = ActiveButton::Stop;
         SimulationManager::simulationManager.stopSimulation(variables->window->gameObjects);
-        for (GameObject* obj : variables->window->gameObjects) {
-            if (obj->isCamera) {
-                camera.position = camera.initPosition;
-                camera.angleX = camera.initAngleX;
-                camera.angleY = camera.initAngleY;
-            }
-        }
+        World::world.each<CameraComponent>([](Entity, CameraComponent&) {
+            camera.position = camera.initPosition;
+            camera.angleX = camera.initAngleX;
+            camera.angleY = camera.initAngleY;
+        });
     }
     ImGui::End();
 
     updateSceneSize();
    
-    // Show texture on screen
-    glBindTexture(GL_TEXTURE_2D, textureColorbuffer);
-    ImGui::Image((void*)(intptr_t)textureColorbuffer, ImVec2(framebufferWidth, framebufferHeight));
+    // Show texture on screen, only the part drawn into, stretched to the window while a new size settles
+    const RenderTarget& sceneTarget = RenderTargetPool::renderTargetPool.getSceneTarget();
+    const ImVec2 drawnArea(static_cast<float>(framebufferWidth) / std::max(sceneTarget.width, 1), static_cast<float>(framebufferHeight) / std::max(sceneTarget.height, 1));
+    ImGui::Image((void*)(intptr_t)textureColorbuffer, imageSize, ImVec2(0.0f, 0.0f), drawnArea);
+
+    // ID buffer picking: the pixel under the cursor is read every frame for hover, and on clicks
+    PickingBuffer& picking = PickingBuffer::pickingBuffer;
+    if (picking.isActive() && ImGui::IsItemHovered()) {
+        const ImVec2 imageMin = ImGui::GetItemRectMin();
+        const ImVec2 mouse = ImGui::GetMousePos();
+        const int pixelX = static_cast<int>((mouse.x - imageMin.x) * framebufferWidth / imageSize.x);
+        const int pixelY = static_cast<int>((mouse.y - imageMin.y) * framebufferHeight / imageSize.y);
+        picking.requestHover(pixelX, pixelY);
+        if (ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
+            picking.requestClick(pixelX, pixelY);
+        }
+    }
+    else {
+        picking.clearHover();
+    }
+    selectPickedObject();
+    updateBoxSelection();
 
     // Drag & Drop Management
     if (ImGui::BeginDragDropTarget()) {
@@ -131,16 +159,14 @@ void SceneWindow::render() {
     ImGui::End();
 }
 
+// Every frame: the render target pool decides when the scene target really needs reallocating
 void SceneWindow::updateSceneSize() {
     ImVec2 availableSize = ImGui::GetContentRegionAvail();
-    int newWidth = static_cast<int>(availableSize.x);
-    int newHeight = static_cast<int>(availableSize.y);
+    int newWidth = std::max(static_cast<int>(availableSize.x), 1);
+    int newHeight = std::max(static_cast<int>(availableSize.y), 1);
 
-    if (newWidth != framebufferWidth || newHeight != framebufferHeight) {
-        framebufferWidth = newWidth;
-        framebufferHeight = newHeight;
-        renderer.createFrameBuffer(framebufferWidth, framebufferHeight);
-    }
+    imageSize = ImVec2(static_cast<float>(newWidth), static_cast<float>(newHeight));
+    renderer.updateFrameBuffer(newWidth, newHeight);
 }
 glm::mat4 SceneWindow::ProjectionMatrix() { 
     float aspectRatio = static_cast<float>(framebufferWidth) / static_cast<float>(framebufferHeight);
@@ -171,8 +197,8 @@ Ray SceneWindow::getRayFromMouse(int mouseX, int mouseY, int screenWidth, int sc
     mouseX -= static_cast<int>(windowPos.x);
     mouseY -= static_cast<int>(windowPos.y + headerOffset);
 
-    float windowWidth = framebufferWidth;
-    float windowHeight = framebufferHeight;
+    float windowWidth = imageSize.x;
+    float windowHeight = imageSize.y;
 
     // Verify that the mouse is within limits
     if (mouseX < 0 || mouseX > windowWidth || mouseY < 0 || mouseY > windowHeight) {
@@ -222,60 +248,170 @@ Ray SceneWindow::getRayFromMouse(int mouseX, int mouseY, int screenWidth, int sc
     return Ray(-camera.position, rayDirection);
 }
 
+// Queued for the end of the frame, over the scene so a ray inside an object stays visible
 void SceneWindow::DrawRay(const Ray& ray, float length) {
-    glm::vec3 endPoint = ray.origin + ray.direction * length;
+    DebugDraw::debugDraw.ray(ray.origin, ray.direction, length, glm::vec3(1.0f, 0.0f, 0.0f), DebugDraw::Mode::Overlay);
+}
+
+// Selects the object under the last ID buffer click once its pixel has been read back
+void SceneWindow::selectPickedObject() {
+    Entity picked;
+    if (!PickingBuffer::pickingBuffer.takeClick(picked) || !World::world.isAlive(picked)) {
+        return;
+    }
+
+    EditorObjectComponent* editor = World::world.tryGet<EditorObjectComponent>(picked);
+    if (editor) {
+        variables->window->selectObject(editor->object);
+        console.addLog("Objeto seleccionado: " + editor->object->name);
+    }
+}
+
+// Rubber band over the scene image, started by a left click that isn't orbiting the camera.
+// Uses the image item, so it has to be called right after it.
+void SceneWindow::updateBoxSelection() {
+    const ImVec2 mouse = ImGui::GetMousePos();
+    const ImGuiIO& io = ImGui::GetIO();
+
+    if (ImGui::IsItemHovered() && ImGui::IsMouseClicked(ImGuiMouseButton_Left) && !io.KeyAlt) {
+        boxPending = true;
+        boxStart = mouse;
+    }
+    if (!boxPending) return;
+
+    if (ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
+        // Short drags stay clicks
+        if (!boxSelecting && ImGui::IsMouseDragging(ImGuiMouseButton_Left, BOX_DRAG_THRESHOLD)) {
+            boxSelecting = true;
+        }
+        if (boxSelecting) {
+            const ImVec2 rectMin(std::min(boxStart.x, mouse.x), std::min(boxStart.y, mouse.y));
+            const ImVec2 rectMax(std::max(boxStart.x, mouse.x), std::max(boxStart.y, mouse.y));
+            ImDrawList* drawList = ImGui::GetWindowDrawList();
+            drawList->AddRectFilled(rectMin, rectMax, IM_COL32(80, 140, 255, 40));
+            drawList->AddRect(rectMin, rectMax, IM_COL32(80, 140, 255, 200));
+        }
+        return;
+    }
 
-    glPushMatrix();
-    glColor3f(1.0f, 0.0f, 0.0f);
+    if (boxSelecting) {
+        const ImVec2 imageMin = ImGui::GetItemRectMin();
+        selectInRect(ImVec2(boxStart.x - imageMin.x, boxStart.y - imageMin.y), ImVec2(mouse.x - imageMin.x, mouse.y - imageMin.y));
+    }
+    boxPending = false;
+    boxSelecting = false;
+}
 
-    // Draw the lightning
-    glBegin(GL_LINES);
-    glVertex3f(ray.origin.x, ray.origin.y, ray.origin.z);
-    glVertex3f(endPoint.x, endPoint.y, endPoint.z);
-    glEnd();
+// The rectangle cuts a smaller frustum out of the camera's, its planes query the culling structures
+// directly instead of casting rays through every pixel.
+void SceneWindow::selectInRect(const ImVec2& cornerA, const ImVec2& cornerB) {
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    // The projection flips y, so the image's top row is at -1 in normalized device coordinates
+    const glm::vec2 size(imageSize.x, imageSize.y);
+    const glm::vec2 a = glm::vec2(cornerA.x, cornerA.y) / size * 2.0f - 1.0f;
+    const glm::vec2 b = glm::vec2(cornerB.x, cornerB.y) / size * 2.0f - 1.0f;
+    const glm::vec2 ndcMin = glm::clamp(glm::min(a, b), glm::vec2(-1.0f), glm::vec2(1.0f));
+    const glm::vec2 ndcMax = glm::clamp(glm::max(a, b), glm::vec2(-1.0f), glm::vec2(1.0f));
+    const Frustum frustum = Frustum::fromRegion(renderer.projectionMatrix * renderer.viewMatrix, ndcMin, ndcMax);
+
+    std::vector<Entity> candidates;
+    CullingSystem::cullingSystem.queryFrustum(frustum, candidates);
+
+    std::vector<GameObject*> objects;
+    objects.reserve(candidates.size());
+    for (Entity entity : candidates) {
+        EditorObjectComponent* editor = World::world.isAlive(entity) ? World::world.tryGet<EditorObjectComponent>(entity) : nullptr;
+        if (!editor) continue;
+
+        GameObject* obj = editor->object;
+        // The frustum moves to mesh space, the tree skips every triangle group fully in or out.
+        // Without triangles there is nothing for the frustum to overlap.
+        if (exactBoxSelection) {
+            const MeshData* meshData = obj->getMeshData();
+            if (!meshData || meshData->vertices.empty() || meshData->indices.empty() ||
+                !MeshBVH::of(*meshData).overlapsFrustum(frustum.transformed(obj->getWorldMatrix()))) {
+                continue;
+            }
+        }
+        objects.push_back(obj);
+    }
 
-    // Draw the point of origin
-    glPointSize(5.0f);
-    glBegin(GL_POINTS);
-    glVertex3f(ray.origin.x, ray.origin.y, ray.origin.z);
-    glVertex3f(endPoint.x, endPoint.y, endPoint.z);
-    glEnd();
+    const ImGuiIO& io = ImGui::GetIO();
+    MyWindow* window = variables->window;
+    if (io.KeyCtrl) {
+        for (GameObject* obj : objects) {
+            window->selectedObjects.remove(obj);
+        }
+    }
+    else {
+        if (!io.KeyShift) {
+            window->selectedObjects.clear();
+        }
+        for (GameObject* obj : objects) {
+            window->selectedObjects.add(obj);
+        }
+    }
+    window->selectedObject = window->selectedObjects.empty() ? nullptr : window->selectedObjects.back();
 
-    glPopMatrix();
+    const double selectMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    char details[128];
+    snprintf(details, sizeof(details), "Box selection: %zu objects (%zu boxes in the rectangle), %zu selected, %.3f ms",
+        objects.size(), candidates.size(), window->selectedObjects.size(), selectMs);
+    console.addLog(details);
 }
 
-// Check if the beam intersects with any object in the scene.
+// Check if the beam intersects with any object in the scene, the nearest triangle hit selects its object.
 void SceneWindow::checkRaycast(int mouseX, int mouseY, int screenWidth, int screenHeight) {
-    Ray ray = getRayFromMouse(mouseX, mouseY, screenWidth, screenHeight);
-    rayo = new Ray(ray);
-    rayo->origin = ray.origin;
-    rayo->direction = ray.direction;
+    const auto start = std::chrono::high_resolution_clock::now();
 
+    Ray ray = getRayFromMouse(mouseX, mouseY, screenWidth, screenHeight);
+    rayo = ray;
     rayoexists = true;
 
-    for (auto& obj : variables->window->gameObjects) {
-        MeshData* meshData = obj->getMeshData();
-        if (meshData) {
-            for (size_t i = 0; i < meshData->indices.size(); i += 3) {
-                glm::vec3 vertex1 = glm::vec3(meshData->vertices[meshData->indices[i] * 3], meshData->vertices[meshData->indices[i] * 3 + 1], meshData->vertices[meshData->indices[i] * 3 + 2]);
-                glm::vec3 vertex2 = glm::vec3(meshData->vertices[meshData->indices[i + 1] * 3], meshData->vertices[meshData->indices[i + 1] * 3 + 1], meshData->vertices[meshData->indices[i + 1] * 3 + 2]);
-                glm::vec3 vertex3 = glm::vec3(meshData->vertices[meshData->indices[i + 2] * 3], meshData->vertices[meshData->indices[i + 2] * 3 + 1], meshData->vertices[meshData->indices[i + 2] * 3 + 2]);
-
-                glm::vec3 edge1 = vertex2 - vertex1;
-                glm::vec3 edge2 = vertex3 - vertex1;
-                glm::vec3 faceNormal = glm::normalize(glm::cross(edge1, edge2));
-
-                float t = 0.0f;
-                if (ray.intersectsTriangle(vertex1, vertex2, vertex3, t)) {
-                    variables->window->selectObject(obj);
-                    if (variables->window->selectedObject != nullptr) {
-                        console.addLog("Objeto seleccionado: " + variables->window->selectedObject->name);
-                    }
-                    variables->window->selectedObjects.push_back(obj);
-                    
-                    break;
-                }
-            }
+    // Only objects whose world box the ray crosses are tested, nearest boxes first. Boxes starting
+    // farther than the closest triangle hit so far are skipped.
+    GameObject* closestObject = nullptr;
+    MeshRayHit closestHit;
+    float closestDistance = std::numeric_limits<float>::max();
+
+    CullingSystem::cullingSystem.raycast(ray.origin, ray.direction, closestDistance, [&](Entity entity, float) {
+        EditorObjectComponent* editor = World::world.isAlive(entity) ? World::world.tryGet<EditorObjectComponent>(entity) : nullptr;
+        if (!editor) {
+            return closestDistance;
         }
+
+        GameObject* obj = editor->object;
+        const MeshData* meshData = obj->getMeshData();
+        if (!meshData || meshData->vertices.empty() || meshData->indices.empty()) {
+            return closestDistance;
+        }
+
+        // Triangles are in mesh space, the ray is moved there instead. The direction is not
+        // renormalized so distances stay comparable between objects.
+        const glm::mat4 inverseWorld = glm::inverse(obj->getWorldMatrix());
+        const glm::vec3 localOrigin = glm::vec3(inverseWorld * glm::vec4(ray.origin, 1.0f));
+        const glm::vec3 localDirection = glm::vec3(inverseWorld * glm::vec4(ray.direction, 0.0f));
+
+        MeshRayHit hit;
+        if (MeshBVH::of(*meshData).raycast(localOrigin, localDirection, closestDistance, hit)) {
+            closestDistance = hit.distance;
+            closestHit = hit;
+            closestObject = obj;
+        }
+        return closestDistance;
+    });
+
+    const double pickMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    if (closestObject) {
+        variables->window->selectObject(closestObject);
+        if (variables->window->selectedObject != nullptr) {
+            console.addLog("Objeto seleccionado: " + variables->window->selectedObject->name);
+        }
+        char details[128];
+        snprintf(details, sizeof(details), "Hit triangle %u at %.3f, barycentrics (%.3f, %.3f), %.3f ms",
+            closestHit.triangle, closestHit.distance, closestHit.u, closestHit.v, pickMs);
+        console.addLog(details);
     }
-}
\ No newline at end of file
+}
@@ -18,6 +18,10 @@ public:
 
     Ray getRayFromMouse(int mouseX, int mouseY, int screenWidth, int screenHeight);
     void checkRaycast(int mouseX, int mouseY, int screenWidth, int screenHeight);
+    void selectPickedObject();
+    void updateBoxSelection();
+    // Corners in pixels of the scene image, in any order
+    void selectInRect(const ImVec2& cornerA, const ImVec2& cornerB);
     void DrawRay(const Ray& ray, float length);
    
 
@@ -25,9 +29,19 @@ public:
     ImVec2 windowPos;
     ImVec2 contentPos;
     ImVec2 contentRegionAvail;
-
-    Ray* rayo;
-    bool rayoexists;
+    // Size the scene image is shown at, the scene may be drawn smaller while a resize settles
+    ImVec2 imageSize = ImVec2(1.0f, 1.0f);
+
+    // Last picking ray, kept for debugging
+    Ray rayo = Ray(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+    bool rayoexists = false;
+
+    // Dragging over the scene selects every object in the rectangle, Shift adds to the selection and Ctrl
+    // removes from it. Objects are found by their boxes, exact selection then keeps those with triangles inside.
+    bool exactBoxSelection = true;
+    bool boxPending = false;
+    bool boxSelecting = false;
+    ImVec2 boxStart;
 };
 
 #endif // SCENEWINDOW_H
\ No newline at end of file
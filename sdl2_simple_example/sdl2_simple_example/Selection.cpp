@@ -0,0 +1,72 @@
+#include "Selection.h"
+#include "GameObject.h"
+#include <algorithm>
+
+namespace {
+    const uint32_t WORD_BITS = 64;
+}
+
+bool Selection::contains(const GameObject* obj) const {
+    return obj && testBit(obj->entity.index);
+}
+
+bool Selection::contains(Entity entity) const {
+    return testBit(entity.index);
+}
+
+bool Selection::add(GameObject* obj) {
+    if (!obj || contains(obj)) return false;
+    objects.push_back(obj);
+    setBit(obj->entity.index, true);
+    return true;
+}
+
+bool Selection::remove(GameObject* obj) {
+    if (!contains(obj)) return false;
+    const auto it = std::find(objects.begin(), objects.end(), obj);
+    if (it == objects.end()) return false;
+    objects.erase(it);
+    setBit(obj->entity.index, false);
+    return true;
+}
+
+void Selection::toggle(GameObject* obj) {
+    if (!remove(obj)) {
+        add(obj);
+    }
+}
+
+void Selection::set(GameObject* obj) {
+    clear();
+    add(obj);
+}
+
+void Selection::clear() {
+    for (GameObject* obj : objects) {
+        setBit(obj->entity.index, false);
+    }
+    objects.clear();
+}
+
+bool Selection::testBit(uint32_t index) const {
+    const size_t word = index / WORD_BITS;
+    return word < bits.size() && ((bits[word] >> (index % WORD_BITS)) & 1);
+}
+
+void Selection::setBit(uint32_t index, bool value) {
+    const size_t word = index / WORD_BITS;
+    if (word >= bits.size()) {
+        if (!value) return;
+        bits.resize(word + 1, 0);
+    }
+
+    const uint64_t mask = uint64_t(1) << (index % WORD_BITS);
+    bits[word] = value ? bits[word] | mask : bits[word] & ~mask;
+}
+
+void Selection::rebuildBits() {
+    std::fill(bits.begin(), bits.end(), 0);
+    for (const GameObject* obj : objects) {
+        setBit(obj->entity.index, true);
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef SELECTION_H
+#define SELECTION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ECS.h"
+
+class GameObject;
+
+// The editor's selected objects, in the order they were selected, the last one being the most recent.
+// Membership is also kept as one bit per entity index, so the hierarchy and the renderer test any
+// object in constant time and selecting thousands of objects at once stays linear.
+class Selection {
+public:
+    using const_iterator = std::vector<GameObject*>::const_iterator;
+
+    bool contains(const GameObject* obj) const;
+    bool contains(Entity entity) const;
+
+    // Each returns false when the selection didn't change
+    bool add(GameObject* obj);
+    bool remove(GameObject* obj);
+    void toggle(GameObject* obj);
+
+    // Replaces the selection with a single object
+    void set(GameObject* obj);
+    void clear();
+
+    // Removes the objects matching the predicate, the others keep their order
+    template <typename Predicate>
+    void removeIf(Predicate&& predicate);
+
+    size_t size() const { return objects.size(); }
+    bool empty() const { return objects.empty(); }
+    GameObject* front() const { return objects.front(); }
+    GameObject* back() const { return objects.back(); }
+    GameObject* operator[](size_t i) const { return objects[i]; }
+    const_iterator begin() const { return objects.begin(); }
+    const_iterator end() const { return objects.end(); }
+
+private:
+    std::vector<GameObject*> objects;
+    std::vector<uint64_t> bits;     // Indexed by entity index
+
+    bool testBit(uint32_t index) const;
+    void setBit(uint32_t index, bool value);
+    void rebuildBits();
+};
+
+template <typename Predicate>
+void Selection::removeIf(Predicate&& predicate) {
+    size_t kept = 0;
+    for (GameObject* obj : objects) {
+        if (!predicate(obj)) {
+            objects[kept++] = obj;
+        }
+    }
+    if (kept == objects.size()) return;
+
+    // Removed objects may already be released, the bits are rebuilt from the survivors instead
+    objects.resize(kept);
+    rebuildBits();
+}
+
+#endif // SELECTION_H
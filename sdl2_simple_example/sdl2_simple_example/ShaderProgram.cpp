@@ -0,0 +1,64 @@
+#include "ShaderProgram.h"
+#include "ConsoleWindow.h"
+#include <string>
+
+namespace {
+    GLuint compileShader(const char* name, GLenum type, const char* source) {
+        GLuint shader = glCreateShader(type);
+        glShaderSource(shader, 1, &source, nullptr);
+        glCompileShader(shader);
+
+        GLint compiled = GL_FALSE;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+        if (!compiled) {
+            char log[512] = {};
+            glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+            console.addLog(std::string(name) + " shader error: " + log);
+            glDeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    }
+}
+
+bool ShaderProgram::build(const char* name, const char* vertexSource, const char* fragmentSource,
+    std::initializer_list<Binding> attributes, std::initializer_list<Binding> outputs) {
+    release();
+
+    GLuint vertex = compileShader(name, GL_VERTEX_SHADER, vertexSource);
+    GLuint fragment = compileShader(name, GL_FRAGMENT_SHADER, fragmentSource);
+    if (vertex == 0 || fragment == 0) {
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+        return false;
+    }
+
+    program = glCreateProgram();
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    for (const Binding& attribute : attributes) {
+        glBindAttribLocation(program, attribute.location, attribute.name);
+    }
+    for (const Binding& output : outputs) {
+        glBindFragDataLocation(program, output.location, output.name);
+    }
+    glLinkProgram(program);
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        char log[512] = {};
+        glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+        console.addLog(std::string(name) + " shader link error: " + log);
+        release();
+        return false;
+    }
+    return true;
+}
+
+void ShaderProgram::release() {
+    glDeleteProgram(program);
+    program = 0;
+}
@@ -0,0 +1,30 @@
+#ifndef SHADERPROGRAM_H
+#define SHADERPROGRAM_H
+
+#include <initializer_list>
+#include <GL/glew.h>
+
+// A linked GLSL program. Attribute and fragment output locations are bound by name before linking,
+// so vertex arrays and framebuffers don't depend on what the compiler picks.
+class ShaderProgram {
+public:
+    struct Binding {
+        GLuint location;
+        const char* name;
+    };
+
+    // Compiler and linker errors go to the console, prefixed with 'name'
+    bool build(const char* name, const char* vertexSource, const char* fragmentSource,
+        std::initializer_list<Binding> attributes = {}, std::initializer_list<Binding> outputs = {});
+    void release();
+
+    void use() const { glUseProgram(program); }
+    GLint uniform(const char* uniformName) const { return glGetUniformLocation(program, uniformName); }
+    GLuint getId() const { return program; }
+    bool isValid() const { return program != 0; }
+
+private:
+    GLuint program = 0;
+};
+
+#endif // SHADERPROGRAM_H
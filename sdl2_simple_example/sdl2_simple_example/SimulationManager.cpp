@@ -1,5 +1,9 @@
 #include "SimulationManager.h"
 #include "ConsoleWindow.h"
+#include "ECS.h"
+#include "Components.h"
+#include <algorithm>
+#include <unordered_set>
 
 SimulationManager SimulationManager::simulationManager;
 
@@ -17,11 +21,13 @@ void SimulationManager::startSimulation(std::vector<GameObject*>& gameObjects) {
     if (currentState == SimulationState::Stopped || currentState == SimulationState::Paused) {
         if (currentState == SimulationState::Stopped) sceneManager.saveSceneState(gameObjects);
         currentState = SimulationState::Running;
-        for (auto& obj : gameObjects) {
-            if (obj && obj->movementState != MovementState::Running) {
-                obj->startMovement();
+        World::world.each<MovementComponent, EditorObjectComponent>([](Entity, MovementComponent& movement, EditorObjectComponent& editor) {
+            if (movement.state != MovementState::Running) {
+                movement.state = MovementState::Running;
+                movement.startTime = std::chrono::high_resolution_clock::now() - std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(std::chrono::duration<float>(movement.elapsedPausedTime));
+                console.addLog(editor.object->name + " started moving.");
             }
-        }
+        });
         console.addLog("Simulation started.");
     }
 }
@@ -29,11 +35,14 @@ void SimulationManager::startSimulation(std::vector<GameObject*>& gameObjects) {
 void SimulationManager::pauseSimulation(std::vector<GameObject*>& gameObjects) {
     if (currentState == SimulationState::Running) {
         currentState = SimulationState::Paused;
-        for (auto& obj : gameObjects) {
-            if (obj && obj->movementState == MovementState::Running) {
-                obj->pauseMovement();
+        World::world.each<MovementComponent, EditorObjectComponent>([](Entity, MovementComponent& movement, EditorObjectComponent& editor) {
+            if (movement.state == MovementState::Running) {
+                movement.state = MovementState::Paused;
+                auto currentTime = std::chrono::high_resolution_clock::now();
+                movement.elapsedPausedTime = std::chrono::duration<float>(currentTime - movement.startTime).count();
+                console.addLog(editor.object->name + " paused movement.");
             }
-        }
+        });
         console.addLog("Simulation paused.");
     }
 }
@@ -41,20 +50,29 @@ void SimulationManager::pauseSimulation(std::vector<GameObject*>& gameObjects) {
 void SimulationManager::stopSimulation(std::vector<GameObject*>& gameObjects) {
     if (currentState == SimulationState::Running || currentState == SimulationState::Paused) {
         currentState = SimulationState::Stopped;
-        for (auto& obj : gameObjects) {
-            if (obj && obj->movementState != MovementState::Stopped) {
-                obj->stopMovement();
+        World::world.each<MovementComponent, EditorObjectComponent>([](Entity, MovementComponent& movement, EditorObjectComponent& editor) {
+            if (movement.state != MovementState::Stopped) {
+                movement.state = MovementState::Stopped;
+                movement.elapsedPausedTime = 0.0f;
+                movement.direction = 1;
+                console.addLog(editor.object->name + " stopped and reset position.");
             }
-        }
+        });
 
-        for (auto* tempObj : temporaryObjects) {
-            auto it = std::find(gameObjects.begin(), gameObjects.end(), tempObj);
-            if (it != gameObjects.end()) {
-                gameObjects.erase(it);
-                delete tempObj; 
-                console.addLog("Temporary GameObject removed: " + tempObj->name);
+        // Objects deleted by hand during the simulation are no longer in the ID index and get skipped
+        std::unordered_set<GameObject*> expired;
+        for (const ObjectID& tempID : temporaryObjects) {
+            if (GameObject* tempObj = GameObject::findByID(tempID)) {
+                expired.insert(tempObj);
             }
         }
+        gameObjects.erase(std::remove_if(gameObjects.begin(), gameObjects.end(),
+            [&expired](GameObject* obj) { return expired.count(obj) != 0; }), gameObjects.end());
+
+        for (GameObject* tempObj : expired) {
+            console.addLog("Temporary GameObject removed: " + tempObj->name);
+            GameObjectPool::pool.destroy(tempObj);
+        }
         temporaryObjects.clear(); 
 
         console.addLog("Simulation stopped.");
@@ -62,20 +80,27 @@ void SimulationManager::stopSimulation(std::vector<GameObject*>& gameObjects) {
     }
 }
 
-void SimulationManager::update(float deltaTime, std::vector<GameObject*>& gameObjects) {
+// Only entities with a Movement component are visited, each one only writes its own position
+void SimulationManager::update(float deltaTime) {
     console.addLog("Simulation updating BEGINING");
-    for (auto& obj : gameObjects) { 
-        if (obj->movementState == MovementState::Running) {
-            obj->updateMovement(deltaTime);
-            console.addLog("GameObject updating");
+    std::vector<glm::vec3>& positions = TransformStore::transformStore.positions;
+
+    World::world.parallelEach<MovementComponent, TransformComponent>([&](Entity, MovementComponent& movement, TransformComponent& transform) {
+        if (movement.state != MovementState::Running) {
+            return;
         }
-    }
+        glm::vec3& position = positions[transform.transformIndex];
+        position.x += movement.direction * movement.speed * deltaTime;
+        if (position.x >= movement.rangeMax || position.x <= movement.rangeMin) {
+            movement.direction *= -1;
+        }
+    });
     console.addLog("Simulation updating END");
 }
 
 void SimulationManager::trackObject(GameObject* obj) {
     if (currentState == SimulationState::Running) {
-        temporaryObjects.push_back(obj);
+        temporaryObjects.push_back(obj->uuid);
         console.addLog("Tracking GameObject created during Running: " + obj->name);
     }
 }
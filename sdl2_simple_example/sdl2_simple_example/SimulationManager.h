@@ -20,7 +20,7 @@ public:
     void startSimulation(std::vector<GameObject*>& gameObjects);
     void pauseSimulation(std::vector<GameObject*>& gameObjects);
     void stopSimulation(std::vector<GameObject*>& gameObjects);
-    void update(float deltaTime, std::vector<GameObject*>& gameObjects);
+    void update(float deltaTime);
 
     SimulationState getState() const;
     std::string getStateName(SimulationManager::SimulationState state);
@@ -29,7 +29,7 @@ public:
 
 private:
     std::vector<GameObject*> gameObjects;
-    std::vector<GameObject*> temporaryObjects;
+    std::vector<ObjectID> temporaryObjects;
     SimulationState currentState;
     SceneManager sceneManager; 
 };
@@ -0,0 +1,369 @@
+#include "StaticBatcher.h"
+#include "GameObject.h"
+#include "CullingSystem.h"
+#include "RenderPipeline.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+
+StaticBatcher StaticBatcher::staticBatcher;
+
+namespace {
+    using batchClock = std::chrono::high_resolution_clock;
+
+    const uint64_t SIGNATURE_SEED = 0xcbf29ce484222325ull;
+
+    // FNV-1a over 64 bit words, enough to tell a cell's content changed
+    uint64_t mix(uint64_t hash, uint64_t value) {
+        return (hash ^ value) * 0x100000001b3ull;
+    }
+
+    uint64_t mixMatrix(uint64_t hash, const glm::mat4& matrix) {
+        for (int column = 0; column < 4; column++) {
+            for (int row = 0; row < 4; row++) {
+                uint32_t bits;
+                std::memcpy(&bits, &matrix[column][row], sizeof(bits));
+                hash = mix(hash, bits);
+            }
+        }
+        return hash;
+    }
+}
+
+size_t StaticBatcher::CellKeyHash::operator()(const CellKey& key) const {
+    uint64_t hash = mix(SIGNATURE_SEED, key.texture);
+    hash = mix(hash, static_cast<uint32_t>(key.x));
+    hash = mix(hash, static_cast<uint32_t>(key.y));
+    hash = mix(hash, static_cast<uint32_t>(key.z));
+    return static_cast<size_t>(hash);
+}
+
+void StaticBatcher::update() {
+    for (StaticBatch* batch : visibleBatches) {
+        std::fill(batch->visible.begin(), batch->visible.end(), 0);
+        batch->visibleCount = 0;
+    }
+    visibleBatches.clear();
+    stats.drawnBatches = stats.drawnObjects = stats.ranges = 0;
+
+    if (!enabled) return;
+
+    if (stats.building && buildCounter.isDone()) {
+        finishBuild();
+    }
+    const uint32_t staticVersion = CullingSystem::cullingSystem.getStaticVersion();
+    if (staticVersion != seenVersion) {
+        seenVersion = staticVersion;
+        quietFrames = 0;
+    }
+    else if (quietFrames < SETTLE_FRAMES) {
+        quietFrames++;
+    }
+    // The first grouping doesn't wait
+    const bool settled = quietFrames >= SETTLE_FRAMES || groupedVersion == UINT32_MAX;
+    if ((regroupNeeded || groupedVersion != staticVersion) && settled) {
+        regroup();
+    }
+    if (!stats.building) {
+        startBuild();
+    }
+}
+
+void StaticBatcher::invalidate(Entity entity) {
+    if (entity.index >= editCounts.size()) {
+        editCounts.resize(entity.index + 1, 0);
+    }
+    editCounts[entity.index]++;
+    regroupNeeded = true;
+    quietFrames = 0;
+
+    // Its batch still holds the old geometry, it's drawn on its own until the cell is rebuilt
+    if (editedEntities.empty() || editedEntities.back() != entity) {
+        editedEntities.push_back(entity);
+    }
+    if (entity.index < locations.size() && locations[entity.index].generation == entity.generation) {
+        locations[entity.index].batch = nullptr;
+    }
+}
+
+void StaticBatcher::release() {
+    JobSystem::jobSystem.wait(buildCounter);
+    building.clear();
+
+    for (auto& entry : batches) {
+        deleteBuffers(*entry.second);
+    }
+    batches.clear();
+    cells.clear();
+    locations.clear();
+    visibleBatches.clear();
+    stats = StaticBatchStats();
+    groupedVersion = UINT32_MAX;
+    seenVersion = UINT32_MAX;
+    quietFrames = 0;
+    regroupNeeded = true;
+    editedEntities.clear();
+}
+
+// Sorts the static objects into cells and signs each cell with what its batch is built from
+void StaticBatcher::regroup() {
+    const CullingSystem& culling = CullingSystem::cullingSystem;
+    const std::vector<glm::mat4>& worldMatrices = TransformStore::transformStore.worldMatrices;
+    World& world = World::world;
+
+    cells.clear();
+    for (Entity entity : culling.getStaticEntities()) {
+        const MeshRendererComponent& meshRenderer = world.get<MeshRendererComponent>(entity);
+        if (!meshRenderer.mesh || meshRenderer.mesh->indices.empty()) continue;
+
+        const glm::mat4& matrix = worldMatrices[world.get<TransformComponent>(entity).transformIndex];
+        const BoundsComponent& bounds = world.get<BoundsComponent>(entity);
+        const glm::vec3 center = AABB(bounds.localMin, bounds.localMax).transformed(matrix).center();
+
+        CellKey key;
+        key.texture = meshRenderer.textureID;
+        key.x = static_cast<int>(std::floor(center.x / CELL_SIZE));
+        key.y = static_cast<int>(std::floor(center.y / CELL_SIZE));
+        key.z = static_cast<int>(std::floor(center.z / CELL_SIZE));
+
+        Cell& cell = cells[key];
+        if (cell.objects.empty()) {
+            cell.signature = SIGNATURE_SEED;
+        }
+        cell.objects.push_back(entity);
+
+        uint64_t signature = mix(cell.signature, entity.index);
+        signature = mix(signature, entity.generation);
+        signature = mix(signature, entity.index < editCounts.size() ? editCounts[entity.index] : 0);
+        signature = mix(signature, reinterpret_cast<uintptr_t>(meshRenderer.mesh));
+        signature = mix(signature, meshRenderer.mesh->vertices.size());
+        signature = mix(signature, meshRenderer.mesh->indices.size());
+        cell.signature = mixMatrix(signature, matrix);
+    }
+
+    groupedVersion = culling.getStaticVersion();
+    regroupNeeded = false;
+    editedEntities.clear();
+    mapLocations();
+}
+
+// Batches whose cell is gone are deleted, the ones still matching their cell draw their objects
+void StaticBatcher::mapLocations() {
+    locations.clear();
+    stats.batches = stats.objects = stats.residentBytes = 0;
+
+    for (auto it = batches.begin(); it != batches.end();) {
+        auto cell = cells.find(it->first);
+        if (cell == cells.end()) {
+            deleteBuffers(*it->second);
+            it = batches.erase(it);
+            continue;
+        }
+
+        StaticBatch& batch = *it->second;
+        stats.batches++;
+        stats.residentBytes += batch.bytes;
+        ++it;
+        if (batch.signature != cell->second.signature) continue;
+
+        for (uint32_t slot = 0; slot < batch.objects.size(); slot++) {
+            const Entity entity = batch.objects[slot];
+            if (entity.index >= locations.size()) {
+                locations.resize(entity.index + 1);
+            }
+            locations[entity.index] = { &batch, entity.generation, slot };
+        }
+        stats.objects += batch.objects.size();
+    }
+
+    // Batches uploaded while edits wait to be regrouped were built from the edited objects' old state
+    for (Entity entity : editedEntities) {
+        if (entity.index < locations.size() && locations[entity.index].generation == entity.generation) {
+            locations[entity.index].batch = nullptr;
+        }
+    }
+}
+
+// Copies the geometry of every cell without an up to date batch and merges it on a worker
+void StaticBatcher::startBuild() {
+    World& world = World::world;
+    const std::vector<glm::mat4>& worldMatrices = TransformStore::transformStore.worldMatrices;
+
+    for (const auto& entry : cells) {
+        auto batch = batches.find(entry.first);
+        if (batch != batches.end() && batch->second->signature == entry.second.signature) continue;
+
+        BuildJob job;
+        job.key = entry.first;
+        job.signature = entry.second.signature;
+        job.sources.reserve(entry.second.objects.size());
+        for (Entity entity : entry.second.objects) {
+            const MeshData& mesh = *world.get<MeshRendererComponent>(entity).mesh;
+            ObjectSource source;
+            source.entity = entity;
+            source.world = worldMatrices[world.get<TransformComponent>(entity).transformIndex];
+            source.vertices = mesh.vertices;
+            source.texCoords = mesh.textCoords;
+            source.indices = mesh.indices;
+            job.sources.push_back(std::move(source));
+        }
+        building.push_back(std::move(job));
+    }
+    if (building.empty()) return;
+
+    stats.building = true;
+    JobSystem::jobSystem.run([this]() {
+        const auto start = batchClock::now();
+        for (BuildJob& job : building) {
+            buildGeometry(job);
+        }
+        buildMs = std::chrono::duration<double, std::milli>(batchClock::now() - start).count();
+    }, &buildCounter);
+}
+
+void StaticBatcher::buildGeometry(BuildJob& job) {
+    for (size_t slot = 0; slot < job.sources.size(); slot++) {
+        const ObjectSource& source = job.sources[slot];
+        const uint32_t baseVertex = static_cast<uint32_t>(job.positions.size());
+        const size_t vertexCount = source.vertices.size() / 3;
+        const bool textured = source.texCoords.size() >= vertexCount * 2;
+
+        for (size_t i = 0; i < vertexCount; i++) {
+            const glm::vec4 position(source.vertices[i * 3], source.vertices[i * 3 + 1], source.vertices[i * 3 + 2], 1.0f);
+            job.positions.push_back(glm::vec3(source.world * position));
+            job.texCoords.push_back(textured ? glm::vec2(source.texCoords[i * 2], source.texCoords[i * 2 + 1]) : glm::vec2(0.0f));
+            job.slots.push_back(static_cast<float>(slot));
+        }
+
+        job.firstIndices.push_back(static_cast<GLsizei>(job.indices.size()));
+        job.indexCounts.push_back(static_cast<GLsizei>(source.indices.size()));
+        for (uint32_t index : source.indices) {
+            job.indices.push_back(baseVertex + index);
+        }
+    }
+}
+
+// Main thread: uploads the cells that weren't edited again while their job ran
+void StaticBatcher::finishBuild() {
+    for (BuildJob& job : building) {
+        auto cell = cells.find(job.key);
+        if (cell == cells.end() || cell->second.signature != job.signature) continue;
+
+        std::unique_ptr<StaticBatch>& batch = batches[job.key];
+        if (batch) {
+            deleteBuffers(*batch);
+        }
+        else {
+            batch = std::make_unique<StaticBatch>();
+        }
+        upload(*batch, job);
+        stats.rebuilds++;
+    }
+    building.clear();
+
+    stats.lastBuildMs = buildMs;
+    stats.building = false;
+    mapLocations();
+}
+
+void StaticBatcher::upload(StaticBatch& batch, BuildJob& job) {
+    const size_t positionBytes = job.positions.size() * sizeof(glm::vec3);
+    const size_t texCoordBytes = job.texCoords.size() * sizeof(glm::vec2);
+    const size_t slotBytes = job.slots.size() * sizeof(float);
+    const size_t indexBytes = job.indices.size() * sizeof(uint32_t);
+
+    glGenVertexArrays(1, &batch.vao);
+    glGenBuffers(4, batch.buffers);
+    glBindVertexArray(batch.vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, batch.buffers[0]);
+    glBufferData(GL_ARRAY_BUFFER, positionBytes, job.positions.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(RenderPipeline::POSITION_ATTRIBUTE);
+    glVertexAttribPointer(RenderPipeline::POSITION_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+    glBindBuffer(GL_ARRAY_BUFFER, batch.buffers[1]);
+    glBufferData(GL_ARRAY_BUFFER, texCoordBytes, job.texCoords.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(RenderPipeline::TEXCOORD_ATTRIBUTE);
+    glVertexAttribPointer(RenderPipeline::TEXCOORD_ATTRIBUTE, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+    glBindBuffer(GL_ARRAY_BUFFER, batch.buffers[2]);
+    glBufferData(GL_ARRAY_BUFFER, slotBytes, job.slots.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(RenderPipeline::BATCH_SLOT_ATTRIBUTE);
+    glVertexAttribPointer(RenderPipeline::BATCH_SLOT_ATTRIBUTE, 1, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch.buffers[3]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, job.indices.data(), GL_STATIC_DRAW);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    batch.texture = job.key.texture;
+    batch.signature = job.signature;
+    batch.bytes = positionBytes + texCoordBytes + slotBytes + indexBytes;
+    batch.objects.clear();
+    for (const ObjectSource& source : job.sources) {
+        batch.objects.push_back(source.entity);
+    }
+    batch.indexCounts = std::move(job.indexCounts);
+    batch.firstIndices = std::move(job.firstIndices);
+    batch.visible.assign(batch.objects.size(), 0);
+    batch.visibleCount = 0;
+}
+
+void StaticBatcher::deleteBuffers(StaticBatch& batch) {
+    glDeleteVertexArrays(1, &batch.vao);
+    glDeleteBuffers(4, batch.buffers);
+    batch.vao = 0;
+    std::fill(std::begin(batch.buffers), std::end(batch.buffers), 0u);
+}
+
+bool StaticBatcher::markVisible(Entity entity) {
+    if (entity.index >= locations.size()) return false;
+    const Location& location = locations[entity.index];
+    if (!location.batch || location.generation != entity.generation) return false;
+
+    StaticBatch& batch = *location.batch;
+    if (batch.visibleCount == 0) {
+        visibleBatches.push_back(&batch);
+    }
+    if (!batch.visible[location.slot]) {
+        batch.visible[location.slot] = 1;
+        batch.visibleCount++;
+    }
+    return true;
+}
+
+bool StaticBatcher::isBatched(Entity entity) const {
+    if (entity.index >= locations.size()) return false;
+    const Location& location = locations[entity.index];
+    return location.batch && location.generation == entity.generation;
+}
+
+void StaticBatcher::draw(const StaticBatch& batch) {
+    // Neighbouring slots have contiguous indices, a run of visible ones is a single range
+    drawCounts.clear();
+    drawOffsets.clear();
+    const size_t count = batch.objects.size();
+    for (size_t slot = 0; slot < count;) {
+        if (!batch.visible[slot]) {
+            slot++;
+            continue;
+        }
+        const size_t firstIndex = batch.firstIndices[slot];
+        GLsizei indexCount = 0;
+        while (slot < count && batch.visible[slot]) {
+            indexCount += batch.indexCounts[slot++];
+        }
+        drawCounts.push_back(indexCount);
+        drawOffsets.push_back(reinterpret_cast<const void*>(firstIndex * sizeof(uint32_t)));
+    }
+
+    RenderPipeline::renderPipeline.drawRanges(batch.firstRecord, batch.vao, drawCounts.data(), drawOffsets.data(),
+        static_cast<GLsizei>(drawCounts.size()), batch.visibleCount);
+    stats.drawnBatches++;
+    stats.drawnObjects += batch.visibleCount;
+    stats.ranges += drawCounts.size();
+}
@@ -0,0 +1,154 @@
+#ifndef STATICBATCHER_H
+#define STATICBATCHER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "ECS.h"
+#include "JobSystem.h"
+
+struct StaticBatchStats {
+    size_t batches = 0;             // Merged buffers on the GPU
+    size_t objects = 0;             // Static objects they hold
+    size_t residentBytes = 0;
+    size_t drawnBatches = 0;        // Batches with a visible object this frame
+    size_t drawnObjects = 0;
+    size_t ranges = 0;              // Index ranges submitted, neighbours merged
+    size_t rebuilds = 0;            // Batches built since startup
+    double lastBuildMs = 0.0;       // Worker time of the last rebuild
+    bool building = false;
+};
+
+// Static objects of one texture and one cell, their geometry already in world space
+struct StaticBatch {
+    GLuint texture = 0;
+    GLuint vao = 0;
+    GLuint buffers[4] = {};         // Positions, texture coordinates, slots, indices
+    size_t bytes = 0;
+    uint64_t signature = 0;
+
+    // By slot, which is also the order of their records
+    std::vector<Entity> objects;
+    std::vector<GLsizei> indexCounts;
+    std::vector<GLsizei> firstIndices;
+
+    // This frame
+    std::vector<uint8_t> visible;
+    size_t visibleCount = 0;
+    GLint firstRecord = 0;
+};
+
+// Merges the static objects, the culling octree's set, into shared vertex and index buffers grouped by
+// texture and by a coarse grid cell, with the world matrices baked in. Every vertex also carries the
+// object's slot in its batch, so the shaders find each object's own record for tint and picking ID,
+// and each object keeps its own index range: culling and selection still work per object, and a batch
+// draws only its visible ranges in one glMultiDrawElements.
+// Cells are compared by a signature over their objects, meshes, textures and matrices; only the ones that
+// changed are rebuilt, by a job on a worker, once the static set has gone SETTLE_FRAMES frames without an
+// edit, so dragging a static object rebuilds its cell once at the end. Until its new batch is uploaded an
+// edited object has no batch and is drawn on its own.
+class StaticBatcher {
+public:
+    static StaticBatcher staticBatcher;
+
+    // Grid cell edge, in world units, objects go to the cell of their world box's center
+    static constexpr float CELL_SIZE = 32.0f;
+    // Frames without static edits before the cells are regrouped
+    static const int SETTLE_FRAMES = 10;
+
+    // Clears last frame's visibility, uploads finished builds, regroups when the static set changed and
+    // starts the next build. Main thread, after the culling system gathered its bounds.
+    void update();
+    // Mesh or texture edits the static set doesn't see, the object's cell is rebuilt
+    void invalidate(Entity entity);
+    // Waits for a running build and deletes the buffers, the GL context must still be current
+    void release();
+
+    // True when a batch draws the entity, which then counts as visible this frame
+    bool markVisible(Entity entity);
+    bool isBatched(Entity entity) const;
+    const std::vector<StaticBatch*>& getVisibleBatches() const { return visibleBatches; }
+    // The batch's visible objects, starting at its first record
+    void draw(const StaticBatch& batch);
+
+    const StaticBatchStats& getStats() const { return stats; }
+
+    bool enabled = true;
+
+private:
+    struct CellKey {
+        GLuint texture = 0;
+        int x = 0, y = 0, z = 0;
+        bool operator==(const CellKey& other) const { return texture == other.texture && x == other.x && y == other.y && z == other.z; }
+    };
+    struct CellKeyHash {
+        size_t operator()(const CellKey& key) const;
+    };
+
+    struct Cell {
+        std::vector<Entity> objects;
+        uint64_t signature = 0;
+    };
+
+    struct Location {
+        StaticBatch* batch = nullptr;
+        uint32_t generation = 0;
+        uint32_t slot = 0;
+    };
+
+    // Copies taken on the main thread, the worker reads nothing else
+    struct ObjectSource {
+        Entity entity;
+        glm::mat4 world;
+        std::vector<float> vertices;
+        std::vector<float> texCoords;
+        std::vector<uint32_t> indices;
+    };
+    struct BuildJob {
+        CellKey key;
+        uint64_t signature = 0;
+        std::vector<ObjectSource> sources;
+
+        // Filled by the worker
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec2> texCoords;
+        std::vector<float> slots;
+        std::vector<uint32_t> indices;
+        std::vector<GLsizei> indexCounts;
+        std::vector<GLsizei> firstIndices;
+    };
+
+    std::unordered_map<CellKey, Cell, CellKeyHash> cells;
+    std::unordered_map<CellKey, std::unique_ptr<StaticBatch>, CellKeyHash> batches;
+    std::vector<Location> locations;
+    std::vector<uint32_t> editCounts;       // By entity index, bumped by invalidate()
+    std::vector<Entity> editedEntities;     // Since the last regroup, kept out of their old batches
+    std::vector<StaticBatch*> visibleBatches;
+
+    std::vector<BuildJob> building;
+    JobCounter buildCounter;
+    double buildMs = 0.0;
+    uint32_t groupedVersion = UINT32_MAX;
+    uint32_t seenVersion = UINT32_MAX;
+    int quietFrames = 0;
+    bool regroupNeeded = true;
+
+    std::vector<GLsizei> drawCounts;
+    std::vector<const void*> drawOffsets;
+
+    StaticBatchStats stats;
+
+    void regroup();
+    void startBuild();
+    void finishBuild();
+    void upload(StaticBatch& batch, BuildJob& job);
+    void deleteBuffers(StaticBatch& batch);
+    void mapLocations();
+    static void buildGeometry(BuildJob& job);
+};
+
+#endif // STATICBATCHER_H
@@ -0,0 +1,213 @@
+#include "TransformKernels.h"
+#include <cstddef>
+
+static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "The kernels expect tightly packed vec3");
+static_assert(sizeof(glm::quat) == 4 * sizeof(float), "The kernels expect tightly packed quat");
+static_assert(sizeof(glm::mat4) == 16 * sizeof(float), "The kernels expect tightly packed mat4");
+
+// Memory order of the quaternion components, taken from glm itself: glm 1.0 stores w first unless
+// GLM_FORCE_QUAT_DATA_XYZW is defined, older versions store it last
+constexpr size_t QUAT_X = offsetof(glm::quat, x) / sizeof(float);
+constexpr size_t QUAT_Y = offsetof(glm::quat, y) / sizeof(float);
+constexpr size_t QUAT_Z = offsetof(glm::quat, z) / sizeof(float);
+constexpr size_t QUAT_W = offsetof(glm::quat, w) / sizeof(float);
+
+TransformKernels::Backend TransformKernels::activeBackend = CpuFeatures::bestBackend();
+
+namespace {
+    void composeScalar(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales, glm::mat4* out, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const glm::quat& q = rotations[i];
+            const float x = q.x, y = q.y, z = q.z, w = q.w;
+            const glm::vec3& s = scales[i];
+            glm::mat4& m = out[i];
+
+            m[0] = glm::vec4((1.0f - 2.0f * (y * y + z * z)) * s.x, 2.0f * (x * y + w * z) * s.x, 2.0f * (x * z - w * y) * s.x, 0.0f);
+            m[1] = glm::vec4(2.0f * (x * y - w * z) * s.y, (1.0f - 2.0f * (x * x + z * z)) * s.y, 2.0f * (y * z + w * x) * s.y, 0.0f);
+            m[2] = glm::vec4(2.0f * (x * z + w * y) * s.z, 2.0f * (y * z - w * x) * s.z, (1.0f - 2.0f * (x * x + y * y)) * s.z, 0.0f);
+            m[3] = glm::vec4(positions[i], 1.0f);
+        }
+    }
+
+#ifdef CPU_FEATURES_X86
+    // Four packed vec3 (48 bytes) into one register per component
+    inline void loadVec3x4(const glm::vec3* source, __m128& x, __m128& y, __m128& z) {
+        const float* p = reinterpret_cast<const float*>(source);
+        const __m128 a = _mm_loadu_ps(p);       // x0 y0 z0 x1
+        const __m128 b = _mm_loadu_ps(p + 4);   // y1 z1 x2 y2
+        const __m128 c = _mm_loadu_ps(p + 8);   // z2 x3 y3 z3
+
+        x = _mm_shuffle_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 0, 0)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0));
+        y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+        z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+    }
+
+    // Writes one column of four matrices from its four component registers
+    inline void storeColumnx4(glm::mat4* out, int column, __m128 x, __m128 y, __m128 z, __m128 w) {
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        _mm_storeu_ps(&out[0][column][0], x);
+        _mm_storeu_ps(&out[1][column][0], y);
+        _mm_storeu_ps(&out[2][column][0], z);
+        _mm_storeu_ps(&out[3][column][0], w);
+    }
+
+    void composeSSE(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales, glm::mat4* out, size_t count) {
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 two = _mm_set1_ps(2.0f);
+        const __m128 zero = _mm_setzero_ps();
+
+        for (size_t i = 0; i < count; i += 4) {
+            __m128 q[4];
+            q[0] = _mm_loadu_ps(reinterpret_cast<const float*>(&rotations[i]));
+            q[1] = _mm_loadu_ps(reinterpret_cast<const float*>(&rotations[i + 1]));
+            q[2] = _mm_loadu_ps(reinterpret_cast<const float*>(&rotations[i + 2]));
+            q[3] = _mm_loadu_ps(reinterpret_cast<const float*>(&rotations[i + 3]));
+            _MM_TRANSPOSE4_PS(q[0], q[1], q[2], q[3]);
+            const __m128 x = q[QUAT_X], y = q[QUAT_Y], z = q[QUAT_Z], w = q[QUAT_W];
+
+            __m128 px, py, pz, sx, sy, sz;
+            loadVec3x4(&positions[i], px, py, pz);
+            loadVec3x4(&scales[i], sx, sy, sz);
+
+            const __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+            const __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+            const __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+            const __m128 m00 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+            const __m128 m01 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+            const __m128 m02 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+
+            const __m128 m10 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+            const __m128 m11 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+            const __m128 m12 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+
+            const __m128 m20 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+            const __m128 m21 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+            const __m128 m22 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+
+            storeColumnx4(&out[i], 0, m00, m01, m02, zero);
+            storeColumnx4(&out[i], 1, m10, m11, m12, zero);
+            storeColumnx4(&out[i], 2, m20, m21, m22, zero);
+            storeColumnx4(&out[i], 3, px, py, pz, one);
+        }
+    }
+
+    // Writes one column of eight matrices, each 128-bit half is transposed independently
+    TARGET_AVX2 inline void storeColumnx8(glm::mat4* out, int column, __m256 x, __m256 y, __m256 z, __m256 w) {
+        const __m256 t0 = _mm256_unpacklo_ps(x, y);
+        const __m256 t1 = _mm256_unpackhi_ps(x, y);
+        const __m256 t2 = _mm256_unpacklo_ps(z, w);
+        const __m256 t3 = _mm256_unpackhi_ps(z, w);
+
+        const __m256 c0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+        const __m256 c1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+        const __m256 c2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+        const __m256 c3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+
+        _mm_storeu_ps(&out[0][column][0], _mm256_castps256_ps128(c0));
+        _mm_storeu_ps(&out[1][column][0], _mm256_castps256_ps128(c1));
+        _mm_storeu_ps(&out[2][column][0], _mm256_castps256_ps128(c2));
+        _mm_storeu_ps(&out[3][column][0], _mm256_castps256_ps128(c3));
+        _mm_storeu_ps(&out[4][column][0], _mm256_extractf128_ps(c0, 1));
+        _mm_storeu_ps(&out[5][column][0], _mm256_extractf128_ps(c1, 1));
+        _mm_storeu_ps(&out[6][column][0], _mm256_extractf128_ps(c2, 1));
+        _mm_storeu_ps(&out[7][column][0], _mm256_extractf128_ps(c3, 1));
+    }
+
+    TARGET_AVX2 void composeAVX2(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales, glm::mat4* out, size_t count) {
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 two = _mm256_set1_ps(2.0f);
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256i vec3Stride = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+        const __m256i quatStride = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+
+        for (size_t i = 0; i < count; i += 8) {
+            const float* q = reinterpret_cast<const float*>(&rotations[i]);
+            const float* p = reinterpret_cast<const float*>(&positions[i]);
+            const float* s = reinterpret_cast<const float*>(&scales[i]);
+
+            const __m256 x = _mm256_i32gather_ps(q + QUAT_X, quatStride, 4);
+            const __m256 y = _mm256_i32gather_ps(q + QUAT_Y, quatStride, 4);
+            const __m256 z = _mm256_i32gather_ps(q + QUAT_Z, quatStride, 4);
+            const __m256 w = _mm256_i32gather_ps(q + QUAT_W, quatStride, 4);
+
+            const __m256 px = _mm256_i32gather_ps(p, vec3Stride, 4);
+            const __m256 py = _mm256_i32gather_ps(p + 1, vec3Stride, 4);
+            const __m256 pz = _mm256_i32gather_ps(p + 2, vec3Stride, 4);
+            const __m256 sx = _mm256_i32gather_ps(s, vec3Stride, 4);
+            const __m256 sy = _mm256_i32gather_ps(s + 1, vec3Stride, 4);
+            const __m256 sz = _mm256_i32gather_ps(s + 2, vec3Stride, 4);
+
+            const __m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+            const __m256 xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+            const __m256 wx = _mm256_mul_ps(w, x), wy = _mm256_mul_ps(w, y), wz = _mm256_mul_ps(w, z);
+
+            const __m256 m00 = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))), sx);
+            const __m256 m01 = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx);
+            const __m256 m02 = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx);
+
+            const __m256 m10 = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy);
+            const __m256 m11 = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))), sy);
+            const __m256 m12 = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy);
+
+            const __m256 m20 = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz);
+            const __m256 m21 = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz);
+            const __m256 m22 = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))), sz);
+
+            storeColumnx8(&out[i], 0, m00, m01, m02, zero);
+            storeColumnx8(&out[i], 1, m10, m11, m12, zero);
+            storeColumnx8(&out[i], 2, m20, m21, m22, zero);
+            storeColumnx8(&out[i], 3, px, py, pz, one);
+        }
+    }
+#endif
+}
+
+TransformKernels::Backend TransformKernels::getBackend() {
+    return activeBackend;
+}
+
+void TransformKernels::setBackend(Backend backend) {
+    activeBackend = CpuFeatures::isSupported(backend) ? backend : CpuFeatures::bestBackend();
+}
+
+void TransformKernels::composeTRS(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales, glm::mat4* out, size_t count) {
+    size_t done = 0;
+
+#ifdef CPU_FEATURES_X86
+    if (activeBackend == Backend::AVX2) {
+        done = count & ~size_t(7);
+        composeAVX2(positions, rotations, scales, out, done);
+    }
+    else if (activeBackend == Backend::SSE) {
+        done = count & ~size_t(3);
+        composeSSE(positions, rotations, scales, out, done);
+    }
+#endif
+
+    // Whatever doesn't fill a whole batch
+    composeScalar(positions, rotations, scales, out, done, count);
+}
+
+void TransformKernels::multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& out) {
+#ifdef CPU_FEATURES_X86
+    const __m128 a0 = _mm_loadu_ps(&a[0][0]);
+    const __m128 a1 = _mm_loadu_ps(&a[1][0]);
+    const __m128 a2 = _mm_loadu_ps(&a[2][0]);
+    const __m128 a3 = _mm_loadu_ps(&a[3][0]);
+
+    // Every column of the result is a combination of the columns of a
+    for (int column = 0; column < 4; ++column) {
+        const __m128 b0 = _mm_set1_ps(b[column][0]);
+        const __m128 b1 = _mm_set1_ps(b[column][1]);
+        const __m128 b2 = _mm_set1_ps(b[column][2]);
+        const __m128 b3 = _mm_set1_ps(b[column][3]);
+
+        const __m128 result = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, b0), _mm_mul_ps(a1, b1)),
+            _mm_add_ps(_mm_mul_ps(a2, b2), _mm_mul_ps(a3, b3)));
+        _mm_storeu_ps(&out[column][0], result);
+    }
+#else
+    out = a * b;
+#endif
+}
@@ -0,0 +1,29 @@
+#ifndef TRANSFORMKERNELS_H
+#define TRANSFORMKERNELS_H
+
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "CpuFeatures.h"
+
+// Batched matrix math for the TransformStore.
+// The SIMD paths build 4 (SSE) or 8 (AVX2) matrices per iteration, the best one is picked at startup.
+class TransformKernels {
+public:
+    using Backend = SimdBackend;
+
+    static Backend getBackend();
+    // Every later composeTRS() uses this path, CpuFeatures decides what the processor supports
+    static void setBackend(Backend backend);
+
+    // out[i] = translate(positions[i]) * mat4_cast(rotations[i]) * scale(scales[i])
+    static void composeTRS(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales, glm::mat4* out, size_t count);
+
+    // out = a * b, out may not alias a or b
+    static void multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& out);
+
+private:
+    static Backend activeBackend;
+};
+
+#endif // TRANSFORMKERNELS_H
@@ -0,0 +1,239 @@
+#include "TransformStore.h"
+#include "Components.h"
+#include "TransformKernels.h"
+#include "JobSystem.h"
+#include "ConsoleWindow.h"
+#include <algorithm>
+#include <cmath>
+
+TransformStore TransformStore::transformStore;
+
+int TransformStore::add(Entity owner) {
+    int index = static_cast<int>(positions.size());
+
+    positions.push_back(glm::vec3(0.0f));
+    rotations.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+    scales.push_back(glm::vec3(1.0f));
+    localMatrices.push_back(glm::mat4(1.0f));
+    worldMatrices.push_back(glm::mat4(1.0f));
+    parents.push_back(-1);
+    owners.push_back(owner);
+
+    return index;
+}
+
+// Slots are only flagged here, they get compacted on the next sort so the indices
+// held by other objects stay valid until then
+void TransformStore::remove(int index) {
+    if (index < 0 || index >= static_cast<int>(parents.size()) || parents[index] == REMOVED) {
+        return;
+    }
+    parents[index] = REMOVED;
+    owners[index] = Entity();
+    removedCount++;
+    orderDirty = true;
+}
+
+void TransformStore::clear() {
+    positions.clear();
+    rotations.clear();
+    scales.clear();
+    localMatrices.clear();
+    worldMatrices.clear();
+    parents.clear();
+    owners.clear();
+    removedCount = 0;
+    orderDirty = false;
+    layoutVersion++;
+}
+
+void TransformStore::setParent(int index, int parentIndex) {
+    if (parents[index] == parentIndex) {
+        return;
+    }
+    parents[index] = parentIndex;
+
+    // A child placed before its parent breaks the single sweep, so the arrays must be reordered
+    if (parentIndex > index) {
+        orderDirty = true;
+    }
+}
+
+void TransformStore::setLocal(int index, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) {
+    positions[index] = position;
+    rotations[index] = rotation;
+    scales[index] = scale;
+}
+
+void TransformStore::sortHierarchy() {
+    const int count = static_cast<int>(parents.size());
+
+    // Depth of every live node (-1 = not computed yet, -2 = being visited)
+    std::vector<int> depth(count, -1);
+    std::vector<int> chain;
+    int maxDepth = 0;
+
+    for (int i = 0; i < count; ++i) {
+        if (parents[i] == REMOVED || depth[i] >= 0) continue;
+
+        chain.clear();
+        int node = i;
+        while (node >= 0 && depth[node] == -1) {
+            // Children of a removed node become roots
+            if (parents[node] >= 0 && parents[parents[node]] == REMOVED) {
+                parents[node] = -1;
+            }
+            depth[node] = -2;
+            chain.push_back(node);
+            node = parents[node];
+        }
+
+        int base = 0;
+        if (node >= 0 && depth[node] >= 0) {
+            base = depth[node] + 1;
+        }
+        else if (node >= 0) {
+            // The walk came back to a node of this chain: break the cycle by making it a root
+            console.addLog("Warning: cyclic parenting found in transform hierarchy");
+            parents[node] = -1;
+            for (int visited : chain) depth[visited] = -1;
+            --i;
+            continue;
+        }
+
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+            depth[*it] = (parents[*it] < 0) ? 0 : base++;
+            if (parents[*it] < 0) base = 1;
+            maxDepth = std::max(maxDepth, depth[*it]);
+        }
+    }
+
+    // Stable counting sort by depth keeps siblings in their original order
+    std::vector<int> offsets(maxDepth + 2, 0);
+    for (int i = 0; i < count; ++i) {
+        if (parents[i] != REMOVED) offsets[depth[i] + 1]++;
+    }
+    for (size_t d = 1; d < offsets.size(); ++d) {
+        offsets[d] += offsets[d - 1];
+    }
+
+    std::vector<int> remap(count, -1);
+    std::vector<int> order(count - removedCount);
+    for (int i = 0; i < count; ++i) {
+        if (parents[i] == REMOVED) continue;
+        int newIndex = offsets[depth[i]]++;
+        remap[i] = newIndex;
+        order[newIndex] = i;
+    }
+
+    const size_t liveCount = order.size();
+    std::vector<glm::vec3> newPositions(liveCount);
+    std::vector<glm::quat> newRotations(liveCount);
+    std::vector<glm::vec3> newScales(liveCount);
+    std::vector<glm::mat4> newLocal(liveCount);
+    std::vector<glm::mat4> newWorld(liveCount);
+    std::vector<int> newParents(liveCount);
+    std::vector<Entity> newOwners(liveCount);
+
+    for (size_t n = 0; n < liveCount; ++n) {
+        int old = order[n];
+        newPositions[n] = positions[old];
+        newRotations[n] = rotations[old];
+        newScales[n] = scales[old];
+        newLocal[n] = localMatrices[old];
+        newWorld[n] = worldMatrices[old];
+        newParents[n] = parents[old] < 0 ? -1 : remap[parents[old]];
+        newOwners[n] = owners[old];
+
+        if (TransformComponent* transform = World::world.tryGet<TransformComponent>(newOwners[n])) {
+            transform->transformIndex = static_cast<int>(n);
+        }
+    }
+
+    positions.swap(newPositions);
+    rotations.swap(newRotations);
+    scales.swap(newScales);
+    localMatrices.swap(newLocal);
+    worldMatrices.swap(newWorld);
+    parents.swap(newParents);
+    owners.swap(newOwners);
+
+    removedCount = 0;
+    orderDirty = false;
+    layoutVersion++;
+}
+
+void TransformStore::updateWorldMatrices() {
+    if (orderDirty) {
+        sortHierarchy();
+    }
+
+    // Local matrices have no dependencies between nodes, so they are built in SIMD batches first,
+    // spread over the job system for big scenes
+    const size_t count = positions.size();
+    JobSystem::jobSystem.parallelFor(count, 4096, [this](size_t begin, size_t end) {
+        TransformKernels::composeTRS(&positions[begin], &rotations[begin], &scales[begin], &localMatrices[begin], end - begin);
+    });
+
+    for (size_t i = 0; i < count; ++i) {
+        const int parent = parents[i];
+        if (parent < 0) {
+            worldMatrices[i] = localMatrices[i];
+        }
+        else {
+            TransformKernels::multiply(worldMatrices[parent], localMatrices[i], worldMatrices[i]);
+        }
+    }
+}
+
+// Same result as translate * rotate * scale, without the intermediate matrix products
+glm::mat4 TransformStore::composeTRS(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) {
+    glm::mat4 matrix;
+    TransformKernels::composeTRS(&position, &rotation, &scale, &matrix, 1);
+    return matrix;
+}
+
+void TransformStore::decompose(const glm::mat4& matrix, glm::vec3& position, glm::quat& rotation, glm::vec3& scale) {
+    position = glm::vec3(matrix[3]);
+
+    glm::vec3 axisX(matrix[0]);
+    glm::vec3 axisY(matrix[1]);
+    glm::vec3 axisZ(matrix[2]);
+    scale = glm::vec3(glm::length(axisX), glm::length(axisY), glm::length(axisZ));
+
+    // A mirrored basis is stored as a negative scale on X
+    if (glm::dot(glm::cross(axisX, axisY), axisZ) < 0.0f) {
+        scale.x = -scale.x;
+    }
+
+    glm::mat3 rotationMatrix(
+        scale.x != 0.0f ? axisX / scale.x : glm::vec3(1.0f, 0.0f, 0.0f),
+        scale.y != 0.0f ? axisY / scale.y : glm::vec3(0.0f, 1.0f, 0.0f),
+        scale.z != 0.0f ? axisZ / scale.z : glm::vec3(0.0f, 0.0f, 1.0f));
+    rotation = glm::normalize(glm::quat_cast(rotationMatrix));
+}
+
+glm::quat TransformStore::eulerToQuat(const glm::vec3& degrees) {
+    return glm::angleAxis(glm::radians(degrees.x), glm::vec3(1.0f, 0.0f, 0.0f)) *
+        glm::angleAxis(glm::radians(degrees.y), glm::vec3(0.0f, 1.0f, 0.0f)) *
+        glm::angleAxis(glm::radians(degrees.z), glm::vec3(0.0f, 0.0f, 1.0f));
+}
+
+// Inverse of eulerToQuat, for a rotation built as Rx * Ry * Rz
+glm::vec3 TransformStore::quatToEuler(const glm::quat& rotation) {
+    glm::mat3 m = glm::mat3_cast(rotation);
+    float sinY = glm::clamp(m[2][0], -1.0f, 1.0f);
+
+    glm::vec3 radians;
+    radians.y = asinf(sinY);
+    if (fabsf(sinY) < 0.9999f) {
+        radians.x = atan2f(-m[2][1], m[2][2]);
+        radians.z = atan2f(-m[1][0], m[0][0]);
+    }
+    else {
+        // Gimbal lock: X and Z rotate around the same axis, keep it all in X
+        radians.x = atan2f(m[1][2], m[1][1]);
+        radians.z = 0.0f;
+    }
+    return glm::degrees(radians);
+}
@@ -0,0 +1,60 @@
+#ifndef TRANSFORMSTORE_H
+#define TRANSFORMSTORE_H
+
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "ECS.h"
+
+// Data-oriented storage for every transform in the scene.
+// Each attribute lives in its own contiguous array, and nodes are kept sorted so a parent
+// always precedes its children: world matrices are then resolved in a single linear sweep.
+class TransformStore {
+public:
+    static TransformStore transformStore;
+
+    int add(Entity owner = Entity());
+    void remove(int index);
+    void clear();
+
+    void setParent(int index, int parentIndex);
+    void setLocal(int index, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+
+    // Reorders the arrays so parents precede children (also drops removed slots)
+    void sortHierarchy();
+    void updateWorldMatrices();
+
+    size_t size() const { return positions.size(); }
+    bool isSorted() const { return !orderDirty; }
+    // Changes whenever nodes move to other indices, cached transform indices must be refreshed
+    uint32_t getLayoutVersion() const { return layoutVersion; }
+
+    static glm::mat4 composeTRS(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+    static void decompose(const glm::mat4& matrix, glm::vec3& position, glm::quat& rotation, glm::vec3& scale);
+
+    // Euler angles are in degrees and applied X, then Y, then Z (same as the Inspector)
+    static glm::quat eulerToQuat(const glm::vec3& degrees);
+    static glm::vec3 quatToEuler(const glm::quat& rotation);
+
+    // Local transform of each node, relative to its parent
+    std::vector<glm::vec3> positions;
+    std::vector<glm::quat> rotations;
+    std::vector<glm::vec3> scales;
+
+    std::vector<glm::mat4> localMatrices;
+    std::vector<glm::mat4> worldMatrices;
+
+    // Index of the parent node, -1 for roots and REMOVED for free slots
+    std::vector<int> parents;
+    // Entity owning each node, its TransformComponent is updated when the arrays are reordered
+    std::vector<Entity> owners;
+
+    static const int REMOVED = -2;
+
+private:
+    bool orderDirty = false;
+    size_t removedCount = 0;
+    uint32_t layoutVersion = 0;
+};
+
+#endif // TRANSFORMSTORE_H
@@ -1,6 +1,8 @@
 #include <iostream>
 #include <filesystem>
+#if defined(_WIN32)
 #include <windows.h>
+#endif
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_events.h>
 #include <glm/glm.hpp>
@@ -24,6 +26,15 @@
 #include "Variables.h"
 #include "ConsoleWindow.h"
 #include "SimulationManager.h"
+#include "JobSystem.h"
+#include "OcclusionQueries.h"
+#include "PickingBuffer.h"
+#include "GpuMesh.h"
+#include "RenderPipeline.h"
+#include "StaticBatcher.h"
+#include "IndirectRenderer.h"
+#include "DebugDraw.h"
+#include "HeadlessBenchmark.h"
 
 #define CHECKERS_WIDTH 64
 #define CHECKERS_HEIGHT 64
@@ -39,12 +50,16 @@ extern Renderer renderer;
 std::vector<MeshData> meshes;
 GLuint textureID;
 extern Importer importer;
-extern std::vector<GameObject> gameObjects;
 const char* fbxFile = nullptr;
 
 #undef main
 int main(int argc, char** argv) {
 
+	// Offscreen benchmark, no window and no ImGui
+	if (HeadlessBenchmark::requested(argc, argv)) {
+		return HeadlessBenchmark::headlessBenchmark.run(argc, argv);
+	}
+
 	variables = new Variables;
 
 	console.addLog("Initializing SDL...");
@@ -60,6 +75,11 @@ int main(int argc, char** argv) {
 	iluInit();
 	console.addLog("DevIL initialized with success");
 
+	JobSystem::jobSystem.init();
+	console.addLog("Job system started with " + std::to_string(JobSystem::jobSystem.getThreadCount()) + " threads");
+
+	importer.processAssetsToLibrary();
+
 	std::string texturePath = "Library\\Textures\\streetEnv.texdat";
 
 	if (std::filesystem::exists(texturePath)) {
@@ -76,14 +96,14 @@ int main(int argc, char** argv) {
 
 	for (size_t i = 0; i < meshes.size(); ++i) {
 		std::string objectName = renderer.getFileName("Library\\Models\\streetEnv.dat") + "_" + std::to_string(i);
-		auto casa = new GameObject(objectName, meshes[i], textureID, texturePath);
+		auto casa = GameObjectPool::pool.create(objectName, meshes[i], textureID, texturePath);
 		casa->BoundingBoxGeneration();
 		variables->window->gameObjects.push_back(casa);
 	}
 	auto previousTime = hrclock::now();
 
 	// Main loop: handling events, rendering and maintaining FPS
-	while (renderer.processEvents(camera, gameObjects, fbxFile)) {
+	while (renderer.processEvents(camera, variables->window->gameObjects, fbxFile)) {
 		const auto currentTime = hrclock::now();
 		float deltaTime = std::chrono::duration<float>(currentTime - previousTime).count();
 		previousTime = currentTime;
@@ -94,11 +114,14 @@ int main(int argc, char** argv) {
 
 		variables->window->createDockSpace();
 
+		// GL work queued by jobs during the last frame
+		JobSystem::jobSystem.pumpMainThread();
+
 		if (SimulationManager::simulationManager.getState() == SimulationManager::SimulationState::Running) {
-			SimulationManager::simulationManager.update(deltaTime, variables->window->gameObjects);
+			SimulationManager::simulationManager.update(deltaTime);
 		}
 
-		renderer.render(variables->window->gameObjects);
+		renderer.render();
 
 		ImGui::Render();
 		ImGui::UpdatePlatformWindows();
@@ -106,16 +129,29 @@ int main(int argc, char** argv) {
 
 		variables->window->swapBuffers();
 
+		// Objects destroyed during the frame are released once nothing is drawing them anymore
+		if (GameObjectPool::pool.flush() > 0) {
+			variables->window->pruneSelection();
+		}
+
 		const auto frameEnd = hrclock::now();
 		const auto dt = frameEnd - currentTime;
 		if (dt < FRAME_DT) std::this_thread::sleep_for(FRAME_DT - dt);
 	}
 
-	for (const auto& obj : gameObjects) {
-		console.addLog("Objeto en la escena: " + obj.getName());
+	for (const GameObject* obj : variables->window->gameObjects) {
+		console.addLog("Objeto en la escena: " + obj->getName());
 	}
 
 	renderer.cleanupFrameBuffer();
+	PickingBuffer::pickingBuffer.release();
+	OcclusionQueries::occlusionQueries.releaseQueries();
+	StaticBatcher::staticBatcher.release();
+	GpuMesh::releaseAll();
+	IndirectRenderer::indirectRenderer.release();
+	DebugDraw::debugDraw.release();
+	RenderPipeline::renderPipeline.release();
+	JobSystem::jobSystem.shutdown();
 
 	return 0;
 }
\ No newline at end of file